@@ -0,0 +1,387 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+// Header-only reader of the raw data shared memory region, for processes outside the engine
+// (C++11, add USemLog/Source/SemLog/Public to the include paths; link with -lrt on older glibc)
+#include "SLRawDataSharedMemoryLayout.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+* Entity of the shared memory entity table
+*/
+struct FSLRawDataSharedMemoryEntity
+{
+	// Index used by the poses
+	int32_t EntityIndex = -1;
+
+	// Latest pose table entry of the entity, followed by the entries of its bones (NoPoseEntry if none)
+	uint32_t FirstPoseEntry = FSLRawDataSharedMemory::NoPoseEntry;
+
+	// Unique name (Class_Id)
+	std::string Name;
+
+	// Names of the bones, indexed by the pose BoneIndex
+	std::vector<std::string> BoneNames;
+};
+
+/**
+* View of a frame inside the region (no copy), only valid if EndRead succeeds after using it
+*/
+struct FSLRawDataSharedMemoryFrameView
+{
+	// Frame number
+	uint64_t FrameNumber = 0;
+
+	// Timestamp of the frame
+	double Timestamp = 0.0;
+
+	// Keyframe and truncation flags
+	uint32_t Flags = 0;
+
+	// Poses inside the region
+	const FSLRawDataSharedMemoryPose* Poses = nullptr;
+
+	// Number of poses
+	uint32_t NumPoses = 0;
+
+	// Slot of the frame
+	const FSLRawDataSharedMemorySlot* Slot = nullptr;
+};
+
+/**
+* Copy of a frame
+*/
+struct FSLRawDataSharedMemoryFrame
+{
+	// Frame number
+	uint64_t FrameNumber = 0;
+
+	// Timestamp of the frame
+	double Timestamp = 0.0;
+
+	// Keyframe and truncation flags
+	uint32_t Flags = 0;
+
+	// Poses
+	std::vector<FSLRawDataSharedMemoryPose> Poses;
+};
+
+/**
+* Latest pose of an entity or bone, with the frame which last changed it
+*/
+struct FSLRawDataSharedMemoryLatestPose
+{
+	// Frame which last changed the pose
+	uint64_t FrameNumber = 0;
+
+	// Timestamp of the frame
+	double Timestamp = 0.0;
+
+	// Pose
+	FSLRawDataSharedMemoryPose Pose;
+};
+
+/**
+* Maps the region read-only and reads the latest poses and the frames under their sequence locks, e.g.:
+*	FSLRawDataSharedMemoryReader Reader;
+*	Reader.Open("SLRawData");
+*	uint64_t Next = Reader.GetNumFrames();
+*	Reader.UpdateEntities();
+*	..read the scene with ReadLatestPose, the frames from Next on only hold the changes..
+*	FSLRawDataSharedMemoryFrameView View;
+*	while (Reader.IsWriterActive()) {
+*		Reader.UpdateEntities();
+*		if (Reader.BeginRead(Next, View)) { ..use View.. if (Reader.EndRead(View)) { ..keep the results.. } Next++; }
+*		else if (Reader.IsOverwritten(Next)) { Next = Reader.GetNumFrames(); ..read the scene again with ReadLatestPose.. }
+*	}
+*/
+class FSLRawDataSharedMemoryReader
+{
+public:
+	// Constructor
+	FSLRawDataSharedMemoryReader() : Base(nullptr), Size(0), Header(nullptr), EntityTableOffset(0)
+#ifdef _WIN32
+		, MappingHandle(nullptr)
+#endif
+	{}
+
+	// Destructor
+	~FSLRawDataSharedMemoryReader() { Close(); }
+
+	// Map the region created by the sink with the given name, false if missing or not yet initialized
+	bool Open(const std::string& Name)
+	{
+		Close();
+#ifdef _WIN32
+		MappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, Name.c_str());
+		if (!MappingHandle)
+		{
+			return false;
+		}
+		Base = (const uint8_t*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+		MEMORY_BASIC_INFORMATION Info;
+		Size = (Base && VirtualQuery(Base, &Info, sizeof(Info))) ? Info.RegionSize : 0;
+#else
+		const int Fd = shm_open(("/" + Name).c_str(), O_RDONLY, 0);
+		if (Fd < 0)
+		{
+			return false;
+		}
+		struct stat Stat;
+		if (fstat(Fd, &Stat) == 0 && Stat.st_size > 0)
+		{
+			void* Address = mmap(nullptr, (size_t)Stat.st_size, PROT_READ, MAP_SHARED, Fd, 0);
+			if (Address != MAP_FAILED)
+			{
+				Base = (const uint8_t*)Address;
+				Size = (size_t)Stat.st_size;
+			}
+		}
+		close(Fd);
+#endif
+		if (!Base || Size < sizeof(FSLRawDataSharedMemoryHeader))
+		{
+			Close();
+			return false;
+		}
+
+		Header = (const FSLRawDataSharedMemoryHeader*)Base;
+		if (Header->Magic.load(std::memory_order_acquire) != FSLRawDataSharedMemory::Magic ||
+			Header->Version != FSLRawDataSharedMemory::Version ||
+			Header->SlotsOffset + (uint64_t)Header->SlotSize * Header->NumSlots > Size ||
+			Header->PoseTableOffset + (uint64_t)Header->PoseTableCapacity * sizeof(FSLRawDataSharedMemoryPoseEntry) > Size)
+		{
+			Close();
+			return false;
+		}
+		Epoch = Header->Epoch;
+		return true;
+	}
+
+	// Unmap the region
+	void Close()
+	{
+#ifdef _WIN32
+		if (Base)
+		{
+			UnmapViewOfFile(Base);
+		}
+		if (MappingHandle)
+		{
+			CloseHandle(MappingHandle);
+			MappingHandle = nullptr;
+		}
+#else
+		if (Base)
+		{
+			munmap((void*)Base, Size);
+		}
+#endif
+		Base = nullptr;
+		Size = 0;
+		Header = nullptr;
+		Entities.clear();
+		EntityTableOffset = 0;
+	}
+
+	// Check if mapped
+	bool IsOpen() const { return Header != nullptr; }
+
+	// Session of the writer, the region was reused by a new session if it changed (reopen)
+	bool IsSameSession() const { return Header && Header->Magic.load(std::memory_order_acquire) == FSLRawDataSharedMemory::Magic && Header->Epoch == Epoch; }
+
+	// Set while the writer is running
+	bool IsWriterActive() const { return Header && Header->bWriterActive.load(std::memory_order_acquire) != 0; }
+
+	// Frames published so far, the latest one is GetNumFrames() - 1
+	uint64_t GetNumFrames() const { return Header ? Header->NumFrames.load(std::memory_order_acquire) : 0; }
+
+	// Check if the frame was already overwritten by a newer one
+	bool IsOverwritten(uint64_t FrameNumber) const
+	{
+		return Header && FrameNumber + Header->NumSlots < GetNumFrames();
+	}
+
+	// Start reading the frame in place, false if not yet published or already overwritten
+	bool BeginRead(uint64_t FrameNumber, FSLRawDataSharedMemoryFrameView& OutView) const
+	{
+		if (!Header)
+		{
+			return false;
+		}
+		const FSLRawDataSharedMemorySlot* Slot = GetSlot(FrameNumber);
+		if (Slot->Sequence.load(std::memory_order_acquire) != FSLRawDataSharedMemory::CompleteSequence(FrameNumber))
+		{
+			return false;
+		}
+
+		OutView.FrameNumber = FrameNumber;
+		OutView.Timestamp = Slot->Timestamp;
+		OutView.Flags = Slot->Flags;
+		OutView.NumPoses = Slot->NumPoses < Header->MaxPosesPerFrame ? Slot->NumPoses : Header->MaxPosesPerFrame;
+		OutView.Poses = (const FSLRawDataSharedMemoryPose*)((const uint8_t*)Slot + sizeof(FSLRawDataSharedMemorySlot));
+		OutView.Slot = Slot;
+		return true;
+	}
+
+	// Check that the frame was not overwritten while it was read, the values read from the view are valid only if true
+	bool EndRead(const FSLRawDataSharedMemoryFrameView& View) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return View.Slot && View.Slot->Sequence.load(std::memory_order_relaxed) ==
+			FSLRawDataSharedMemory::CompleteSequence(View.FrameNumber);
+	}
+
+	// Copy the frame, false if not yet published or overwritten
+	bool ReadFrame(uint64_t FrameNumber, FSLRawDataSharedMemoryFrame& OutFrame) const
+	{
+		FSLRawDataSharedMemoryFrameView View;
+		if (!BeginRead(FrameNumber, View))
+		{
+			return false;
+		}
+		OutFrame.FrameNumber = View.FrameNumber;
+		OutFrame.Timestamp = View.Timestamp;
+		OutFrame.Flags = View.Flags;
+		OutFrame.Poses.resize(View.NumPoses);
+		std::memcpy(OutFrame.Poses.data(), View.Poses, View.NumPoses * sizeof(FSLRawDataSharedMemoryPose));
+		return EndRead(View);
+	}
+
+	// Read the entities published since the last call (call before resolving the poses of newer frames)
+	void UpdateEntities()
+	{
+		if (!Header)
+		{
+			return;
+		}
+
+		// Published bytes are never changed by the writer
+		const uint64_t TableSize = Header->EntityTableSize.load(std::memory_order_acquire);
+		const uint8_t* Table = Base + Header->EntityTableOffset;
+		while (EntityTableOffset < TableSize)
+		{
+			FSLRawDataSharedMemoryEntity Entity;
+			uint32_t NameSize = 0;
+			uint32_t NumBones = 0;
+			Read(Table, &Entity.EntityIndex, sizeof(Entity.EntityIndex));
+			Read(Table, &Entity.FirstPoseEntry, sizeof(Entity.FirstPoseEntry));
+			Read(Table, &NameSize, sizeof(NameSize));
+			Entity.Name.assign((const char*)Table + EntityTableOffset, NameSize);
+			EntityTableOffset += NameSize;
+			Read(Table, &NumBones, sizeof(NumBones));
+			Entity.BoneNames.resize(NumBones);
+			for (uint32_t BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				Read(Table, &NameSize, sizeof(NameSize));
+				Entity.BoneNames[BoneIdx].assign((const char*)Table + EntityTableOffset, NameSize);
+				EntityTableOffset += NameSize;
+			}
+
+			if (Entity.EntityIndex >= 0)
+			{
+				if ((size_t)Entity.EntityIndex >= Entities.size())
+				{
+					Entities.resize(Entity.EntityIndex + 1);
+				}
+				Entities[Entity.EntityIndex] = std::move(Entity);
+			}
+		}
+	}
+
+	// Entities read so far, indexed by EntityIndex
+	const std::vector<FSLRawDataSharedMemoryEntity>& GetEntities() const { return Entities; }
+
+	// Copy the latest pose of the entity (BoneIndex -1) or of one of its bones, false if the entity is not read yet
+	// (see UpdateEntities), has no entries or the pose was never written; each pose is consistent on its own
+	bool ReadLatestPose(int32_t EntityIndex, int32_t BoneIndex, FSLRawDataSharedMemoryLatestPose& OutPose) const
+	{
+		if (!Header || EntityIndex < 0 || (size_t)EntityIndex >= Entities.size() || BoneIndex < -1)
+		{
+			return false;
+		}
+		const FSLRawDataSharedMemoryEntity& Entity = Entities[EntityIndex];
+		if (Entity.FirstPoseEntry == FSLRawDataSharedMemory::NoPoseEntry || (size_t)(BoneIndex + 1) > Entity.BoneNames.size())
+		{
+			return false;
+		}
+		const uint64_t EntryIndex = (uint64_t)Entity.FirstPoseEntry + 1 + BoneIndex;
+		if (EntryIndex >= Header->PoseTableCapacity)
+		{
+			return false;
+		}
+		const FSLRawDataSharedMemoryPoseEntry* Entry = (const FSLRawDataSharedMemoryPoseEntry*)(Base + Header->PoseTableOffset) + EntryIndex;
+
+		// The writer changes an entry for a few nanoseconds, retry until a complete copy is read
+		// (bounded, the writer may have stopped while writing)
+		for (int Attempt = 0; Attempt < 1000; ++Attempt)
+		{
+			const uint64_t Sequence = Entry->Sequence.load(std::memory_order_acquire);
+			if (Sequence == 0)
+			{
+				return false;
+			}
+			if (Sequence & 1)
+			{
+				continue;
+			}
+			OutPose.FrameNumber = Entry->FrameNumber;
+			OutPose.Timestamp = Entry->Timestamp;
+			std::memcpy(&OutPose.Pose, &Entry->Pose, sizeof(OutPose.Pose));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (Entry->Sequence.load(std::memory_order_relaxed) == Sequence)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	// Get the slot of the frame
+	const FSLRawDataSharedMemorySlot* GetSlot(uint64_t FrameNumber) const
+	{
+		return (const FSLRawDataSharedMemorySlot*)(Base + Header->SlotsOffset +
+			(FrameNumber % Header->NumSlots) * Header->SlotSize);
+	}
+
+	// Read an unaligned value of the entity table
+	void Read(const uint8_t* Table, void* OutValue, size_t ValueSize)
+	{
+		std::memcpy(OutValue, Table + EntityTableOffset, ValueSize);
+		EntityTableOffset += ValueSize;
+	}
+
+	// Mapped region
+	const uint8_t* Base;
+	size_t Size;
+
+	// Region header
+	const FSLRawDataSharedMemoryHeader* Header;
+
+	// Writer session of the mapped region
+	uint64_t Epoch = 0;
+
+	// Bytes of the entity table read so far
+	uint64_t EntityTableOffset;
+
+	// Entities read so far
+	std::vector<FSLRawDataSharedMemoryEntity> Entities;
+
+#ifdef _WIN32
+	// File mapping
+	HANDLE MappingHandle;
+#endif
+};
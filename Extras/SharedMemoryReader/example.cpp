@@ -0,0 +1,71 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+// Prints the poses published by the raw data shared memory sink:
+//	g++ -std=c++11 -O2 -I../../Source/SemLog/Public example.cpp -o example -lrt && ./example SLRawData
+#include "SLRawDataSharedMemoryReader.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Print the entity pose
+static void PrintPose(double Timestamp, const std::string& Name, const FSLRawDataSharedMemoryPose& Pose)
+{
+	std::printf("%.3f %s %.2f %.2f %.2f\n", Timestamp, Name.c_str(), Pose.Location[0], Pose.Location[1], Pose.Location[2]);
+}
+
+// Print the latest pose of every entity
+static void PrintScene(FSLRawDataSharedMemoryReader& Reader)
+{
+	Reader.UpdateEntities();
+	FSLRawDataSharedMemoryLatestPose Latest;
+	for (const auto& Entity : Reader.GetEntities())
+	{
+		if (Reader.ReadLatestPose(Entity.EntityIndex, -1, Latest))
+		{
+			PrintPose(Latest.Timestamp, Entity.Name, Latest.Pose);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string Name = argc > 1 ? argv[1] : "SLRawData";
+	FSLRawDataSharedMemoryReader Reader;
+	while (!Reader.Open(Name))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	// The latest poses hold the whole scene (static entities included), the frames after it only the changes
+	uint64_t Next = Reader.GetNumFrames();
+	PrintScene(Reader);
+
+	FSLRawDataSharedMemoryFrame Frame;
+	while (Reader.IsWriterActive() || Next < Reader.GetNumFrames())
+	{
+		if (Reader.IsOverwritten(Next))
+		{
+			std::printf("Skipped %llu frames\n", (unsigned long long)(Reader.GetNumFrames() - Next));
+			Next = Reader.GetNumFrames();
+			PrintScene(Reader);
+		}
+		if (!Reader.ReadFrame(Next, Frame))
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			continue;
+		}
+		Next++;
+
+		Reader.UpdateEntities();
+		const auto& Entities = Reader.GetEntities();
+		for (const auto& Pose : Frame.Poses)
+		{
+			if (Pose.BoneIndex < 0 && (size_t)Pose.EntityIndex < Entities.size())
+			{
+				PrintPose(Frame.Timestamp, Entities[Pose.EntityIndex].Name, Pose);
+			}
+		}
+	}
+	return 0;
+}
@@ -2,6 +2,9 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "SLModule.h"
+#ifdef WITH_MONGO
+#include "mongoc.h"
+#endif //WITH_MONGO
 
 // Define logging types
 DEFINE_LOG_CATEGORY(LogSL);
@@ -11,12 +14,19 @@ DEFINE_LOG_CATEGORY(LogSL);
 void FSLModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+#ifdef WITH_MONGO
+	// Init the mongo driver once for all clients
+	mongoc_init();
+#endif //WITH_MONGO
 }
 
 void FSLModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+#ifdef WITH_MONGO
+	mongoc_cleanup();
+#endif //WITH_MONGO
 }
 
 #undef LOCTEXT_NAMESPACE
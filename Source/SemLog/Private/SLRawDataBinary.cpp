@@ -0,0 +1,463 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataBinary.h"
+#include "SLRawDataJson.h"
+#include "SLRawDataQuantization.h"
+#include "MemoryWriter.h"
+#include "MemoryReader.h"
+#include "FileHelper.h"
+
+// Constructor
+FSLRawDataBinaryWriter::FSLRawDataBinaryWriter() : bQuantize(false), bDelta(false), bDeltaResetPending(false)
+{
+}
+
+// Append the file header
+void FSLRawDataBinaryWriter::WriteHeader()
+{
+	FMemoryWriter Writer(Buffer);
+	Writer.Seek(Buffer.Num());
+
+	uint32 Magic = FSLRawDataBinary::Magic;
+	uint32 Version = FSLRawDataBinary::Version;
+	Writer << Magic;
+	Writer << Version;
+}
+
+// Append the new entities and the poses of the frame
+void FSLRawDataBinaryWriter::WriteFrame(const FSLRawDataFrame& Frame)
+{
+	// Entities first, readers need them to resolve the poses
+	for (const auto& EntityItr : Frame.NewEntities)
+	{
+		FSLRawDataBinaryWriter::WriteEntity(EntityItr);
+	}
+
+	if (Frame.Poses.Num() == 0)
+	{
+		return;
+	}
+
+	if (bQuantize && bDelta)
+	{
+		FSLRawDataBinaryWriter::WriteDeltaFrame(Frame);
+		return;
+	}
+	if (bQuantize)
+	{
+		FSLRawDataBinaryWriter::WriteQuantizedFrame(Frame);
+		return;
+	}
+
+	FMemoryWriter Writer(Buffer);
+	Writer.Seek(Buffer.Num());
+
+	uint8 ChunkType = FSLRawDataBinary::FrameChunk;
+	double Timestamp = Frame.Timestamp;
+	uint8 Flags = Frame.bIsKeyframe ? FSLRawDataBinary::KeyframeFlag : 0;
+	int32 NumPoses = Frame.Poses.Num();
+	Writer << ChunkType;
+	Writer << Timestamp;
+	Writer << Flags;
+	Writer << NumPoses;
+
+	// Reserve the whole frame at once
+	Buffer.Reserve(Buffer.Num() + NumPoses * FSLRawDataBinary::PoseSize);
+
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		int32 EntityIndex = PoseItr.EntityIndex;
+		int32 BoneIndex = PoseItr.BoneIndex;
+		FVector Location = PoseItr.Location;
+		FQuat Rotation = PoseItr.Rotation;
+		Writer << EntityIndex;
+		Writer << BoneIndex;
+		Writer << Location.X << Location.Y << Location.Z;
+		Writer << Rotation.X << Rotation.Y << Rotation.Z << Rotation.W;
+	}
+}
+
+// Append entity chunks for the first Num entities
+void FSLRawDataBinaryWriter::WriteEntities(const TArray<FSLRawDataEntityDesc>& Entities, int32 Num)
+{
+	for (int32 Idx = 0; Idx < Num && Idx < Entities.Num(); ++Idx)
+	{
+		FSLRawDataBinaryWriter::WriteEntity(Entities[Idx]);
+	}
+}
+
+// Append an entity chunk
+void FSLRawDataBinaryWriter::WriteEntity(const FSLRawDataEntityDesc& Entity)
+{
+	FMemoryWriter Writer(Buffer);
+	Writer.Seek(Buffer.Num());
+
+	uint8 ChunkType = FSLRawDataBinary::EntityChunk;
+	int32 EntityIndex = Entity.EntityIndex;
+	FString UniqueName = Entity.UniqueName;
+	int32 NumBones = Entity.BoneNames.Num();
+	Writer << ChunkType;
+	Writer << EntityIndex;
+	Writer << UniqueName;
+	Writer << NumBones;
+	for (const auto& BoneNameItr : Entity.BoneNames)
+	{
+		FString BoneName = BoneNameItr;
+		Writer << BoneName;
+	}
+	float PositionPrecision = Entity.PositionPrecision;
+	Writer << PositionPrecision;
+
+	// Needed to quantize the poses of the entity
+	if (PositionPrecisions.Num() <= EntityIndex)
+	{
+		PositionPrecisions.SetNumZeroed(EntityIndex + 1);
+	}
+	PositionPrecisions[EntityIndex] = PositionPrecision;
+}
+
+// Append the poses of the frame as a quantized frame chunk
+void FSLRawDataBinaryWriter::WriteQuantizedFrame(const FSLRawDataFrame& Frame)
+{
+	FMemoryWriter Writer(Buffer);
+	Writer.Seek(Buffer.Num());
+
+	uint8 ChunkType = FSLRawDataBinary::QuantizedFrameChunk;
+	double Timestamp = Frame.Timestamp;
+	uint8 Flags = Frame.bIsKeyframe ? FSLRawDataBinary::KeyframeFlag : 0;
+	int32 NumPoses = Frame.Poses.Num();
+	Writer << ChunkType;
+	Writer << Timestamp;
+	Writer << Flags;
+	Writer << NumPoses;
+
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		uint32 EntityIndex = (uint32)PoseItr.EntityIndex;
+		uint32 BoneIndex = (uint32)(PoseItr.BoneIndex + 1);
+		Writer.SerializeIntPacked(EntityIndex);
+		Writer.SerializeIntPacked(BoneIndex);
+
+		const float Precision = PositionPrecisions.IsValidIndex(PoseItr.EntityIndex) ? PositionPrecisions[PoseItr.EntityIndex] : 0.f;
+		if (Precision > 0.f)
+		{
+			const FIntVector Quantized = FSLRawDataQuantization::QuantizeLocation(PoseItr.Location, Precision);
+			uint32 X = FSLRawDataQuantization::ZigZagEncode(Quantized.X);
+			uint32 Y = FSLRawDataQuantization::ZigZagEncode(Quantized.Y);
+			uint32 Z = FSLRawDataQuantization::ZigZagEncode(Quantized.Z);
+			uint64 PackedRotation = FSLRawDataQuantization::PackQuat(PoseItr.Rotation);
+			Writer.SerializeIntPacked(X);
+			Writer.SerializeIntPacked(Y);
+			Writer.SerializeIntPacked(Z);
+			FSLRawDataQuantization::SerializePackedQuat(Writer, PackedRotation);
+		}
+		else
+		{
+			FVector Location = PoseItr.Location;
+			FQuat Rotation = PoseItr.Rotation;
+			Writer << Location.X << Location.Y << Location.Z;
+			Writer << Rotation.X << Rotation.Y << Rotation.Z << Rotation.W;
+		}
+	}
+}
+
+// Append the poses of the frame as a delta frame chunk
+void FSLRawDataBinaryWriter::WriteDeltaFrame(const FSLRawDataFrame& Frame)
+{
+	// Keyframes can be decoded on their own
+	uint8 Flags = 0;
+	if (Frame.bIsKeyframe)
+	{
+		Flags |= FSLRawDataBinary::KeyframeFlag;
+	}
+	if (bDeltaResetPending)
+	{
+		Flags |= FSLRawDataBinary::DeltaResetFlag;
+	}
+	if (Flags != 0)
+	{
+		PrevPoses.Reset();
+		bDeltaResetPending = false;
+	}
+
+	FMemoryWriter Writer(Buffer);
+	Writer.Seek(Buffer.Num());
+
+	uint8 ChunkType = FSLRawDataBinary::DeltaFrameChunk;
+	double Timestamp = Frame.Timestamp;
+	int32 NumPoses = Frame.Poses.Num();
+	Writer << ChunkType;
+	Writer << Timestamp;
+	Writer << Flags;
+	Writer << NumPoses;
+
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		uint32 EntityIndex = (uint32)PoseItr.EntityIndex;
+		uint32 BoneIndex = (uint32)(PoseItr.BoneIndex + 1);
+		Writer.SerializeIntPacked(EntityIndex);
+		Writer.SerializeIntPacked(BoneIndex);
+
+		const float Precision = PositionPrecisions.IsValidIndex(PoseItr.EntityIndex) ? PositionPrecisions[PoseItr.EntityIndex] : 0.f;
+		if (Precision > 0.f)
+		{
+			FSLRawDataQuantizedPose& Prev = FSLRawDataQuantizedPose::Find(PrevPoses, PoseItr.EntityIndex, PoseItr.BoneIndex);
+			const FIntVector Location = FSLRawDataQuantization::QuantizeLocation(PoseItr.Location, Precision);
+			int32 Rotation[4];
+			FSLRawDataQuantization::QuantizeQuatComponents(PoseItr.Rotation, Prev.Rotation, Rotation);
+
+			uint32 Deltas[7] = {
+				FSLRawDataQuantization::ZigZagEncode(Location.X - Prev.Location.X),
+				FSLRawDataQuantization::ZigZagEncode(Location.Y - Prev.Location.Y),
+				FSLRawDataQuantization::ZigZagEncode(Location.Z - Prev.Location.Z),
+				FSLRawDataQuantization::ZigZagEncode(Rotation[0] - Prev.Rotation[0]),
+				FSLRawDataQuantization::ZigZagEncode(Rotation[1] - Prev.Rotation[1]),
+				FSLRawDataQuantization::ZigZagEncode(Rotation[2] - Prev.Rotation[2]),
+				FSLRawDataQuantization::ZigZagEncode(Rotation[3] - Prev.Rotation[3]) };
+			for (uint32& DeltaItr : Deltas)
+			{
+				Writer.SerializeIntPacked(DeltaItr);
+			}
+
+			Prev.Location = Location;
+			FMemory::Memcpy(Prev.Rotation, Rotation, sizeof(Rotation));
+		}
+		else
+		{
+			FVector Location = PoseItr.Location;
+			FQuat Rotation = PoseItr.Rotation;
+			Writer << Location.X << Location.Y << Location.Z;
+			Writer << Rotation.X << Rotation.Y << Rotation.Z << Rotation.W;
+		}
+	}
+}
+
+// Load and parse the file
+bool FSLRawDataBinaryReader::LoadFromFile(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		return false;
+	}
+	return FSLRawDataBinaryReader::LoadFromBuffer(Bytes);
+}
+
+// Parse the bytes of a binary raw data file
+bool FSLRawDataBinaryReader::LoadFromBuffer(const TArray<uint8>& Bytes)
+{
+	Entities.Empty();
+	Frames.Empty();
+
+	FMemoryReader Reader(Bytes);
+	uint32 Version = 0;
+	if (!FSLRawDataBinaryReader::ReadHeader(Reader, Version))
+	{
+		return false;
+	}
+
+	// Previous poses of the delta frames
+	TArray<TArray<FSLRawDataQuantizedPose>> PrevPoses;
+
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		uint8 ChunkType = 0;
+		Reader << ChunkType;
+
+		if (ChunkType == FSLRawDataBinary::EntityChunk)
+		{
+			FSLRawDataEntityDesc Entity;
+			if (!FSLRawDataBinaryReader::ReadEntityChunk(Reader, Version, Entity))
+			{
+				return false;
+			}
+			FSLRawDataBinaryReader::AddEntity(Entities, Entity);
+		}
+		else
+		{
+			FSLRawDataFrame& Frame = Frames[Frames.AddDefaulted()];
+			if (!FSLRawDataBinaryReader::ReadFrameChunk(Reader, ChunkType, Version, Entities, PrevPoses, Frame))
+			{
+				return false;
+			}
+		}
+	}
+	return !Reader.IsError();
+}
+
+// Read and check the file header
+bool FSLRawDataBinaryReader::ReadHeader(FArchive& Reader, uint32& OutVersion)
+{
+	if (Reader.TotalSize() < FSLRawDataBinary::HeaderSize)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	OutVersion = 0;
+	Reader << Magic;
+	Reader << OutVersion;
+	return Magic == FSLRawDataBinary::Magic && OutVersion >= 1 && OutVersion <= FSLRawDataBinary::Version;
+}
+
+// Read an entity chunk (after the chunk type)
+bool FSLRawDataBinaryReader::ReadEntityChunk(FArchive& Reader, uint32 Version, FSLRawDataEntityDesc& OutEntity)
+{
+	int32 NumBones = 0;
+	Reader << OutEntity.EntityIndex;
+	Reader << OutEntity.UniqueName;
+	Reader << NumBones;
+	if (OutEntity.EntityIndex < 0 || NumBones < 0 || NumBones > Reader.TotalSize() - Reader.Tell())
+	{
+		return false;
+	}
+	OutEntity.BoneNames.SetNum(NumBones);
+	for (auto& BoneNameItr : OutEntity.BoneNames)
+	{
+		Reader << BoneNameItr;
+	}
+	if (Version >= 3)
+	{
+		Reader << OutEntity.PositionPrecision;
+	}
+	return !Reader.IsError();
+}
+
+// Store the entity in the table indexed by EntityIndex
+void FSLRawDataBinaryReader::AddEntity(TArray<FSLRawDataEntityDesc>& InOutEntities, const FSLRawDataEntityDesc& Entity)
+{
+	if (InOutEntities.Num() <= Entity.EntityIndex)
+	{
+		InOutEntities.SetNum(Entity.EntityIndex + 1);
+	}
+	InOutEntities[Entity.EntityIndex] = Entity;
+}
+
+// Read a frame chunk of any type (after the chunk type)
+bool FSLRawDataBinaryReader::ReadFrameChunk(FArchive& Reader, uint8 ChunkType, uint32 Version,
+	const TArray<FSLRawDataEntityDesc>& InEntities, TArray<TArray<FSLRawDataQuantizedPose>>& PrevPoses, FSLRawDataFrame& OutFrame)
+{
+	if (ChunkType != FSLRawDataBinary::FrameChunk &&
+		ChunkType != FSLRawDataBinary::QuantizedFrameChunk &&
+		ChunkType != FSLRawDataBinary::DeltaFrameChunk)
+	{
+		// Unknown chunk
+		return false;
+	}
+
+	double Timestamp = 0.0;
+	uint8 Flags = 0;
+	int32 NumPoses = 0;
+	Reader << Timestamp;
+	if (Version >= 2)
+	{
+		Reader << Flags;
+	}
+	Reader << NumPoses;
+
+	// Float frames have fixed size poses, the others at least one byte per pose
+	const int64 MinPoseSize = (ChunkType == FSLRawDataBinary::FrameChunk) ? FSLRawDataBinary::PoseSize : 1;
+	if (NumPoses < 0 || NumPoses * MinPoseSize > Reader.TotalSize() - Reader.Tell())
+	{
+		return false;
+	}
+	if (ChunkType == FSLRawDataBinary::DeltaFrameChunk &&
+		(Flags & (FSLRawDataBinary::KeyframeFlag | FSLRawDataBinary::DeltaResetFlag)))
+	{
+		PrevPoses.Reset();
+	}
+
+	OutFrame.Reset();
+	OutFrame.Timestamp = Timestamp;
+	OutFrame.bIsKeyframe = (Flags & FSLRawDataBinary::KeyframeFlag) != 0;
+	OutFrame.Poses.SetNumUninitialized(NumPoses);
+	for (auto& PoseItr : OutFrame.Poses)
+	{
+		if (ChunkType == FSLRawDataBinary::FrameChunk)
+		{
+			Reader << PoseItr.EntityIndex;
+			Reader << PoseItr.BoneIndex;
+			Reader << PoseItr.Location.X << PoseItr.Location.Y << PoseItr.Location.Z;
+			Reader << PoseItr.Rotation.X << PoseItr.Rotation.Y << PoseItr.Rotation.Z << PoseItr.Rotation.W;
+			continue;
+		}
+
+		uint32 EntityIndex = 0;
+		uint32 BoneIndex = 0;
+		Reader.SerializeIntPacked(EntityIndex);
+		Reader.SerializeIntPacked(BoneIndex);
+		PoseItr.EntityIndex = (int32)EntityIndex;
+		PoseItr.BoneIndex = (int32)BoneIndex - 1;
+		if (!InEntities.IsValidIndex(PoseItr.EntityIndex) || PoseItr.BoneIndex < INDEX_NONE ||
+			PoseItr.BoneIndex >= InEntities[PoseItr.EntityIndex].BoneNames.Num())
+		{
+			return false;
+		}
+
+		const float Precision = InEntities[PoseItr.EntityIndex].PositionPrecision;
+		if (Precision <= 0.f)
+		{
+			Reader << PoseItr.Location.X << PoseItr.Location.Y << PoseItr.Location.Z;
+			Reader << PoseItr.Rotation.X << PoseItr.Rotation.Y << PoseItr.Rotation.Z << PoseItr.Rotation.W;
+		}
+		else if (ChunkType == FSLRawDataBinary::QuantizedFrameChunk)
+		{
+			uint32 X = 0, Y = 0, Z = 0;
+			uint64 PackedRotation = 0;
+			Reader.SerializeIntPacked(X);
+			Reader.SerializeIntPacked(Y);
+			Reader.SerializeIntPacked(Z);
+			FSLRawDataQuantization::SerializePackedQuat(Reader, PackedRotation);
+			PoseItr.Location = FSLRawDataQuantization::DequantizeLocation(FIntVector(
+				FSLRawDataQuantization::ZigZagDecode(X),
+				FSLRawDataQuantization::ZigZagDecode(Y),
+				FSLRawDataQuantization::ZigZagDecode(Z)), Precision);
+			PoseItr.Rotation = FSLRawDataQuantization::UnpackQuat(PackedRotation);
+		}
+		else
+		{
+			uint32 Deltas[7];
+			for (uint32& DeltaItr : Deltas)
+			{
+				Reader.SerializeIntPacked(DeltaItr);
+			}
+
+			// Absolute values from the previous pose of the same entity and bone
+			FSLRawDataQuantizedPose& Prev = FSLRawDataQuantizedPose::Find(PrevPoses, PoseItr.EntityIndex, PoseItr.BoneIndex);
+			Prev.Location.X += FSLRawDataQuantization::ZigZagDecode(Deltas[0]);
+			Prev.Location.Y += FSLRawDataQuantization::ZigZagDecode(Deltas[1]);
+			Prev.Location.Z += FSLRawDataQuantization::ZigZagDecode(Deltas[2]);
+			for (int32 Idx = 0; Idx < 4; ++Idx)
+			{
+				Prev.Rotation[Idx] += FSLRawDataQuantization::ZigZagDecode(Deltas[3 + Idx]);
+			}
+			PoseItr.Location = FSLRawDataQuantization::DequantizeLocation(Prev.Location, Precision);
+			PoseItr.Rotation = FSLRawDataQuantization::DequantizeQuatComponents(Prev.Rotation);
+		}
+	}
+	return !Reader.IsError();
+}
+
+// Convert the loaded frames to the json layout of the raw data logger
+bool FSLRawDataBinaryReader::WriteAsJson(const FString& Path) const
+{
+	// Frames are concatenated, as written by the raw data logger
+	FSLRawDataJsonWriter JsonWriter;
+	for (const auto& FrameItr : Frames)
+	{
+		JsonWriter.WriteFrame(FrameItr, Entities);
+	}
+	return FFileHelper::SaveArrayToFile(JsonWriter.GetBuffer(), *Path);
+}
+
+// Convert a binary raw data file to the json layout of the raw data logger
+bool FSLRawDataBinaryReader::ConvertToJson(const FString& BinaryPath, const FString& JsonPath)
+{
+	FSLRawDataBinaryReader BinaryReader;
+	if (!BinaryReader.LoadFromFile(BinaryPath))
+	{
+		return false;
+	}
+	return BinaryReader.WriteAsJson(JsonPath);
+}
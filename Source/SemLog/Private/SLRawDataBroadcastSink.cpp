@@ -0,0 +1,40 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataBroadcastSink.h"
+
+// Constructor with the callback
+FSLRawDataBroadcastSink::FSLRawDataBroadcastSink(FSLRawDataJsonBytesCallback InOnJsonBytes)
+	: OnJsonBytes(MoveTemp(InOnJsonBytes))
+{
+}
+
+// Destructor, serializes the queued frames
+FSLRawDataBroadcastSink::~FSLRawDataBroadcastSink()
+{
+	FSLRawDataSink::Finish();
+}
+
+// Serialize the frames and pass them on as one batch
+void FSLRawDataBroadcastSink::Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	for (const FSLRawDataFrameRef& Frame : Frames)
+	{
+		// Encoded once by the encode sink if the frames are also written to a json file
+		if (Frame->JsonBytes.IsValid())
+		{
+			JsonBatch.Add(Frame->JsonBytes.ToSharedRef());
+		}
+		else if (JsonWriter.WriteFrame(*Frame, Entities))
+		{
+			JsonBatch.Add(JsonWriter.ReleaseBuffer());
+		}
+		JsonWriter.Reset();
+	}
+
+	if (JsonBatch.Num() > 0)
+	{
+		OnJsonBytes(JsonBatch);
+		JsonBatch.Reset();
+	}
+}
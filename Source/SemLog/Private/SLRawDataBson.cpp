@@ -0,0 +1,164 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataBson.h"
+
+#ifdef WITH_MONGO
+// Constructor
+FSLRawDataBsonWriter::FSLRawDataBsonWriter()
+{
+	bson_init(&Document);
+}
+
+// Destructor
+FSLRawDataBsonWriter::~FSLRawDataBsonWriter()
+{
+	bson_destroy(&Document);
+}
+
+// Write the frame as a document
+bool FSLRawDataBsonWriter::WriteFrame(const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	// Avoid writing empty entries
+	if (Frame.Poses.Num() == 0)
+	{
+		return false;
+	}
+
+	// Keeps the heap buffer of the previous frames
+	bson_reinit(&Document);
+	BSON_APPEND_DOUBLE(&Document, "timestamp", Frame.Timestamp);
+	if (Frame.bIsKeyframe)
+	{
+		BSON_APPEND_BOOL(&Document, "keyframe", true);
+	}
+
+	// Child documents are written in place into the parent buffer
+	bson_t Actors;
+	bson_t Actor;
+	bson_t Bones;
+	bson_t Bone;
+	uint32 NumActors = 0;
+	uint32 NumBones = 0;
+	int32 KeyLength = 0;
+	const char* Key = nullptr;
+
+	// Bones follow the pose of their entity
+	const FEncodedNames* ActorNames = nullptr;
+	bool bHasBones = false;
+
+	BSON_APPEND_ARRAY_BEGIN(&Document, "actors", &Actors);
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		if (!Entities.IsValidIndex(PoseItr.EntityIndex))
+		{
+			continue;
+		}
+
+		if (PoseItr.BoneIndex == INDEX_NONE)
+		{
+			// Close the previous actor
+			if (ActorNames)
+			{
+				if (bHasBones)
+				{
+					bson_append_array_end(&Actor, &Bones);
+				}
+				bson_append_document_end(&Actors, &Actor);
+			}
+
+			ActorNames = &GetEncodedNames(Entities[PoseItr.EntityIndex]);
+			Key = GetArrayKey(NumActors++, KeyLength);
+			bson_append_document_begin(&Actors, Key, KeyLength, &Actor);
+			AppendNameLocRot(&Actor, ActorNames->Name, PoseItr.Location * 0.01f, PoseItr.Rotation);
+
+			bHasBones = ActorNames->BoneNames.Num() > 0;
+			if (bHasBones)
+			{
+				BSON_APPEND_ARRAY_BEGIN(&Actor, "bones", &Bones);
+			}
+			NumBones = 0;
+		}
+		else if (ActorNames && ActorNames->BoneNames.IsValidIndex(PoseItr.BoneIndex))
+		{
+			Key = GetArrayKey(NumBones++, KeyLength);
+			bson_append_document_begin(&Bones, Key, KeyLength, &Bone);
+			AppendNameLocRot(&Bone, ActorNames->BoneNames[PoseItr.BoneIndex], PoseItr.Location * 0.01f, PoseItr.Rotation);
+			bson_append_document_end(&Bones, &Bone);
+		}
+	}
+
+	// Close the last actor
+	if (ActorNames)
+	{
+		if (bHasBones)
+		{
+			bson_append_array_end(&Actor, &Bones);
+		}
+		bson_append_document_end(&Actors, &Actor);
+	}
+	bson_append_array_end(&Document, &Actors);
+
+	return true;
+}
+
+// Get the encoded names of the entity, encode them on first use
+const FSLRawDataBsonWriter::FEncodedNames& FSLRawDataBsonWriter::GetEncodedNames(const FSLRawDataEntityDesc& Entity)
+{
+	if (EncodedNamesCache.Num() <= Entity.EntityIndex)
+	{
+		EncodedNamesCache.SetNum(Entity.EntityIndex + 1);
+	}
+
+	FEncodedNames& Names = EncodedNamesCache[Entity.EntityIndex];
+	if (!Names.bIsSet)
+	{
+		FSLRawDataBsonWriter::EncodeString(Entity.UniqueName, Names.Name);
+		Names.BoneNames.SetNum(Entity.BoneNames.Num());
+		for (int32 BoneIndex = 0; BoneIndex < Entity.BoneNames.Num(); ++BoneIndex)
+		{
+			FSLRawDataBsonWriter::EncodeString(Entity.BoneNames[BoneIndex], Names.BoneNames[BoneIndex]);
+		}
+		Names.bIsSet = true;
+	}
+	return Names;
+}
+
+// Get the key of the array element (the first thousand keys are static strings in libbson)
+FORCEINLINE const char* FSLRawDataBsonWriter::GetArrayKey(uint32 Index, int32& OutLength)
+{
+	const char* Key = nullptr;
+	OutLength = (int32)bson_uint32_to_string(Index, &Key, KeyBuffer, sizeof(KeyBuffer));
+	return Key;
+}
+
+// Append the name, location and rotation
+FORCEINLINE void FSLRawDataBsonWriter::AppendNameLocRot(bson_t* Parent, const TArray<ANSICHAR>& EncodedName,
+	const FVector& Location, const FQuat& Rotation)
+{
+	bson_append_utf8(Parent, "name", 4, EncodedName.GetData(), EncodedName.Num());
+
+	bson_t Pos;
+	bson_append_document_begin(Parent, "pos", 3, &Pos);
+	bson_append_double(&Pos, "x", 1, Location.X);
+	bson_append_double(&Pos, "y", 1, -Location.Y); // left to right handed
+	bson_append_double(&Pos, "z", 1, Location.Z);
+	bson_append_document_end(Parent, &Pos);
+
+	bson_t Rot;
+	bson_append_document_begin(Parent, "rot", 3, &Rot);
+	bson_append_double(&Rot, "w", 1, Rotation.W);
+	bson_append_double(&Rot, "x", 1, -Rotation.X); // left to right handed
+	bson_append_double(&Rot, "y", 1, Rotation.Y);
+	bson_append_double(&Rot, "z", 1, -Rotation.Z); // left to right handed
+	bson_append_document_end(Parent, &Rot);
+}
+
+// Encode the string as UTF-8 (without the terminator, the length is passed to libbson)
+void FSLRawDataBsonWriter::EncodeString(const FString& InString, TArray<ANSICHAR>& OutChars)
+{
+	FTCHARToUTF8 Converter(*InString);
+	OutChars.Reset(Converter.Length());
+	OutChars.Append((const ANSICHAR*)Converter.Get(), Converter.Length());
+}
+#endif //WITH_MONGO
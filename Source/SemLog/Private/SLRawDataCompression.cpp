@@ -0,0 +1,367 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataCompression.h"
+#include "Misc/Compression.h"
+#include "MemoryWriter.h"
+#include "MemoryReader.h"
+#include "FileHelper.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+// Constructor
+FSLRawDataCompressedWriter::FSLRawDataCompressedWriter()
+	: BlockSize(FSLRawDataCompressed::DefaultBlockSize), BlockFirstTimestamp(0.0), BlockLastTimestamp(0.0), FileSize(0)
+{
+}
+
+// Start a new file
+void FSLRawDataCompressedWriter::Init(const TArray<uint8>& StreamHeader, int32 InBlockSize)
+{
+	BlockSize = FMath::Max(InBlockSize, 1);
+	Block.Reset();
+	Index.Reset();
+
+	Header.Reset();
+	FMemoryWriter Writer(Header);
+	uint32 Magic = FSLRawDataCompressed::Magic;
+	uint32 Version = FSLRawDataCompressed::Version;
+	int32 StreamHeaderSize = StreamHeader.Num();
+	Writer << Magic;
+	Writer << Version;
+	Writer << StreamHeaderSize;
+	Header.Append(StreamHeader);
+	FileSize = Header.Num();
+}
+
+// Append the file header to the output
+void FSLRawDataCompressedWriter::WriteHeader(TArray<uint8>& OutBytes)
+{
+	OutBytes.Append(Header);
+}
+
+// Add a serialized frame
+bool FSLRawDataCompressedWriter::AddFrame(const TArray<uint8>& FrameBytes, double Timestamp, TArray<uint8>& OutBytes)
+{
+	if (Block.Num() == 0)
+	{
+		BlockFirstTimestamp = Timestamp;
+	}
+	BlockLastTimestamp = Timestamp;
+	Block.Append(FrameBytes);
+
+	if (Block.Num() >= BlockSize)
+	{
+		FSLRawDataCompressedWriter::CompressBlock(OutBytes);
+		return true;
+	}
+	return false;
+}
+
+// Compress the remaining frames and append the index and the footer
+void FSLRawDataCompressedWriter::Finish(TArray<uint8>& OutBytes)
+{
+	if (Block.Num() > 0)
+	{
+		FSLRawDataCompressedWriter::CompressBlock(OutBytes);
+	}
+
+	FMemoryWriter Writer(OutBytes);
+	Writer.Seek(OutBytes.Num());
+
+	int64 IndexOffset = FileSize;
+	int32 NumBlocks = Index.Num();
+	Writer << NumBlocks;
+	for (auto& InfoItr : Index)
+	{
+		Writer << InfoItr;
+	}
+	uint32 Magic = FSLRawDataCompressed::Magic;
+	Writer << IndexOffset;
+	Writer << Magic;
+}
+
+// Compress the current block and append it to the output
+void FSLRawDataCompressedWriter::CompressBlock(TArray<uint8>& OutBytes)
+{
+	const int32 HeaderOffset = OutBytes.Num();
+	int32 CompressedSize = FCompression::CompressMemoryBound(COMPRESS_ZLIB, Block.Num());
+	OutBytes.AddUninitialized(FSLRawDataCompressed::BlockHeaderSize + CompressedSize);
+	if (!FCompression::CompressMemory(COMPRESS_ZLIB, OutBytes.GetData() + HeaderOffset + FSLRawDataCompressed::BlockHeaderSize,
+		CompressedSize, Block.GetData(), Block.Num()))
+	{
+		// Keep the frames (should not happen with a large enough output)
+		OutBytes.SetNum(HeaderOffset, false);
+		return;
+	}
+	OutBytes.SetNum(HeaderOffset + FSLRawDataCompressed::BlockHeaderSize + CompressedSize, false);
+
+	// Block header, with the timestamps the index can be rebuilt from the blocks
+	int32 UncompressedSize = Block.Num();
+	uint8* BlockHeader = OutBytes.GetData() + HeaderOffset;
+	const uint32 BlockMagic = FSLRawDataCompressed::BlockMagic;
+	FMemory::Memcpy(BlockHeader, &BlockMagic, sizeof(uint32));
+	FMemory::Memcpy(BlockHeader + 4, &UncompressedSize, sizeof(int32));
+	FMemory::Memcpy(BlockHeader + 8, &CompressedSize, sizeof(int32));
+	FMemory::Memcpy(BlockHeader + 12, &BlockFirstTimestamp, sizeof(double));
+	FMemory::Memcpy(BlockHeader + 20, &BlockLastTimestamp, sizeof(double));
+
+	FSLRawDataBlockInfo Info;
+	Info.FirstTimestamp = BlockFirstTimestamp;
+	Info.LastTimestamp = BlockLastTimestamp;
+	Info.Offset = FileSize;
+	Info.CompressedSize = CompressedSize;
+	Info.UncompressedSize = UncompressedSize;
+	Index.Add(Info);
+
+	FileSize += FSLRawDataCompressed::BlockHeaderSize + CompressedSize;
+	Block.Reset();
+}
+
+// Constructor
+FSLRawDataCompressedReader::FSLRawDataCompressedReader()
+	: FileHandle(nullptr), BlockHeaderSize(FSLRawDataCompressed::BlockHeaderSize), bRecovered(false)
+{
+}
+
+// Destructor
+FSLRawDataCompressedReader::~FSLRawDataCompressedReader()
+{
+	FSLRawDataCompressedReader::Close();
+}
+
+// Open the file and read the seek index
+bool FSLRawDataCompressedReader::Open(const FString& Path)
+{
+	FSLRawDataCompressedReader::Close();
+	FileHandle = FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path);
+	if (!FileHandle)
+	{
+		return false;
+	}
+
+	// Header
+	TArray<uint8> Bytes;
+	if (!FSLRawDataCompressedReader::ReadAt(0, 12, Bytes))
+	{
+		FSLRawDataCompressedReader::Close();
+		return false;
+	}
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 StreamHeaderSize = 0;
+	{
+		FMemoryReader Reader(Bytes);
+		Reader << Magic;
+		Reader << Version;
+		Reader << StreamHeaderSize;
+	}
+	if (Magic != FSLRawDataCompressed::Magic || Version < 1 || Version > FSLRawDataCompressed::Version || StreamHeaderSize < 0 ||
+		!FSLRawDataCompressedReader::ReadAt(12, StreamHeaderSize, StreamHeader))
+	{
+		FSLRawDataCompressedReader::Close();
+		return false;
+	}
+	BlockHeaderSize = Version == 1 ? FSLRawDataCompressed::BlockHeaderSizeV1 : FSLRawDataCompressed::BlockHeaderSize;
+
+	// The footer is missing if the logger did not finish, newer blocks describe themselves
+	if (!FSLRawDataCompressedReader::ReadIndex() &&
+		(Version == 1 || !FSLRawDataCompressedReader::RecoverIndex(12 + (int64)StreamHeaderSize)))
+	{
+		FSLRawDataCompressedReader::Close();
+		return false;
+	}
+	return true;
+}
+
+// Close the file
+void FSLRawDataCompressedReader::Close()
+{
+	if (FileHandle)
+	{
+		delete FileHandle;
+		FileHandle = nullptr;
+	}
+	StreamHeader.Empty();
+	Index.Empty();
+	bRecovered = false;
+}
+
+// Decompress the blocks overlapping the time range, prefixed by the stream header
+bool FSLRawDataCompressedReader::ReadRange(double StartTime, double EndTime, TArray<uint8>& OutBytes)
+{
+	OutBytes.Reset();
+	OutBytes.Append(StreamHeader);
+
+	// Blocks are in time order, find the first one ending after the start
+	int32 BlockIndex = 0;
+	int32 Last = Index.Num();
+	while (BlockIndex < Last)
+	{
+		const int32 Mid = (BlockIndex + Last) / 2;
+		if (Index[Mid].LastTimestamp < StartTime)
+		{
+			BlockIndex = Mid + 1;
+		}
+		else
+		{
+			Last = Mid;
+		}
+	}
+	for (; BlockIndex < Index.Num() && Index[BlockIndex].FirstTimestamp <= EndTime; ++BlockIndex)
+	{
+		if (!FSLRawDataCompressedReader::ReadBlock(BlockIndex, OutBytes))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Decompress a block and append it to the output
+bool FSLRawDataCompressedReader::ReadBlock(int32 BlockIndex, TArray<uint8>& OutBytes)
+{
+	if (!Index.IsValidIndex(BlockIndex))
+	{
+		return false;
+	}
+
+	const FSLRawDataBlockInfo& Info = Index[BlockIndex];
+	if (Info.CompressedSize < 0 || Info.UncompressedSize < 0 ||
+		!FSLRawDataCompressedReader::ReadAt(Info.Offset + BlockHeaderSize, Info.CompressedSize, CompressedBuffer))
+	{
+		return false;
+	}
+
+	const int32 OutOffset = OutBytes.Num();
+	OutBytes.AddUninitialized(Info.UncompressedSize);
+	if (!FCompression::UncompressMemory(COMPRESS_ZLIB, OutBytes.GetData() + OutOffset, Info.UncompressedSize,
+		CompressedBuffer.GetData(), Info.CompressedSize))
+	{
+		OutBytes.SetNum(OutOffset, false);
+		return false;
+	}
+	return true;
+}
+
+// Decompress the whole file
+bool FSLRawDataCompressedReader::Decompress(const FString& CompressedPath, const FString& OutPath)
+{
+	FSLRawDataCompressedReader CompressedReader;
+	if (!CompressedReader.Open(CompressedPath))
+	{
+		return false;
+	}
+
+	TArray<uint8> Bytes(CompressedReader.GetStreamHeader());
+	for (int32 BlockIndex = 0; BlockIndex < CompressedReader.GetIndex().Num(); ++BlockIndex)
+	{
+		if (!CompressedReader.ReadBlock(BlockIndex, Bytes))
+		{
+			return false;
+		}
+	}
+	return FFileHelper::SaveArrayToFile(Bytes, *OutPath);
+}
+
+// Read the index written at the end of the file
+bool FSLRawDataCompressedReader::ReadIndex()
+{
+	// Footer
+	TArray<uint8> Bytes;
+	const int64 FileSize = FileHandle->Size();
+	if (!FSLRawDataCompressedReader::ReadAt(FileSize - FSLRawDataCompressed::FooterSize, FSLRawDataCompressed::FooterSize, Bytes))
+	{
+		return false;
+	}
+	int64 IndexOffset = 0;
+	uint32 Magic = 0;
+	{
+		FMemoryReader Reader(Bytes);
+		Reader << IndexOffset;
+		Reader << Magic;
+	}
+	if (Magic != FSLRawDataCompressed::Magic || IndexOffset < 0 || IndexOffset > FileSize - FSLRawDataCompressed::FooterSize)
+	{
+		return false;
+	}
+
+	// Index
+	if (!FSLRawDataCompressedReader::ReadAt(IndexOffset, (int32)(FileSize - FSLRawDataCompressed::FooterSize - IndexOffset), Bytes))
+	{
+		return false;
+	}
+	FMemoryReader Reader(Bytes);
+	int32 NumBlocks = 0;
+	Reader << NumBlocks;
+	if (NumBlocks < 0 || (int64)NumBlocks * sizeof(FSLRawDataBlockInfo) > Bytes.Num())
+	{
+		return false;
+	}
+	Index.SetNum(NumBlocks);
+	for (auto& InfoItr : Index)
+	{
+		Reader << InfoItr;
+	}
+	if (Reader.IsError())
+	{
+		Index.Empty();
+		return false;
+	}
+	return true;
+}
+
+// Rebuild the index from the block headers, up to the first incomplete block
+bool FSLRawDataCompressedReader::RecoverIndex(int64 FirstBlockOffset)
+{
+	Index.Empty();
+	const int64 FileSize = FileHandle->Size();
+	TArray<uint8> Bytes;
+	int64 Offset = FirstBlockOffset;
+	while (FSLRawDataCompressedReader::ReadAt(Offset, FSLRawDataCompressed::BlockHeaderSize, Bytes))
+	{
+		uint32 BlockMagic = 0;
+		FSLRawDataBlockInfo Info;
+		{
+			FMemoryReader Reader(Bytes);
+			Reader << BlockMagic;
+			Reader << Info.UncompressedSize;
+			Reader << Info.CompressedSize;
+			Reader << Info.FirstTimestamp;
+			Reader << Info.LastTimestamp;
+		}
+		Info.Offset = Offset;
+
+		// The blocks end at a partially written block or at a partially written index
+		const int64 BlockEnd = Offset + FSLRawDataCompressed::BlockHeaderSize + Info.CompressedSize;
+		if (BlockMagic != FSLRawDataCompressed::BlockMagic || Info.UncompressedSize < 0 || Info.CompressedSize < 0 || BlockEnd > FileSize)
+		{
+			break;
+		}
+		Index.Add(Info);
+		Offset = BlockEnd;
+	}
+
+	// The data of the last block can still be incomplete
+	TArray<uint8> LastBlock;
+	if (Index.Num() > 0 && !FSLRawDataCompressedReader::ReadBlock(Index.Num() - 1, LastBlock))
+	{
+		Index.Pop();
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT(" %s::%d Compressed raw data file without index, recovered %d blocks"),
+		TEXT(__FUNCTION__), __LINE__, Index.Num());
+	bRecovered = true;
+	return true;
+}
+
+// Read bytes at the offset
+bool FSLRawDataCompressedReader::ReadAt(int64 Offset, int32 Size, TArray<uint8>& OutBytes)
+{
+	OutBytes.SetNumUninitialized(Size, false);
+	if (Offset < 0 || Size < 0 || Offset + Size > FileHandle->Size() || !FileHandle->Seek(Offset))
+	{
+		return false;
+	}
+	return Size == 0 || FileHandle->Read(OutBytes.GetData(), Size);
+}
@@ -0,0 +1,232 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataEntityRegistry.h"
+#include "Components/SceneComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+
+// Add entity
+void FSLRawDataEntityRegistry::Add(UObject* Key, USceneComponent* Component, USkeletalMeshComponent* SkelMesh,
+	int32 EntityIndex, float SquaredDistanceThreshold, float MinQuatDot, float SamplingPeriod)
+{
+	if (!Key || !Component || KeyToSlot.Contains(Key))
+	{
+		return;
+	}
+
+	// Infinitely far away, the first distance check always passes
+	const FVector Location(-INFINITY);
+	const FQuat Rotation = FQuat::Identity;
+
+	KeyToSlot.Add(Key, Components.Num());
+	EntityIndexToSlot.Add(EntityIndex, Components.Num());
+	Keys.Add(Key);
+	Components.Add(Component);
+	SkelMeshes.Add(SkelMesh);
+	EntityIndices.Add(EntityIndex);
+	PrevLocations.Add(Location);
+	CurrLocations.Add(Location);
+	PrevRotations.Add(Rotation);
+	CurrRotations.Add(Rotation);
+	// No previous tick pose yet, interpolation starts from the current one
+	const FTransform& ComponentToWorld = Component->GetComponentTransform();
+	LastTickLocations.Add(ComponentToWorld.GetLocation());
+	TickLocations.Add(ComponentToWorld.GetLocation());
+	LastTickRotations.Add(ComponentToWorld.GetRotation());
+	TickRotations.Add(ComponentToWorld.GetRotation());
+	SquaredDistanceThresholds.Add(SquaredDistanceThreshold);
+	MinQuatDots.Add(MinQuatDot);
+	SamplingPeriods.Add(SamplingPeriod);
+	CurrSamplingPeriods.Add(SamplingPeriod);
+	LastSampleTimes.Add(-INFINITY);
+	LastSampleLocations.Add(Location);
+	LastSampleRotations.Add(Rotation);
+	FSLRawDataBoneStates& States = BoneStates[BoneStates.AddDefaulted()];
+	if (SkelMesh)
+	{
+		FSLRawDataEntityRegistry::ResolveBoneIndices(SkelMesh, States.BoneIndices);
+	}
+	bSkeletalMaskDirty = true;
+}
+
+// Remove entity by swapping it with the last one
+bool FSLRawDataEntityRegistry::Remove(UObject* Key)
+{
+	int32 Slot;
+	if (!KeyToSlot.RemoveAndCopyValue(Key, Slot))
+	{
+		return false;
+	}
+
+	EntityIndexToSlot.Remove(EntityIndices[Slot]);
+	Keys.RemoveAtSwap(Slot, 1, false);
+	Components.RemoveAtSwap(Slot, 1, false);
+	SkelMeshes.RemoveAtSwap(Slot, 1, false);
+	EntityIndices.RemoveAtSwap(Slot, 1, false);
+	PrevLocations.RemoveAtSwap(Slot, 1, false);
+	CurrLocations.RemoveAtSwap(Slot, 1, false);
+	PrevRotations.RemoveAtSwap(Slot, 1, false);
+	CurrRotations.RemoveAtSwap(Slot, 1, false);
+	LastTickLocations.RemoveAtSwap(Slot, 1, false);
+	TickLocations.RemoveAtSwap(Slot, 1, false);
+	LastTickRotations.RemoveAtSwap(Slot, 1, false);
+	TickRotations.RemoveAtSwap(Slot, 1, false);
+	SquaredDistanceThresholds.RemoveAtSwap(Slot, 1, false);
+	MinQuatDots.RemoveAtSwap(Slot, 1, false);
+	BoneStates.RemoveAtSwap(Slot, 1, false);
+	SamplingPeriods.RemoveAtSwap(Slot, 1, false);
+	CurrSamplingPeriods.RemoveAtSwap(Slot, 1, false);
+	LastSampleTimes.RemoveAtSwap(Slot, 1, false);
+	LastSampleLocations.RemoveAtSwap(Slot, 1, false);
+	LastSampleRotations.RemoveAtSwap(Slot, 1, false);
+	bSkeletalMaskDirty = true;
+
+	// The last entity moved into the freed slot
+	if (Keys.IsValidIndex(Slot))
+	{
+		KeyToSlot[Keys[Slot]] = Slot;
+		EntityIndexToSlot[EntityIndices[Slot]] = Slot;
+	}
+	return true;
+}
+
+// Read the current poses of all the entities
+void FSLRawDataEntityRegistry::UpdateCurrPoses()
+{
+	const int32 NumEntities = Components.Num();
+	for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+	{
+		const FTransform& ComponentToWorld = Components[Idx]->GetComponentTransform();
+		CurrLocations[Idx] = ComponentToWorld.GetLocation();
+		CurrRotations[Idx] = ComponentToWorld.GetRotation();
+	}
+}
+
+// Read the current poses of the entities with their bit set in the mask
+void FSLRawDataEntityRegistry::UpdateCurrPoses(const TArray<uint32>& SlotMask)
+{
+	const int32 NumEntities = Components.Num();
+	for (int32 WordIdx = 0; WordIdx < SlotMask.Num(); ++WordIdx)
+	{
+		uint32 Word = SlotMask[WordIdx];
+		while (Word)
+		{
+			const int32 Idx = (WordIdx << 5) + FMath::CountTrailingZeros(Word);
+			Word &= Word - 1;
+			if (Idx >= NumEntities)
+			{
+				return;
+			}
+
+			const FTransform& ComponentToWorld = Components[Idx]->GetComponentTransform();
+			CurrLocations[Idx] = ComponentToWorld.GetLocation();
+			CurrRotations[Idx] = ComponentToWorld.GetRotation();
+		}
+	}
+}
+
+// Keep the poses of the previous tick and read the ones of the current tick
+void FSLRawDataEntityRegistry::ReadTickPoses()
+{
+	Swap(LastTickLocations, TickLocations);
+	Swap(LastTickRotations, TickRotations);
+
+	const int32 NumEntities = Components.Num();
+	for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+	{
+		const FTransform& ComponentToWorld = Components[Idx]->GetComponentTransform();
+		TickLocations[Idx] = ComponentToWorld.GetLocation();
+		TickRotations[Idx] = ComponentToWorld.GetRotation();
+	}
+}
+
+// Set the current poses between the previous and the current tick poses
+void FSLRawDataEntityRegistry::InterpolateCurrPoses(float Alpha, const TArray<uint32>* SlotMask)
+{
+	const int32 NumEntities = Components.Num();
+	for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+	{
+		if (SlotMask && ((*SlotMask)[Idx >> 5] & (1u << (Idx & 31))) == 0)
+		{
+			continue;
+		}
+		CurrLocations[Idx] = FMath::Lerp(LastTickLocations[Idx], TickLocations[Idx], Alpha);
+		CurrRotations[Idx] = FQuat::Slerp(LastTickRotations[Idx], TickRotations[Idx], Alpha);
+	}
+}
+
+// Get the mask of the skeletal entities
+const TArray<uint32>& FSLRawDataEntityRegistry::GetSkeletalMask()
+{
+	// Entities are rarely added or removed, rebuild only then
+	if (bSkeletalMaskDirty)
+	{
+		const int32 NumEntities = SkelMeshes.Num();
+		SkeletalMask.Reset();
+		SkeletalMask.AddZeroed((NumEntities + 31) / 32);
+		for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+		{
+			if (SkelMeshes[Idx])
+			{
+				SkeletalMask[Idx >> 5] |= 1u << (Idx & 31);
+			}
+		}
+		bSkeletalMaskDirty = false;
+	}
+	return SkeletalMask;
+}
+
+// Resolve the bone names of the skeletal mesh to indexes in its pose transforms
+void FSLRawDataEntityRegistry::ResolveBoneIndices(USkeletalMeshComponent* SkelMesh, TArray<int32>& OutBoneIndices)
+{
+	OutBoneIndices.Reset();
+	TArray<FName> BoneNames;
+	SkelMesh->GetBoneNames(BoneNames);
+	OutBoneIndices.Reserve(BoneNames.Num());
+
+	// Slave components read their pose from the master component
+	const bool bUsesMasterPose = SkelMesh->MasterPoseComponent.IsValid();
+	for (const auto& BoneName : BoneNames)
+	{
+		const int32 BoneIndex = SkelMesh->GetBoneIndex(BoneName);
+		if (bUsesMasterPose)
+		{
+			OutBoneIndices.Add(SkelMesh->GetMasterBoneMap().IsValidIndex(BoneIndex) ?
+				SkelMesh->GetMasterBoneMap()[BoneIndex] : INDEX_NONE);
+		}
+		else
+		{
+			OutBoneIndices.Add(BoneIndex);
+		}
+	}
+}
+
+// Read the world poses of the bones in one pass over the component space transforms
+void FSLRawDataEntityRegistry::ReadBonePoses(USkeletalMeshComponent* SkelMesh, const TArray<int32>& BoneIndices,
+	TArray<FVector>& OutLocations, TArray<FQuat>& OutRotations)
+{
+	FSLRawDataEntityRegistry::ReadBonePoses(SkelMesh, BoneIndices, SkelMesh->GetComponentTransform(),
+		OutLocations, OutRotations);
+}
+
+// Read the world poses of the bones relative to the given skeletal mesh component transform
+void FSLRawDataEntityRegistry::ReadBonePoses(USkeletalMeshComponent* SkelMesh, const TArray<int32>& BoneIndices,
+	const FTransform& ComponentToWorld, TArray<FVector>& OutLocations, TArray<FQuat>& OutRotations)
+{
+	const USkinnedMeshComponent* PoseComponent = SkelMesh->MasterPoseComponent.IsValid() ?
+		SkelMesh->MasterPoseComponent.Get() : SkelMesh;
+	const TArray<FTransform>& ComponentSpaceTransforms = PoseComponent->GetComponentSpaceTransforms();
+
+	const int32 NumBones = BoneIndices.Num();
+	OutLocations.SetNumUninitialized(NumBones, false);
+	OutRotations.SetNumUninitialized(NumBones, false);
+	for (int32 Idx = 0; Idx < NumBones; ++Idx)
+	{
+		// Bones missing from the pose (e.g. after a mesh change) fall back to the component transform
+		const int32 BoneIndex = BoneIndices[Idx];
+		const FTransform BoneToWorld = ComponentSpaceTransforms.IsValidIndex(BoneIndex) ?
+			ComponentSpaceTransforms[BoneIndex] * ComponentToWorld : ComponentToWorld;
+		OutLocations[Idx] = BoneToWorld.GetLocation();
+		OutRotations[Idx] = BoneToWorld.GetRotation();
+	}
+}
@@ -0,0 +1,857 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataEpisodeReader.h"
+#include "SLRawDataFraming.h"
+#include "SLRawDataJsonScanner.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Serialization/BufferReader.h"
+#include "MemoryWriter.h"
+#include "MemoryReader.h"
+#include "FileHelper.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Index file identifier ("SLRI") and layout version (2 adds the json entities and the pose checkpoints)
+static const uint32 IndexMagic = 0x49524C53;
+static const uint32 IndexVersion = 2;
+
+// Number of json frames parsed in parallel for their names
+static const int32 JsonNamesPerBatch = 4096;
+
+// Names of the actors and of their bones in a json frame
+struct FSLJsonFrameNames
+{
+	bool bIsValid;
+	TArray<FString> ActorNames;
+	TArray<TArray<FString>> BoneNames;
+};
+
+// Read the names of the json frame (thread safe, no shared state)
+static bool ReadJsonFrameNames(const uint8* Bytes, int32 Size, FSLJsonFrameNames& OutNames)
+{
+	OutNames.ActorNames.Reset();
+	OutNames.BoneNames.Reset();
+
+	FUTF8ToTCHAR Converter((const ANSICHAR*)Bytes, Size);
+	const FString JsonString(Converter.Length(), Converter.Get());
+	TSharedPtr<FJsonObject> FrameObject;
+	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
+	const TArray<TSharedPtr<FJsonValue>>* Actors = nullptr;
+	if (!FJsonSerializer::Deserialize(JsonReader, FrameObject) || !FrameObject.IsValid() ||
+		!FrameObject->TryGetArrayField("actors", Actors))
+	{
+		return false;
+	}
+
+	for (const auto& ActorItr : *Actors)
+	{
+		const TSharedPtr<FJsonObject> ActorObject = ActorItr->AsObject();
+		FString& ActorName = OutNames.ActorNames[OutNames.ActorNames.AddDefaulted()];
+		TArray<FString>& BoneNames = OutNames.BoneNames[OutNames.BoneNames.AddDefaulted()];
+		if (!ActorObject.IsValid() || !ActorObject->TryGetStringField("name", ActorName))
+		{
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* Bones = nullptr;
+		if (ActorObject->TryGetArrayField("bones", Bones))
+		{
+			for (const auto& BoneItr : *Bones)
+			{
+				const TSharedPtr<FJsonObject> BoneObject = BoneItr->AsObject();
+				if (!BoneObject.IsValid() || !BoneObject->TryGetStringField("name", BoneNames[BoneNames.AddDefaulted()]))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Constructor
+FSLRawDataEpisodeReader::FSLRawDataEpisodeReader()
+	: MappedHandle(nullptr), MappedRegion(nullptr), Data(nullptr), DataSize(0),
+	bIsFramed(false), bIsBinary(false), BinaryVersion(0), LastDecodedFrame(INDEX_NONE)
+{
+}
+
+// Destructor
+FSLRawDataEpisodeReader::~FSLRawDataEpisodeReader()
+{
+	FSLRawDataEpisodeReader::Close();
+}
+
+// Map the file and build or load its index
+bool FSLRawDataEpisodeReader::Open(const FString& Path, bool bSaveIndex)
+{
+	FSLRawDataEpisodeReader::Close();
+
+	// Map the whole file, load it if the platform does not support mapping
+	MappedHandle = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path);
+	if (MappedHandle && MappedHandle->GetFileSize() > 0)
+	{
+		MappedRegion = MappedHandle->MapRegion(0, MappedHandle->GetFileSize());
+		if (MappedRegion)
+		{
+			Data = MappedRegion->GetMappedPtr();
+			DataSize = MappedRegion->GetMappedSize();
+		}
+	}
+	if (!Data)
+	{
+		if (!FFileHelper::LoadFileToArray(LoadedBytes, *Path) || LoadedBytes.Num() == 0)
+		{
+			FSLRawDataEpisodeReader::Close();
+			return false;
+		}
+		Data = LoadedBytes.GetData();
+		DataSize = LoadedBytes.Num();
+	}
+
+	// Binary files start with the header, framed binary files have it in the first record
+	int64 StreamOffset = 0;
+	int64 StreamSize = DataSize;
+	bIsFramed = FSLRawDataFramed::HasHeader(Data, DataSize);
+	if (bIsFramed)
+	{
+		int32 PayloadSize = 0;
+		StreamSize = 0;
+		if (FSLRawDataFramed::ReadRecord(Data, DataSize, FSLRawDataFramed::HeaderSize, StreamOffset, PayloadSize))
+		{
+			StreamSize = PayloadSize;
+		}
+	}
+	{
+		FBufferReader Reader((void*)(Data + StreamOffset), StreamSize, false);
+		bIsBinary = StreamSize >= FSLRawDataBinary::HeaderSize && FSLRawDataBinaryReader::ReadHeader(Reader, BinaryVersion);
+	}
+
+	const FString IndexPath = Path + ".idx";
+	if (FSLRawDataEpisodeReader::LoadIndex(IndexPath))
+	{
+		// The entity chunks are small, read them from their offsets (the json entities are in the index)
+		for (const int64 Offset : EntityChunkOffsets)
+		{
+			FBufferReader Reader((void*)Data, DataSize, false);
+			Reader.Seek(Offset + 1);
+			FSLRawDataEntityDesc Entity;
+			if (!FSLRawDataBinaryReader::ReadEntityChunk(Reader, BinaryVersion, Entity))
+			{
+				FSLRawDataEpisodeReader::Close();
+				return false;
+			}
+			FSLRawDataBinaryReader::AddEntity(Entities, Entity);
+		}
+	}
+	else
+	{
+		if (!FSLRawDataEpisodeReader::BuildIndex())
+		{
+			FSLRawDataEpisodeReader::Close();
+			return false;
+		}
+		if (bSaveIndex)
+		{
+			FSLRawDataEpisodeReader::SaveIndex(IndexPath);
+		}
+	}
+
+	for (const auto& EntityItr : Entities)
+	{
+		EntityNameToIndex.Add(EntityItr.UniqueName, EntityItr.EntityIndex);
+	}
+	return true;
+}
+
+// Unmap the file
+void FSLRawDataEpisodeReader::Close()
+{
+	if (MappedRegion)
+	{
+		delete MappedRegion;
+		MappedRegion = nullptr;
+	}
+	if (MappedHandle)
+	{
+		delete MappedHandle;
+		MappedHandle = nullptr;
+	}
+	LoadedBytes.Empty();
+	Data = nullptr;
+	DataSize = 0;
+	bIsFramed = false;
+	bIsBinary = false;
+	BinaryVersion = 0;
+	Index.Empty();
+	EntityChunkOffsets.Empty();
+	Entities.Empty();
+	EntityNameToIndex.Empty();
+	BoneNameToIndex.Empty();
+	PoseCheckpoints.Empty();
+	PrevPoses.Empty();
+	LastDecodedFrame = INDEX_NONE;
+}
+
+// Get the index of the entity
+int32 FSLRawDataEpisodeReader::FindEntity(const FString& UniqueName) const
+{
+	const int32* EntityIndex = EntityNameToIndex.Find(UniqueName);
+	return EntityIndex ? *EntityIndex : INDEX_NONE;
+}
+
+// Index of the last frame at or before the time
+int32 FSLRawDataEpisodeReader::FindFrame(double Time) const
+{
+	// First frame after the time
+	int32 First = 0;
+	int32 Last = Index.Num();
+	while (First < Last)
+	{
+		const int32 Mid = (First + Last) / 2;
+		if (Index[Mid].Timestamp <= Time)
+		{
+			First = Mid + 1;
+		}
+		else
+		{
+			Last = Mid;
+		}
+	}
+	return First - 1;
+}
+
+// Read the frame
+bool FSLRawDataEpisodeReader::ReadFrame(int32 FrameIndex, FSLRawDataFrame& OutFrame)
+{
+	if (!Index.IsValidIndex(FrameIndex))
+	{
+		return false;
+	}
+	return bIsBinary ? FSLRawDataEpisodeReader::ReadBinaryFrame(FrameIndex, OutFrame)
+		: FSLRawDataEpisodeReader::ReadJsonFrame(FrameIndex, OutFrame);
+}
+
+// Read all the frames with timestamps in [StartTime, EndTime]
+bool FSLRawDataEpisodeReader::ReadFrames(double StartTime, double EndTime, TArray<FSLRawDataFrame>& OutFrames)
+{
+	OutFrames.Reset();
+	int32 FrameIndex = FSLRawDataEpisodeReader::FindFrame(StartTime);
+	if (FrameIndex == INDEX_NONE || Index[FrameIndex].Timestamp < StartTime)
+	{
+		FrameIndex++;
+	}
+
+	for (; FrameIndex < Index.Num() && Index[FrameIndex].Timestamp <= EndTime; ++FrameIndex)
+	{
+		if (!FSLRawDataEpisodeReader::ReadFrame(FrameIndex, OutFrames[OutFrames.AddDefaulted()]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Get the last written pose of the entity (or of one of its bones) at or before the time
+bool FSLRawDataEpisodeReader::GetPose(const FString& UniqueName, double Time, FSLRawDataPose& OutPose, const FString& BoneName)
+{
+	const int32 LastFrame = FSLRawDataEpisodeReader::FindFrame(Time);
+	const int32 EntityIndex = FSLRawDataEpisodeReader::FindEntity(UniqueName);
+	if (LastFrame == INDEX_NONE || EntityIndex == INDEX_NONE || !PoseCheckpoints.IsValidIndex(EntityIndex))
+	{
+		return false;
+	}
+	const int32 BoneIndex = BoneName.IsEmpty() ? INDEX_NONE : Entities[EntityIndex].BoneNames.IndexOfByKey(BoneName);
+	if ((!BoneName.IsEmpty() && BoneIndex == INDEX_NONE) || !PoseCheckpoints[EntityIndex].LastFrames.IsValidIndex(BoneIndex + 1))
+	{
+		return false;
+	}
+	const TArray<int32>& PoseFrames = PoseCheckpoints[EntityIndex].LastFrames[BoneIndex + 1];
+
+	// First checkpoint in or after the interval of the time
+	const int32 IntervalStart = LastFrame - LastFrame % CheckpointInterval;
+	int32 Checkpoint = 0;
+	int32 Last = PoseFrames.Num();
+	while (Checkpoint < Last)
+	{
+		const int32 Mid = (Checkpoint + Last) / 2;
+		if (PoseFrames[Mid] < IntervalStart)
+		{
+			Checkpoint = Mid + 1;
+		}
+		else
+		{
+			Last = Mid;
+		}
+	}
+
+	FSLRawDataFrame Frame;
+	if (Checkpoint < PoseFrames.Num() && PoseFrames[Checkpoint] <= LastFrame)
+	{
+		// The last frame of the interval holding the pose is not after the time
+		return FSLRawDataEpisodeReader::ReadFrame(PoseFrames[Checkpoint], Frame) &&
+			FSLRawDataEpisodeReader::FindPoseInFrame(Frame, UniqueName, BoneName, OutPose);
+	}
+	if (Checkpoint < PoseFrames.Num() && PoseFrames[Checkpoint] < IntervalStart + CheckpointInterval)
+	{
+		// Also written after the time in the interval, its frames up to the time are searched
+		if (bIsBinary && Data[Index[LastFrame].Offset] == FSLRawDataBinary::DeltaFrameChunk)
+		{
+			// Delta frames can only be decoded in order
+			bool bFound = false;
+			for (int32 FrameIndex = IntervalStart; FrameIndex <= LastFrame; ++FrameIndex)
+			{
+				if (!FSLRawDataEpisodeReader::ReadFrame(FrameIndex, Frame))
+				{
+					return false;
+				}
+				bFound |= FSLRawDataEpisodeReader::FindPoseInFrame(Frame, UniqueName, BoneName, OutPose);
+			}
+			if (bFound)
+			{
+				return true;
+			}
+		}
+		else
+		{
+			// The latest frame holding the pose ends the search
+			for (int32 FrameIndex = LastFrame; FrameIndex >= IntervalStart; --FrameIndex)
+			{
+				if (!FSLRawDataEpisodeReader::ReadFrame(FrameIndex, Frame))
+				{
+					return false;
+				}
+				if (FSLRawDataEpisodeReader::FindPoseInFrame(Frame, UniqueName, BoneName, OutPose))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	// Last frame holding the pose before the interval
+	return Checkpoint > 0 && FSLRawDataEpisodeReader::ReadFrame(PoseFrames[Checkpoint - 1], Frame) &&
+		FSLRawDataEpisodeReader::FindPoseInFrame(Frame, UniqueName, BoneName, OutPose);
+}
+
+// Get the bytes of the frame in the mapped file
+bool FSLRawDataEpisodeReader::GetFrameBytes(int32 FrameIndex, const uint8*& OutBytes, int32& OutSize) const
+{
+	if (!Index.IsValidIndex(FrameIndex))
+	{
+		return false;
+	}
+	OutBytes = Data + Index[FrameIndex].Offset;
+	OutSize = Index[FrameIndex].Size;
+	return true;
+}
+
+// Build the index by scanning the file
+bool FSLRawDataEpisodeReader::BuildIndex()
+{
+	Index.Reset();
+	EntityChunkOffsets.Reset();
+	Entities.Reset();
+	EntityNameToIndex.Reset();
+	BoneNameToIndex.Reset();
+	PoseCheckpoints.Reset();
+	bool bIndexed = false;
+	if (bIsFramed)
+	{
+		bIndexed = FSLRawDataEpisodeReader::BuildFramedIndex();
+	}
+	else
+	{
+		bIndexed = bIsBinary ? FSLRawDataEpisodeReader::BuildBinaryIndex() : FSLRawDataEpisodeReader::BuildJsonIndex();
+	}
+
+	// The binary frames are decoded while indexed, the json ones are parsed again for their names
+	return bIndexed && (bIsBinary || FSLRawDataEpisodeReader::BuildJsonCheckpoints());
+}
+
+// Build the index of a json file
+bool FSLRawDataEpisodeReader::BuildJsonIndex()
+{
+	// Frames are found on all cores, an unfinished last frame (e.g. after a crash) is left out
+	return FSLRawDataJsonScanner::FindFrames(Data, DataSize, Index);
+}
+
+// Add the json frame to the index
+bool FSLRawDataEpisodeReader::IndexJsonFrame(int64 Start, int64 Size, int32& InOutLastKeyframe)
+{
+	FSLRawDataFrameIndexEntry Entry;
+	bool bIsKeyframe = false;
+	if (!FSLRawDataJsonScanner::ReadFrameHeader(Data + Start, Size, Entry.Timestamp, bIsKeyframe))
+	{
+		return false;
+	}
+	if (bIsKeyframe)
+	{
+		InOutLastKeyframe = Index.Num();
+	}
+	Entry.Offset = Start;
+	Entry.Size = (int32)Size;
+	Entry.KeyframeIndex = InOutLastKeyframe;
+	Index.Add(Entry);
+	return true;
+}
+
+// Build the index of a binary file
+bool FSLRawDataEpisodeReader::BuildBinaryIndex()
+{
+	FBufferReader Reader((void*)Data, DataSize, false);
+	if (!FSLRawDataBinaryReader::ReadHeader(Reader, BinaryVersion))
+	{
+		return false;
+	}
+
+	// An unfinished last chunk (e.g. after a crash) is left out
+	TArray<TArray<FSLRawDataQuantizedPose>> ScanPoses;
+	int32 LastKeyframe = 0;
+	FSLRawDataEpisodeReader::IndexBinaryChunks(FSLRawDataBinary::HeaderSize, DataSize, ScanPoses, LastKeyframe, false);
+	return true;
+}
+
+// Add the binary chunks of the range to the index
+bool FSLRawDataEpisodeReader::IndexBinaryChunks(int64 Begin, int64 End, TArray<TArray<FSLRawDataQuantizedPose>>& ScanPoses,
+	int32& InOutLastKeyframe, bool bSkipUntilKeyframe)
+{
+	// The frames are decoded once to find their size
+	FBufferReader Reader((void*)(Data + Begin), End - Begin, false);
+	FSLRawDataFrame Frame;
+	while (!Reader.AtEnd())
+	{
+		const int64 Offset = Begin + Reader.Tell();
+		uint8 ChunkType = 0;
+		Reader << ChunkType;
+
+		if (ChunkType == FSLRawDataBinary::EntityChunk)
+		{
+			FSLRawDataEntityDesc Entity;
+			if (!FSLRawDataBinaryReader::ReadEntityChunk(Reader, BinaryVersion, Entity))
+			{
+				return false;
+			}
+			FSLRawDataBinaryReader::AddEntity(Entities, Entity);
+			EntityChunkOffsets.Add(Offset);
+		}
+		else
+		{
+			if (!FSLRawDataBinaryReader::ReadFrameChunk(Reader, ChunkType, BinaryVersion, Entities, ScanPoses, Frame))
+			{
+				return false;
+			}
+
+			// Delta frames after a lost record cannot be decoded before the next keyframe
+			if (bSkipUntilKeyframe && ChunkType == FSLRawDataBinary::DeltaFrameChunk && !Frame.bIsKeyframe)
+			{
+				continue;
+			}
+			if (Frame.bIsKeyframe)
+			{
+				InOutLastKeyframe = Index.Num();
+			}
+
+			FSLRawDataFrameIndexEntry Entry;
+			Entry.Timestamp = Frame.Timestamp;
+			Entry.Offset = Offset;
+			Entry.Size = (int32)(Begin + Reader.Tell() - Offset);
+			Entry.KeyframeIndex = InOutLastKeyframe;
+			FSLRawDataEpisodeReader::AddPoseCheckpoints(Index.Add(Entry), Frame);
+		}
+	}
+	return true;
+}
+
+// Build the index of a framed file
+bool FSLRawDataEpisodeReader::BuildFramedIndex()
+{
+	TArray<TArray<FSLRawDataQuantizedPose>> ScanPoses;
+	int32 LastKeyframe = 0;
+	bool bRecordLost = false;
+	int64 Offset = FSLRawDataFramed::HeaderSize;
+	while (Offset < DataSize)
+	{
+		int64 PayloadOffset = 0;
+		int32 PayloadSize = 0;
+		if (!FSLRawDataFramed::ReadRecord(Data, DataSize, Offset, PayloadOffset, PayloadSize))
+		{
+			// Corrupted or truncated record, continue with the next valid one
+			Offset = FSLRawDataFramed::FindRecord(Data, DataSize, Offset + 1);
+			bRecordLost = true;
+			continue;
+		}
+		Offset = PayloadOffset + PayloadSize;
+
+		if (bIsBinary)
+		{
+			// Skip the header of the header record
+			int64 Begin = PayloadOffset;
+			uint32 PayloadMagic = 0;
+			if (PayloadSize >= FSLRawDataBinary::HeaderSize)
+			{
+				FMemory::Memcpy(&PayloadMagic, Data + Begin, sizeof(uint32));
+			}
+			if (PayloadMagic == FSLRawDataBinary::Magic)
+			{
+				Begin += FSLRawDataBinary::HeaderSize;
+			}
+
+			const int32 PrevKeyframe = LastKeyframe;
+			if (!FSLRawDataEpisodeReader::IndexBinaryChunks(Begin, Offset, ScanPoses, LastKeyframe, bRecordLost))
+			{
+				bRecordLost = true;
+			}
+			else if (LastKeyframe != PrevKeyframe)
+			{
+				// Decoding can start over at the keyframe
+				bRecordLost = false;
+			}
+		}
+		else if (!FSLRawDataEpisodeReader::IndexJsonFrame(PayloadOffset, PayloadSize, LastKeyframe))
+		{
+			UE_LOG(LogTemp, Warning, TEXT(" %s::%d Skipping a record which is not a frame at %lld"), TEXT(__FUNCTION__), __LINE__, PayloadOffset);
+		}
+	}
+	return true;
+}
+
+// Read the names of the indexed json frames on all cores
+bool FSLRawDataEpisodeReader::BuildJsonCheckpoints()
+{
+	// The names are given indices in file order, the same as when the frames are read
+	TArray<FSLJsonFrameNames> FrameNames;
+	FrameNames.SetNum(FMath::Min(JsonNamesPerBatch, Index.Num()));
+	for (int32 BatchStart = 0; BatchStart < Index.Num(); BatchStart += JsonNamesPerBatch)
+	{
+		const int32 NumFrames = FMath::Min(JsonNamesPerBatch, Index.Num() - BatchStart);
+		ParallelFor(NumFrames, [&](int32 Idx)
+		{
+			const FSLRawDataFrameIndexEntry& Entry = Index[BatchStart + Idx];
+			FrameNames[Idx].bIsValid = ReadJsonFrameNames(Data + Entry.Offset, Entry.Size, FrameNames[Idx]);
+		});
+
+		for (int32 Idx = 0; Idx < NumFrames; ++Idx)
+		{
+			// Unreadable frames fail again when read
+			const FSLJsonFrameNames& Names = FrameNames[Idx];
+			if (!Names.bIsValid)
+			{
+				continue;
+			}
+			for (int32 ActorIdx = 0; ActorIdx < Names.ActorNames.Num(); ++ActorIdx)
+			{
+				const int32 EntityIndex = FSLRawDataEpisodeReader::FindOrAddEntity(Names.ActorNames[ActorIdx]);
+				FSLRawDataEpisodeReader::AddPoseCheckpoint(BatchStart + Idx, EntityIndex, INDEX_NONE);
+				for (const auto& BoneNameItr : Names.BoneNames[ActorIdx])
+				{
+					FSLRawDataEpisodeReader::AddPoseCheckpoint(BatchStart + Idx, EntityIndex,
+						FSLRawDataEpisodeReader::FindOrAddBone(EntityIndex, BoneNameItr));
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Add the poses of the frame to the checkpoints
+void FSLRawDataEpisodeReader::AddPoseCheckpoints(int32 FrameIndex, const FSLRawDataFrame& Frame)
+{
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		FSLRawDataEpisodeReader::AddPoseCheckpoint(FrameIndex, PoseItr.EntityIndex, PoseItr.BoneIndex);
+	}
+}
+
+// Add the pose to the checkpoints
+void FSLRawDataEpisodeReader::AddPoseCheckpoint(int32 FrameIndex, int32 EntityIndex, int32 BoneIndex)
+{
+	if (!Entities.IsValidIndex(EntityIndex) || BoneIndex < INDEX_NONE || BoneIndex >= Entities[EntityIndex].BoneNames.Num())
+	{
+		return;
+	}
+	if (PoseCheckpoints.Num() <= EntityIndex)
+	{
+		PoseCheckpoints.SetNum(EntityIndex + 1);
+	}
+	TArray<TArray<int32>>& LastFrames = PoseCheckpoints[EntityIndex].LastFrames;
+	if (LastFrames.Num() <= BoneIndex + 1)
+	{
+		LastFrames.SetNum(BoneIndex + 2);
+	}
+
+	// Frames are added in order, a later frame of the same interval replaces the previous one
+	TArray<int32>& PoseFrames = LastFrames[BoneIndex + 1];
+	if (PoseFrames.Num() > 0 && PoseFrames.Last() / CheckpointInterval == FrameIndex / CheckpointInterval)
+	{
+		PoseFrames.Last() = FrameIndex;
+	}
+	else
+	{
+		PoseFrames.Add(FrameIndex);
+	}
+}
+
+// Load the index saved next to the file
+bool FSLRawDataEpisodeReader::LoadIndex(const FString& IndexPath)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *IndexPath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int64 IndexedSize = 0;
+	Reader << Magic;
+	Reader << Version;
+	Reader << IndexedSize;
+	if (Reader.IsError() || Magic != IndexMagic || Version != IndexVersion || IndexedSize != DataSize)
+	{
+		// The file changed since it was indexed
+		return false;
+	}
+
+	Reader << Index;
+	Reader << EntityChunkOffsets;
+
+	// The binary entities are read from their chunks
+	if (!bIsBinary)
+	{
+		int32 NumEntities = 0;
+		Reader << NumEntities;
+		for (int32 EntityIdx = 0; EntityIdx < NumEntities && !Reader.IsError(); ++EntityIdx)
+		{
+			FString UniqueName;
+			TArray<FString> BoneNames;
+			Reader << UniqueName;
+			Reader << BoneNames;
+			const int32 EntityIndex = FSLRawDataEpisodeReader::FindOrAddEntity(UniqueName);
+			for (const auto& BoneNameItr : BoneNames)
+			{
+				FSLRawDataEpisodeReader::FindOrAddBone(EntityIndex, BoneNameItr);
+			}
+		}
+	}
+	Reader << PoseCheckpoints;
+
+	if (Reader.IsError())
+	{
+		Index.Reset();
+		EntityChunkOffsets.Reset();
+		Entities.Reset();
+		EntityNameToIndex.Reset();
+		BoneNameToIndex.Reset();
+		PoseCheckpoints.Reset();
+		return false;
+	}
+	return true;
+}
+
+// Save the index next to the file
+bool FSLRawDataEpisodeReader::SaveIndex(const FString& IndexPath) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = IndexMagic;
+	uint32 Version = IndexVersion;
+	int64 IndexedSize = DataSize;
+	Writer << Magic;
+	Writer << Version;
+	Writer << IndexedSize;
+	Writer << const_cast<TArray<FSLRawDataFrameIndexEntry>&>(Index);
+	Writer << const_cast<TArray<int64>&>(EntityChunkOffsets);
+	if (!bIsBinary)
+	{
+		int32 NumEntities = Entities.Num();
+		Writer << NumEntities;
+		for (const auto& EntityItr : Entities)
+		{
+			Writer << const_cast<FString&>(EntityItr.UniqueName);
+			Writer << const_cast<TArray<FString>&>(EntityItr.BoneNames);
+		}
+	}
+	Writer << const_cast<TArray<FSLRawDataPoseCheckpoints>&>(PoseCheckpoints);
+	return FFileHelper::SaveArrayToFile(Bytes, *IndexPath);
+}
+
+// Parse the frame as json
+bool FSLRawDataEpisodeReader::ReadJsonFrame(int32 FrameIndex, FSLRawDataFrame& OutFrame)
+{
+	const FSLRawDataFrameIndexEntry& Entry = Index[FrameIndex];
+	FUTF8ToTCHAR Converter((const ANSICHAR*)(Data + Entry.Offset), Entry.Size);
+	const FString JsonString(Converter.Length(), Converter.Get());
+
+	TSharedPtr<FJsonObject> FrameObject;
+	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
+	if (!FJsonSerializer::Deserialize(JsonReader, FrameObject) || !FrameObject.IsValid())
+	{
+		return false;
+	}
+
+	OutFrame.Reset();
+	OutFrame.Timestamp = (float)Entry.Timestamp;
+	FrameObject->TryGetBoolField("keyframe", OutFrame.bIsKeyframe);
+
+	const TArray<TSharedPtr<FJsonValue>>* Actors = nullptr;
+	if (!FrameObject->TryGetArrayField("actors", Actors))
+	{
+		return false;
+	}
+
+	for (const auto& ActorItr : *Actors)
+	{
+		const TSharedPtr<FJsonObject> ActorObject = ActorItr->AsObject();
+		FString Name;
+		FVector Location;
+		FQuat Rotation;
+		if (!ActorObject.IsValid() || !ActorObject->TryGetStringField("name", Name) ||
+			!FSLRawDataEpisodeReader::ReadJsonPose(ActorObject, Location, Rotation))
+		{
+			return false;
+		}
+		const int32 EntityIndex = FSLRawDataEpisodeReader::FindOrAddEntity(Name);
+		OutFrame.Poses.Emplace(EntityIndex, INDEX_NONE, Location, Rotation);
+
+		const TArray<TSharedPtr<FJsonValue>>* Bones = nullptr;
+		if (ActorObject->TryGetArrayField("bones", Bones))
+		{
+			for (const auto& BoneItr : *Bones)
+			{
+				const TSharedPtr<FJsonObject> BoneObject = BoneItr->AsObject();
+				if (!BoneObject.IsValid() || !BoneObject->TryGetStringField("name", Name) ||
+					!FSLRawDataEpisodeReader::ReadJsonPose(BoneObject, Location, Rotation))
+				{
+					return false;
+				}
+				OutFrame.Poses.Emplace(EntityIndex, FSLRawDataEpisodeReader::FindOrAddBone(EntityIndex, Name), Location, Rotation);
+			}
+		}
+	}
+	return true;
+}
+
+// Decode the binary frame
+bool FSLRawDataEpisodeReader::ReadBinaryFrame(int32 FrameIndex, FSLRawDataFrame& OutFrame)
+{
+	const FSLRawDataFrameIndexEntry& Entry = Index[FrameIndex];
+
+	// Delta frames need the previous poses, continue after the last decoded frame or restart at the keyframe
+	if (Data[Entry.Offset] == FSLRawDataBinary::DeltaFrameChunk)
+	{
+		const bool bContinue = LastDecodedFrame != INDEX_NONE &&
+			LastDecodedFrame < FrameIndex && LastDecodedFrame >= Entry.KeyframeIndex;
+		int32 Start = bContinue ? LastDecodedFrame + 1 : Entry.KeyframeIndex;
+		if (!bContinue)
+		{
+			PrevPoses.Reset();
+		}
+		for (; Start < FrameIndex; ++Start)
+		{
+			FBufferReader Reader((void*)Data, DataSize, false);
+			Reader.Seek(Index[Start].Offset);
+			uint8 ChunkType = 0;
+			Reader << ChunkType;
+			if (!FSLRawDataBinaryReader::ReadFrameChunk(Reader, ChunkType, BinaryVersion, Entities, PrevPoses, OutFrame))
+			{
+				LastDecodedFrame = INDEX_NONE;
+				return false;
+			}
+		}
+	}
+
+	FBufferReader Reader((void*)Data, DataSize, false);
+	Reader.Seek(Entry.Offset);
+	uint8 ChunkType = 0;
+	Reader << ChunkType;
+	if (!FSLRawDataBinaryReader::ReadFrameChunk(Reader, ChunkType, BinaryVersion, Entities, PrevPoses, OutFrame))
+	{
+		LastDecodedFrame = INDEX_NONE;
+		return false;
+	}
+	LastDecodedFrame = FrameIndex;
+	return true;
+}
+
+// Get the pose of the entity (or of its bone) in the frame
+bool FSLRawDataEpisodeReader::FindPoseInFrame(const FSLRawDataFrame& Frame, const FString& UniqueName, const FString& BoneName,
+	FSLRawDataPose& OutPose) const
+{
+	// Json entities and bones are only known once read
+	const int32 EntityIndex = FSLRawDataEpisodeReader::FindEntity(UniqueName);
+	if (EntityIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	const int32 BoneIndex = BoneName.IsEmpty() ? INDEX_NONE : Entities[EntityIndex].BoneNames.IndexOfByKey(BoneName);
+	if (!BoneName.IsEmpty() && BoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	bool bFound = false;
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		if (PoseItr.EntityIndex == EntityIndex && PoseItr.BoneIndex == BoneIndex)
+		{
+			OutPose = PoseItr;
+			bFound = true;
+		}
+	}
+	return bFound;
+}
+
+// Get the index of the entity, added if unknown
+int32 FSLRawDataEpisodeReader::FindOrAddEntity(const FString& UniqueName)
+{
+	if (const int32* EntityIndex = EntityNameToIndex.Find(UniqueName))
+	{
+		return *EntityIndex;
+	}
+	const int32 EntityIndex = Entities.Emplace(Entities.Num(), UniqueName);
+	EntityNameToIndex.Add(UniqueName, EntityIndex);
+	return EntityIndex;
+}
+
+// Get the index of the bone of the entity, added if unknown
+int32 FSLRawDataEpisodeReader::FindOrAddBone(int32 EntityIndex, const FString& BoneName)
+{
+	if (BoneNameToIndex.Num() <= EntityIndex)
+	{
+		BoneNameToIndex.SetNum(EntityIndex + 1);
+	}
+	if (const int32* BoneIndex = BoneNameToIndex[EntityIndex].Find(BoneName))
+	{
+		return *BoneIndex;
+	}
+	const int32 BoneIndex = Entities[EntityIndex].BoneNames.Add(BoneName);
+	BoneNameToIndex[EntityIndex].Add(BoneName, BoneIndex);
+	return BoneIndex;
+}
+
+// Read the pose of a json actor or bone object
+bool FSLRawDataEpisodeReader::ReadJsonPose(const TSharedPtr<FJsonObject>& Object, FVector& OutLocation, FQuat& OutRotation)
+{
+	const TSharedPtr<FJsonObject>* Pos = nullptr;
+	const TSharedPtr<FJsonObject>* Rot = nullptr;
+	if (!Object->TryGetObjectField("pos", Pos) || !Object->TryGetObjectField("rot", Rot))
+	{
+		return false;
+	}
+
+	// Meters and right handed to cm and left handed
+	OutLocation.X = (*Pos)->GetNumberField("x") * 100.f;
+	OutLocation.Y = -(*Pos)->GetNumberField("y") * 100.f;
+	OutLocation.Z = (*Pos)->GetNumberField("z") * 100.f;
+	OutRotation.X = -(*Rot)->GetNumberField("x");
+	OutRotation.Y = (*Rot)->GetNumberField("y");
+	OutRotation.Z = -(*Rot)->GetNumberField("z");
+	OutRotation.W = (*Rot)->GetNumberField("w");
+	return true;
+}
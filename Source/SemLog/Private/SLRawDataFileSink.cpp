@@ -0,0 +1,187 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataFileSink.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/Paths.h"
+
+// Constructor
+FSLRawDataFileSink::FSLRawDataFileSink()
+	: FileHandle(nullptr), Format(ESLRawDataFormat::Json), bCompress(false), bFramed(false), NumWrittenEntities(0)
+{
+}
+
+// Destructor, writes the queued frames and closes the file
+FSLRawDataFileSink::~FSLRawDataFileSink()
+{
+	FSLRawDataSink::Finish();
+	FSLRawDataFileSink::Close();
+}
+
+// Create the file
+bool FSLRawDataFileSink::Open(const FString& InFilePath, ESLRawDataFormat InFormat, bool bInCompress, bool bInFramed)
+{
+	if (IsStarted() || FileHandle)
+	{
+		return false;
+	}
+
+	Format = InFormat;
+	bCompress = bInCompress;
+
+	// Compressed blocks already have their sizes and a seek index
+	bFramed = bInFramed && !bCompress;
+	if (bInFramed && bCompress)
+	{
+		UE_LOG(LogTemp, Warning, TEXT(" %s::%d Compressed raw data is not framed"), TEXT(__FUNCTION__), __LINE__);
+	}
+
+	FilePath = InFilePath;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+	FileHandle = PlatformFile.OpenWrite(*FilePath, true);
+	return FileHandle != nullptr;
+}
+
+// Quantize the binary poses, optionally as deltas
+void FSLRawDataFileSink::SetQuantization(bool bQuantize, bool bDeltaEncoding)
+{
+	if (!IsStarted())
+	{
+		BinaryWriter.SetQuantize(bQuantize);
+		BinaryWriter.SetDeltaEncoding(bDeltaEncoding);
+	}
+}
+
+// Write the headers
+void FSLRawDataFileSink::OnStart()
+{
+	if (!FileHandle)
+	{
+		return;
+	}
+
+	// Framed files start with their own header, the binary header is the first record
+	if (bFramed)
+	{
+		FSLRawDataFramed::WriteHeader(FramedBytes);
+		FSLRawDataFileSink::WriteToFile(FramedBytes);
+		FramedBytes.Reset();
+	}
+
+	// Binary files start with the header
+	if (Format == ESLRawDataFormat::Binary)
+	{
+		BinaryWriter.WriteHeader();
+	}
+
+	// Compressed files keep the header uncompressed, in front of the blocks
+	if (bCompress)
+	{
+		CompressedWriter.Init(BinaryWriter.GetBuffer());
+		CompressedWriter.WriteHeader(CompressedBytes);
+		FSLRawDataFileSink::WriteToFile(CompressedBytes);
+		CompressedBytes.Reset();
+	}
+	else if (Format == ESLRawDataFormat::Binary)
+	{
+		FSLRawDataFileSink::WriteFrameContent(BinaryWriter.GetBuffer(), 0.0);
+	}
+	BinaryWriter.Reset();
+}
+
+// Serialize and write the frames
+void FSLRawDataFileSink::Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	if (!FileHandle)
+	{
+		return;
+	}
+
+	for (const FSLRawDataFrameRef& Frame : Frames)
+	{
+		if (Format == ESLRawDataFormat::Binary)
+		{
+			// Compressed blocks can be read on their own, they start with all the known entities
+			if (bCompress && CompressedWriter.IsBlockEmpty())
+			{
+				BinaryWriter.WriteEntities(Entities, NumWrittenEntities);
+				BinaryWriter.ResetDeltas();
+			}
+			BinaryWriter.WriteFrame(*Frame);
+			FSLRawDataFileSink::WriteFrameContent(BinaryWriter.GetBuffer(), Frame->Timestamp);
+			BinaryWriter.Reset();
+		}
+		else
+		{
+			// Encoded once by the encode sink if the frames are also broadcast
+			if (Frame->JsonBytes.IsValid())
+			{
+				FSLRawDataFileSink::WriteFrameContent(*Frame->JsonBytes, Frame->Timestamp);
+			}
+			else if (JsonWriter.WriteFrame(*Frame, Entities))
+			{
+				FSLRawDataFileSink::WriteFrameContent(JsonWriter.GetBuffer(), Frame->Timestamp);
+			}
+			JsonWriter.Reset();
+		}
+		NumWrittenEntities += Frame->NewEntities.Num();
+	}
+}
+
+// Compress the last block, write the seek index and close the file
+void FSLRawDataFileSink::OnFinish()
+{
+	if (FileHandle && bCompress)
+	{
+		CompressedWriter.Finish(CompressedBytes);
+		FSLRawDataFileSink::WriteToFile(CompressedBytes);
+		CompressedBytes.Reset();
+	}
+	FSLRawDataFileSink::Close();
+}
+
+// Add the serialized frame to the file, as a record or through the compression if enabled
+bool FSLRawDataFileSink::WriteFrameContent(const TArray<uint8>& Bytes, double Timestamp)
+{
+	// The record is written at once, a crash can only truncate the last one
+	if (bFramed)
+	{
+		FSLRawDataFramed::WriteRecord(Bytes.GetData(), Bytes.Num(), FramedBytes);
+		const bool bWritten = FSLRawDataFileSink::WriteToFile(FramedBytes);
+		FramedBytes.Reset();
+		return bWritten;
+	}
+
+	if (!bCompress)
+	{
+		return FSLRawDataFileSink::WriteToFile(Bytes);
+	}
+
+	// Only full blocks reach the file
+	if (CompressedWriter.AddFrame(Bytes, Timestamp, CompressedBytes))
+	{
+		const bool bWritten = FSLRawDataFileSink::WriteToFile(CompressedBytes);
+		CompressedBytes.Reset();
+		return bWritten;
+	}
+	return true;
+}
+
+// Append bytes to the file
+bool FSLRawDataFileSink::WriteToFile(const TArray<uint8>& Bytes)
+{
+	return FileHandle && FileHandle->Write(Bytes.GetData(), Bytes.Num());
+}
+
+// Close the file
+void FSLRawDataFileSink::Close()
+{
+	if (FileHandle)
+	{
+		FileHandle->Flush();
+		delete FileHandle;
+		FileHandle = nullptr;
+	}
+}
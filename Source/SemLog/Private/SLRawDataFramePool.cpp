@@ -0,0 +1,58 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataFramePool.h"
+
+// Constructor
+FSLRawDataFramePool::FSLRawDataFramePool(int32 InNumPoses) : NumPoses(InNumPoses), NumFrames(0), MaxFrames(0)
+{
+}
+
+// Create a pool with preallocated frames
+TSharedRef<FSLRawDataFramePool, ESPMode::ThreadSafe> FSLRawDataFramePool::Create(int32 NumFrames, int32 InNumPoses)
+{
+	TSharedRef<FSLRawDataFramePool, ESPMode::ThreadSafe> Pool = MakeShareable(new FSLRawDataFramePool(InNumPoses));
+	for (int32 Idx = 0; Idx < NumFrames; ++Idx)
+	{
+		FSLRawDataFrame* Frame = new FSLRawDataFrame();
+		Frame->Poses.Reserve(InNumPoses);
+		Pool->FreeFrames.Enqueue(Frame);
+	}
+	Pool->NumFrames = NumFrames;
+	return Pool;
+}
+
+// Destructor, deletes the pooled frames
+FSLRawDataFramePool::~FSLRawDataFramePool()
+{
+	FSLRawDataFrame* Frame = nullptr;
+	while (FreeFrames.Dequeue(Frame))
+	{
+		delete Frame;
+	}
+}
+
+// Get a cleared frame
+TSharedPtr<FSLRawDataFrame, ESPMode::ThreadSafe> FSLRawDataFramePool::Acquire()
+{
+	FSLRawDataFrame* Frame = nullptr;
+	if (!FreeFrames.Dequeue(Frame))
+	{
+		// All frames are still referenced
+		if (MaxFrames > 0 && NumFrames >= MaxFrames)
+		{
+			return nullptr;
+		}
+		Frame = new FSLRawDataFrame();
+		Frame->Poses.Reserve(NumPoses);
+		NumFrames++;
+	}
+	Frame->Reset();
+
+	// The released frame goes back to the pool, the reference keeps the pool alive until then
+	TSharedRef<FSLRawDataFramePool, ESPMode::ThreadSafe> Pool = AsShared();
+	return TSharedPtr<FSLRawDataFrame, ESPMode::ThreadSafe>(Frame, [Pool](FSLRawDataFrame* InFrame)
+	{
+		Pool->FreeFrames.Enqueue(InFrame);
+	});
+}
@@ -0,0 +1,81 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataFraming.h"
+#include "Misc/Crc.h"
+
+// Write the file header
+void FSLRawDataFramed::WriteHeader(TArray<uint8>& OutBytes)
+{
+	const uint32 Header[2] = { FSLRawDataFramed::Magic, FSLRawDataFramed::Version };
+	OutBytes.Append((const uint8*)Header, FSLRawDataFramed::HeaderSize);
+}
+
+// Append the payload as a record
+void FSLRawDataFramed::WriteRecord(const uint8* Payload, int32 PayloadSize, TArray<uint8>& OutBytes)
+{
+	const uint32 RecordHeader[3] = { FSLRawDataFramed::RecordMagic, (uint32)PayloadSize, FCrc::MemCrc32(Payload, PayloadSize) };
+	OutBytes.Reserve(OutBytes.Num() + FSLRawDataFramed::RecordHeaderSize + PayloadSize);
+	OutBytes.Append((const uint8*)RecordHeader, FSLRawDataFramed::RecordHeaderSize);
+	OutBytes.Append(Payload, PayloadSize);
+}
+
+// Check if the data starts with the file header
+bool FSLRawDataFramed::HasHeader(const uint8* Data, int64 DataSize)
+{
+	uint32 Header[2];
+	if (DataSize < FSLRawDataFramed::HeaderSize)
+	{
+		return false;
+	}
+	FMemory::Memcpy(Header, Data, FSLRawDataFramed::HeaderSize);
+	return Header[0] == FSLRawDataFramed::Magic && Header[1] >= 1 && Header[1] <= FSLRawDataFramed::Version;
+}
+
+// Check if a valid record starts at the offset
+bool FSLRawDataFramed::ReadRecord(const uint8* Data, int64 DataSize, int64 Offset, int64& OutPayloadOffset, int32& OutPayloadSize)
+{
+	if (Offset < 0 || DataSize - Offset < FSLRawDataFramed::RecordHeaderSize)
+	{
+		return false;
+	}
+
+	uint32 RecordHeader[3];
+	FMemory::Memcpy(RecordHeader, Data + Offset, FSLRawDataFramed::RecordHeaderSize);
+	const int64 PayloadOffset = Offset + FSLRawDataFramed::RecordHeaderSize;
+	if (RecordHeader[0] != FSLRawDataFramed::RecordMagic ||
+		(int32)RecordHeader[1] < 0 ||
+		(int64)RecordHeader[1] > DataSize - PayloadOffset)
+	{
+		// Not a record, or truncated
+		return false;
+	}
+
+	if (FCrc::MemCrc32(Data + PayloadOffset, (int32)RecordHeader[1]) != RecordHeader[2])
+	{
+		// Corrupted
+		return false;
+	}
+
+	OutPayloadOffset = PayloadOffset;
+	OutPayloadSize = (int32)RecordHeader[1];
+	return true;
+}
+
+// Offset of the first valid record at or after the offset
+int64 FSLRawDataFramed::FindRecord(const uint8* Data, int64 DataSize, int64 Offset)
+{
+	const uint32 RecordMagic = FSLRawDataFramed::RecordMagic;
+	const uint8* MagicBytes = (const uint8*)&RecordMagic;
+	int64 PayloadOffset;
+	int32 PayloadSize;
+	for (int64 Pos = FMath::Max(Offset, (int64)0); Pos + FSLRawDataFramed::RecordHeaderSize <= DataSize; ++Pos)
+	{
+		if (Data[Pos] == MagicBytes[0] && FMemory::Memcmp(Data + Pos, MagicBytes, sizeof(uint32)) == 0 &&
+			FSLRawDataFramed::ReadRecord(Data, DataSize, Pos, PayloadOffset, PayloadSize))
+		{
+			return Pos;
+		}
+	}
+	return DataSize;
+}
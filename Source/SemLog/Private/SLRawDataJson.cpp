@@ -0,0 +1,224 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataJson.h"
+#include "SLRawDataQuantization.h"
+
+// Constructor
+FSLRawDataJsonWriter::FSLRawDataJsonWriter()
+{
+}
+
+// Append the frame as a json object
+bool FSLRawDataJsonWriter::WriteFrame(const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	// Avoid writing empty entries
+	if (Frame.Poses.Num() == 0)
+	{
+		return false;
+	}
+
+	WriteLiteral("{\"timestamp\":");
+	WriteNumber(Frame.Timestamp);
+	if (Frame.bIsKeyframe)
+	{
+		WriteLiteral(",\"keyframe\":true");
+	}
+	WriteLiteral(",\"actors\":[");
+
+	// Bones follow the pose of their entity
+	const FEncodedNames* ActorNames = nullptr;
+	bool bFirstActor = true;
+	bool bFirstBone = true;
+	bool bHasBones = false;
+
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		if (!Entities.IsValidIndex(PoseItr.EntityIndex))
+		{
+			continue;
+		}
+
+		if (PoseItr.BoneIndex == INDEX_NONE)
+		{
+			// Close the previous actor
+			if (ActorNames)
+			{
+				WriteActorEnd(bHasBones);
+			}
+			if (!bFirstActor)
+			{
+				WriteLiteral(",");
+			}
+			bFirstActor = false;
+
+			ActorNames = &GetEncodedNames(Entities[PoseItr.EntityIndex]);
+			WriteNameLocRot(ActorNames->Name, PoseItr.Location * 0.01f, PoseItr.Rotation, ActorNames->PositionDecimals);
+
+			bHasBones = ActorNames->BoneNames.Num() > 0;
+			if (bHasBones)
+			{
+				WriteLiteral(",\"bones\":[");
+			}
+			bFirstBone = true;
+		}
+		else if (ActorNames && ActorNames->BoneNames.IsValidIndex(PoseItr.BoneIndex))
+		{
+			if (!bFirstBone)
+			{
+				WriteLiteral(",");
+			}
+			bFirstBone = false;
+
+			WriteNameLocRot(ActorNames->BoneNames[PoseItr.BoneIndex], PoseItr.Location * 0.01f, PoseItr.Rotation,
+				ActorNames->PositionDecimals);
+			WriteLiteral("}");
+		}
+	}
+
+	// Close the last actor
+	if (ActorNames)
+	{
+		WriteActorEnd(bHasBones);
+	}
+	WriteLiteral("]}");
+
+	return true;
+}
+
+// Hand over the written bytes as a shared buffer
+FSLRawDataJsonBytesRef FSLRawDataJsonWriter::ReleaseBuffer()
+{
+	const int32 Capacity = Buffer.Max();
+	FSLRawDataJsonBytesRef Bytes = MakeShareable(new TArray<uint8>(MoveTemp(Buffer)));
+	Buffer.Reserve(Capacity);
+	return Bytes;
+}
+
+// Get the encoded names of the entity, encode them on first use
+const FSLRawDataJsonWriter::FEncodedNames& FSLRawDataJsonWriter::GetEncodedNames(const FSLRawDataEntityDesc& Entity)
+{
+	if (EncodedNamesCache.Num() <= Entity.EntityIndex)
+	{
+		EncodedNamesCache.SetNum(Entity.EntityIndex + 1);
+	}
+
+	FEncodedNames& Names = EncodedNamesCache[Entity.EntityIndex];
+	if (!Names.bIsSet)
+	{
+		FSLRawDataJsonWriter::EncodeString(Entity.UniqueName, Names.Name);
+		Names.BoneNames.SetNum(Entity.BoneNames.Num());
+		for (int32 BoneIndex = 0; BoneIndex < Entity.BoneNames.Num(); ++BoneIndex)
+		{
+			FSLRawDataJsonWriter::EncodeString(Entity.BoneNames[BoneIndex], Names.BoneNames[BoneIndex]);
+		}
+		Names.PositionDecimals = Entity.PositionPrecision > 0.f ?
+			FSLRawDataQuantization::GetMeterDecimals(Entity.PositionPrecision) : INDEX_NONE;
+		Names.bIsSet = true;
+	}
+	return Names;
+}
+
+// Write the name, location and rotation (the closing bracket is left to the caller)
+FORCEINLINE void FSLRawDataJsonWriter::WriteNameLocRot(const TArray<uint8>& EncodedName, const FVector& Location, const FQuat& Rotation,
+	int32 PositionDecimals)
+{
+	// Quantized rotations are exact to ~1e-5
+	const int32 RotationDecimals = PositionDecimals >= 0 ? 5 : INDEX_NONE;
+
+	WriteLiteral("{\"name\":");
+	WriteRaw((const ANSICHAR*)EncodedName.GetData(), EncodedName.Num());
+
+	WriteLiteral(",\"pos\":{\"x\":");
+	WriteFixed(Location.X, PositionDecimals);
+	WriteLiteral(",\"y\":");
+	WriteFixed(-Location.Y, PositionDecimals); // left to right handed
+	WriteLiteral(",\"z\":");
+	WriteFixed(Location.Z, PositionDecimals);
+
+	WriteLiteral("},\"rot\":{\"w\":");
+	WriteFixed(Rotation.W, RotationDecimals);
+	WriteLiteral(",\"x\":");
+	WriteFixed(-Rotation.X, RotationDecimals); // left to right handed
+	WriteLiteral(",\"y\":");
+	WriteFixed(Rotation.Y, RotationDecimals);
+	WriteLiteral(",\"z\":");
+	WriteFixed(-Rotation.Z, RotationDecimals); // left to right handed
+	WriteLiteral("}");
+}
+
+// Close the actor object (and its bones array)
+FORCEINLINE void FSLRawDataJsonWriter::WriteActorEnd(bool bHasBones)
+{
+	if (bHasBones)
+	{
+		WriteLiteral("]}");
+	}
+	else
+	{
+		WriteLiteral("}");
+	}
+}
+
+// Write number (9 significant digits are enough to restore the float)
+FORCEINLINE void FSLRawDataJsonWriter::WriteNumber(float Value)
+{
+	ANSICHAR Chars[32];
+	const int32 Num = FCStringAnsi::Snprintf(Chars, sizeof(Chars), "%.9g", Value);
+	WriteRaw(Chars, FMath::Clamp(Num, 0, (int32)sizeof(Chars) - 1));
+}
+
+// Write number with a fixed number of decimals
+FORCEINLINE void FSLRawDataJsonWriter::WriteFixed(float Value, int32 Decimals)
+{
+	if (Decimals < 0)
+	{
+		WriteNumber(Value);
+		return;
+	}
+	ANSICHAR Chars[48];
+	const int32 Num = FCStringAnsi::Snprintf(Chars, sizeof(Chars), "%.*f", Decimals, Value);
+	WriteRaw(Chars, FMath::Clamp(Num, 0, (int32)sizeof(Chars) - 1));
+}
+
+// Write raw characters
+FORCEINLINE void FSLRawDataJsonWriter::WriteRaw(const ANSICHAR* Chars, int32 Num)
+{
+	Buffer.Append((const uint8*)Chars, Num);
+}
+
+// Encode the string as a quoted json string
+void FSLRawDataJsonWriter::EncodeString(const FString& InString, TArray<uint8>& OutBytes)
+{
+	// Encode as UTF-8 first, multi byte sequences never contain characters that need escaping
+	FTCHARToUTF8 Converter(*InString);
+	const uint8* Chars = (const uint8*)Converter.Get();
+	const int32 NumChars = Converter.Length();
+
+	OutBytes.Reset(NumChars + 2);
+	OutBytes.Add('"');
+	for (int32 Idx = 0; Idx < NumChars; ++Idx)
+	{
+		const uint8 Char = Chars[Idx];
+		switch (Char)
+		{
+		case '"': OutBytes.Append((const uint8*)"\\\"", 2); break;
+		case '\\': OutBytes.Append((const uint8*)"\\\\", 2); break;
+		case '\n': OutBytes.Append((const uint8*)"\\n", 2); break;
+		case '\r': OutBytes.Append((const uint8*)"\\r", 2); break;
+		case '\t': OutBytes.Append((const uint8*)"\\t", 2); break;
+		default:
+			if (Char < 0x20)
+			{
+				ANSICHAR Escaped[8];
+				const int32 Len = FCStringAnsi::Sprintf(Escaped, "\\u%04x", (uint32)Char);
+				OutBytes.Append((const uint8*)Escaped, Len);
+			}
+			else
+			{
+				OutBytes.Add(Char);
+			}
+		}
+	}
+	OutBytes.Add('"');
+}
@@ -0,0 +1,77 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataJsonEncodeSink.h"
+
+// Constructor
+FSLRawDataJsonEncodeSink::FSLRawDataJsonEncodeSink()
+{
+}
+
+// Destructor, encodes the queued frames and finishes the targets
+FSLRawDataJsonEncodeSink::~FSLRawDataJsonEncodeSink()
+{
+	FSLRawDataSink::Finish();
+}
+
+// Pass the encoded frames on to the sink
+void FSLRawDataJsonEncodeSink::AddTarget(const TSharedRef<FSLRawDataSink>& Target)
+{
+	if (!IsStarted() && !Target->IsStarted())
+	{
+		Targets.Add(Target);
+	}
+}
+
+// Frames held by this sink and by its targets
+int32 FSLRawDataJsonEncodeSink::GetMaxHeldFrames() const
+{
+	int32 MaxHeldFrames = FSLRawDataSink::GetMaxHeldFrames();
+	for (const auto& TargetItr : Targets)
+	{
+		const int32 TargetMaxHeldFrames = TargetItr->GetMaxHeldFrames();
+		if (MaxHeldFrames == INDEX_NONE || TargetMaxHeldFrames == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		MaxHeldFrames += TargetMaxHeldFrames;
+	}
+	return MaxHeldFrames;
+}
+
+// Start the targets, this thread is their only producer
+void FSLRawDataJsonEncodeSink::OnStart()
+{
+	for (const auto& TargetItr : Targets)
+	{
+		TargetItr->Start();
+	}
+}
+
+// Serialize the frames and pass them on
+void FSLRawDataJsonEncodeSink::Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	for (const FSLRawDataFrameRef& Frame : Frames)
+	{
+		// The bytes are set before the frame reaches the targets, they are only read after it is queued
+		if (JsonWriter.WriteFrame(*Frame, Entities))
+		{
+			Frame->JsonBytes = JsonWriter.ReleaseBuffer();
+		}
+		JsonWriter.Reset();
+
+		for (const auto& TargetItr : Targets)
+		{
+			TargetItr->Enqueue(Frame);
+		}
+	}
+}
+
+// Write out the remaining frames of the targets
+void FSLRawDataJsonEncodeSink::OnFinish()
+{
+	for (const auto& TargetItr : Targets)
+	{
+		TargetItr->Finish();
+	}
+}
@@ -0,0 +1,254 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataJsonScanner.h"
+#include "Async/ParallelFor.h"
+
+// Smallest chunk worth a task
+static const int64 MinChunkSize = 4 << 20;
+
+// Find the frames
+bool FSLRawDataJsonScanner::FindFrames(const uint8* Data, int64 DataSize, TArray<FSLRawDataFrameIndexEntry>& OutIndex, int32 NumChunks)
+{
+	OutIndex.Reset();
+	if (!Data || DataSize <= 0)
+	{
+		return false;
+	}
+
+	if (NumChunks <= 0)
+	{
+		const int32 MaxChunks = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1) * 4;
+		NumChunks = (int32)FMath::Clamp(DataSize / MinChunkSize, (int64)1, (int64)MaxChunks);
+	}
+	const int64 ChunkSize = (DataSize + NumChunks - 1) / NumChunks;
+
+	// State changes of every chunk, for every possible start state
+	TArray<EState> EndStates;
+	TArray<int64> DepthDeltas;
+	EndStates.SetNum(NumChunks * NumStates);
+	DepthDeltas.SetNum(NumChunks * NumStates);
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int64 Begin = ChunkIdx * ChunkSize;
+		const int64 End = FMath::Min(Begin + ChunkSize, DataSize);
+		for (uint8 State = 0; State < NumStates; ++State)
+		{
+			FSLRawDataJsonScanner::ScanTransition(Data, Begin, End, (EState)State,
+				EndStates[ChunkIdx * NumStates + State], DepthDeltas[ChunkIdx * NumStates + State]);
+		}
+	});
+
+	// Actual state at the start of every chunk
+	TArray<EState> StartStates;
+	TArray<int64> StartDepths;
+	StartStates.SetNum(NumChunks);
+	StartDepths.SetNum(NumChunks);
+	EState State = Outside;
+	int64 Depth = 0;
+	for (int32 ChunkIdx = 0; ChunkIdx < NumChunks; ++ChunkIdx)
+	{
+		StartStates[ChunkIdx] = State;
+		StartDepths[ChunkIdx] = Depth;
+		Depth += DepthDeltas[ChunkIdx * NumStates + State];
+		State = EndStates[ChunkIdx * NumStates + State];
+	}
+
+	// Frame boundaries of every chunk
+	TArray<FChunkFrames> ChunkFrames;
+	ChunkFrames.SetNum(NumChunks);
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int64 Begin = ChunkIdx * ChunkSize;
+		const int64 End = FMath::Min(Begin + ChunkSize, DataSize);
+		FSLRawDataJsonScanner::ScanFrames(Data, Begin, End, StartStates[ChunkIdx], StartDepths[ChunkIdx], ChunkFrames[ChunkIdx]);
+	});
+
+	// Join the frames spanning chunks, an unfinished last frame (e.g. after a crash) is left out
+	int64 PendingStart = INDEX_NONE;
+	for (const auto& ChunkItr : ChunkFrames)
+	{
+		if (ChunkItr.OrphanEnd != INDEX_NONE && PendingStart != INDEX_NONE)
+		{
+			FSLRawDataFrameIndexEntry& Entry = OutIndex[OutIndex.AddDefaulted()];
+			Entry.Offset = PendingStart;
+			Entry.Size = (int32)(ChunkItr.OrphanEnd - PendingStart);
+			PendingStart = INDEX_NONE;
+		}
+		for (const auto& FrameItr : ChunkItr.Frames)
+		{
+			FSLRawDataFrameIndexEntry& Entry = OutIndex[OutIndex.AddDefaulted()];
+			Entry.Offset = FrameItr.Key;
+			Entry.Size = (int32)(FrameItr.Value - FrameItr.Key);
+		}
+		if (ChunkItr.OpenStart != INDEX_NONE)
+		{
+			PendingStart = ChunkItr.OpenStart;
+		}
+	}
+
+	// Timestamps of the frames
+	TArray<bool> KeyframeFlags;
+	TArray<bool> ValidFlags;
+	KeyframeFlags.SetNumZeroed(OutIndex.Num());
+	ValidFlags.SetNumZeroed(OutIndex.Num());
+	ParallelFor(OutIndex.Num(), [&](int32 FrameIdx)
+	{
+		FSLRawDataFrameIndexEntry& Entry = OutIndex[FrameIdx];
+		ValidFlags[FrameIdx] = FSLRawDataJsonScanner::ReadFrameHeader(Data + Entry.Offset, Entry.Size,
+			Entry.Timestamp, KeyframeFlags[FrameIdx]);
+	});
+
+	// Keep the readable frames, and link them to their keyframe
+	int32 NumValid = 0;
+	int32 LastKeyframe = 0;
+	for (int32 FrameIdx = 0; FrameIdx < OutIndex.Num(); ++FrameIdx)
+	{
+		if (!ValidFlags[FrameIdx])
+		{
+			continue;
+		}
+		if (KeyframeFlags[FrameIdx])
+		{
+			LastKeyframe = NumValid;
+		}
+		OutIndex[NumValid] = OutIndex[FrameIdx];
+		OutIndex[NumValid].KeyframeIndex = LastKeyframe;
+		NumValid++;
+	}
+	if (NumValid < OutIndex.Num())
+	{
+		UE_LOG(LogTemp, Warning, TEXT(" %s::%d Skipped %d objects which are not raw data frames"),
+			TEXT(__FUNCTION__), __LINE__, OutIndex.Num() - NumValid);
+	}
+	OutIndex.SetNum(NumValid);
+	return true;
+}
+
+// Read the timestamp and keyframe flag at the start of the frame
+bool FSLRawDataJsonScanner::ReadFrameHeader(const uint8* Data, int64 Size, double& OutTimestamp, bool& bOutIsKeyframe)
+{
+	static const ANSICHAR TimestampKey[] = "\"timestamp\"";
+	static const ANSICHAR KeyframeKey[] = "\"keyframe\"";
+	static const ANSICHAR True[] = "true";
+
+	int64 Pos = 0;
+	auto SkipWhitespace = [&]()
+	{
+		while (Pos < Size && (Data[Pos] == ' ' || Data[Pos] == '\t' || Data[Pos] == '\r' || Data[Pos] == '\n'))
+		{
+			Pos++;
+		}
+	};
+	auto Match = [&](const ANSICHAR* Literal, int32 Len)
+	{
+		SkipWhitespace();
+		if (Pos + Len <= Size && FMemory::Memcmp(Data + Pos, Literal, Len) == 0)
+		{
+			Pos += Len;
+			return true;
+		}
+		return false;
+	};
+
+	// {"timestamp":t
+	if (!Match("{", 1) || !Match(TimestampKey, sizeof(TimestampKey) - 1) || !Match(":", 1))
+	{
+		return false;
+	}
+	SkipWhitespace();
+	ANSICHAR Number[32];
+	int32 NumberLen = 0;
+	while (Pos < Size && NumberLen < 31 && (FChar::IsDigit(Data[Pos]) ||
+		Data[Pos] == '-' || Data[Pos] == '+' || Data[Pos] == '.' || Data[Pos] == 'e' || Data[Pos] == 'E'))
+	{
+		Number[NumberLen++] = (ANSICHAR)Data[Pos++];
+	}
+	Number[NumberLen] = 0;
+	if (NumberLen == 0)
+	{
+		return false;
+	}
+	OutTimestamp = FCStringAnsi::Atod(Number);
+
+	// ,"keyframe":true
+	bOutIsKeyframe = Match(",", 1) && Match(KeyframeKey, sizeof(KeyframeKey) - 1) && Match(":", 1) && Match(True, sizeof(True) - 1);
+	return true;
+}
+
+// Scan the range from the state
+void FSLRawDataJsonScanner::ScanTransition(const uint8* Data, int64 Begin, int64 End, EState StartState, EState& OutEndState, int64& OutDepthDelta)
+{
+	EState State = StartState;
+	int64 Depth = 0;
+	for (int64 Pos = Begin; Pos < End; ++Pos)
+	{
+		const uint8 Char = Data[Pos];
+		if (State == InStringEscaped)
+		{
+			State = InString;
+		}
+		else if (State == InString)
+		{
+			State = Char == '\\' ? InStringEscaped : (Char == '"' ? Outside : InString);
+		}
+		else if (Char == '"')
+		{
+			State = InString;
+		}
+		else if (Char == '{' || Char == '[')
+		{
+			Depth++;
+		}
+		else if (Char == '}' || Char == ']')
+		{
+			Depth--;
+		}
+	}
+	OutEndState = State;
+	OutDepthDelta = Depth;
+}
+
+// Scan the range with the known start state and depth for the frame boundaries
+void FSLRawDataJsonScanner::ScanFrames(const uint8* Data, int64 Begin, int64 End, EState StartState, int64 StartDepth, FChunkFrames& OutFrames)
+{
+	EState State = StartState;
+	int64 Depth = StartDepth;
+	int64 Start = INDEX_NONE;
+	for (int64 Pos = Begin; Pos < End; ++Pos)
+	{
+		const uint8 Char = Data[Pos];
+		if (State == InStringEscaped)
+		{
+			State = InString;
+		}
+		else if (State == InString)
+		{
+			State = Char == '\\' ? InStringEscaped : (Char == '"' ? Outside : InString);
+		}
+		else if (Char == '"')
+		{
+			State = InString;
+		}
+		else if (Char == '{' || Char == '[')
+		{
+			if (Depth++ == 0)
+			{
+				Start = Pos;
+			}
+		}
+		else if ((Char == '}' || Char == ']') && --Depth == 0)
+		{
+			if (Start != INDEX_NONE)
+			{
+				OutFrames.Frames.Emplace(Start, Pos + 1);
+				Start = INDEX_NONE;
+			}
+			else if (OutFrames.OrphanEnd == INDEX_NONE)
+			{
+				OutFrames.OrphanEnd = Pos + 1;
+			}
+		}
+	}
+	OutFrames.OpenStart = Start;
+}
@@ -2,7 +2,11 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "SLRawDataLogger.h"
+#include "SLRawDataMotion.h"
+#include "SLRawDataBroadcastSink.h"
+#include "SLRawDataJsonEncodeSink.h"
 #include "Animation/SkeletalMeshActor.h"
+#include "Async/Async.h"
 #include "TagStatics.h"
 #ifdef WITH_MONGO
 #include "mongoc.h"
@@ -15,21 +19,35 @@ USLRawDataLogger::USLRawDataLogger()
 {
 	// Default values
 	bIsInit = false;
-	bLogToFile = false;
-	bBroadcastData = false;
+	bSinksStarted = false;
+	bBroadcast = false;
+	bQuantize = false;
+	bDeltaEncode = false;
+	DefaultPositionPrecision = 0.f;
+	NumEntities = 0;
+	NumSkippedFrames = 0;
+	bUseScheduler = false;
+	bAdaptiveSampling = false;
+	MaxSamplingPeriod = 1.f;
+	bFixedTimestep = false;
+	FixedSamplePeriod = 0.f;
+	MaxCatchUpSamples = 1;
+	FirstSampleTime = 0.0;
+	NumSamples = 0;
+	LastTickTime = 0.0;
+	bInterpolateSample = false;
+	SampleAlpha = 1.f;
 }
 
 // Destructor
 USLRawDataLogger::~USLRawDataLogger()
 {
-	if (FileHandle)
-	{
-		delete FileHandle;
-	}
+	USLRawDataLogger::Finish();
 }
 
 // Init logger
-bool USLRawDataLogger::Init(UWorld* InWorld, const float DistanceThreshold)
+bool USLRawDataLogger::Init(UWorld* InWorld, const float DistanceThreshold, const float AngularThreshold,
+	const int32 InKeyframeInterval)
 {
 	// Set the world
 	World = InWorld;
@@ -37,73 +55,274 @@ bool USLRawDataLogger::Init(UWorld* InWorld, const float DistanceThreshold)
 	// Calculate the squared distance threshold (faster comparisons)
 	SquaredDistanceThreshold = DistanceThreshold * DistanceThreshold;
 
+	// Rotations are compared through the quaternion dot product
+	MinQuatDot = FSLRawDataMotion::AngularThresholdToMinQuatDot(AngularThreshold);
+
+	// Number of updates between full writes of the dynamic entities
+	KeyframeInterval = InKeyframeInterval;
+	UpdatesSinceKeyframe = 0;
+
+	// Every entity is in the sampling schedule, it is only used if sampling periods are set
+	Scheduler.Init();
+
+	// Preallocate frames for the capture
+	if (!FramePool.IsValid())
+	{
+		FramePool = FSLRawDataFramePool::Create(NumPreallocatedFrames, NumPreallocatedPoses);
+	}
+
 	// Logger initialized
 	bIsInit = (World != nullptr);
 	return bIsInit;
 }
 
 // Set file handle for appending log data to file every update
-void USLRawDataLogger::InitFileHandle(const FString EpisodeId, const FString LogDirectoryPath)
+void USLRawDataLogger::InitFileHandle(const FString EpisodeId, const FString LogDirectoryPath, ESLRawDataFormat InFormat,
+	const bool bInCompress, const bool bInFramed)
 {
+	if (FileSink.IsValid())
+	{
+		return;
+	}
+
+	// Compressed blocks already have their sizes and a seek index
+	const bool bFramed = bInFramed && !bInCompress;
+
 	// Create file handle to incrementally append json logs to file
-	const FString Filename = "RawData_" + EpisodeId + ".json";
+	const FString Extension = FString((InFormat == ESLRawDataFormat::Binary) ? ".bin" : ".json") +
+		(bInCompress ? ".slz" : (bFramed ? ".slf" : ""));
+	const FString Filename = "RawData_" + EpisodeId + Extension;
 	const FString EpisodesDirPath = LogDirectoryPath.EndsWith("/") ?
 		(LogDirectoryPath + "Episodes/") : (LogDirectoryPath + "/Episodes/");
-	const FString FilePath = EpisodesDirPath + Filename;
 
-	// Create logging directory path and the filehandle
-	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*EpisodesDirPath);
-	FileHandle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath, true);
+	// The file is written by the sink thread, the headers when it starts
+	TSharedRef<FSLRawDataFileSink> NewFileSink = MakeShareable(new FSLRawDataFileSink());
+	if (NewFileSink->Open(EpisodesDirPath + Filename, InFormat, bInCompress, bInFramed))
+	{
+		NewFileSink->SetQuantization(bQuantize, bDeltaEncode);
+		USLRawDataLogger::AddSink(NewFileSink);
+		FileSink = NewFileSink;
+	}
+}
+
+// Set the frame queue of the file writer thread
+void USLRawDataLogger::InitFileQueue(const int32 QueueSize, ESLRawDataQueuePolicy QueuePolicy)
+{
+	if (FileSink.IsValid())
+	{
+		FileSink->SetQueue(QueueSize, QueuePolicy);
+	}
+}
 
-	bLogToFile = (FileHandle != nullptr);
+// Also write the frames to the mongo database, in a collection named after the episode
+bool USLRawDataLogger::InitMongoWriter(const FString EpisodeId, const FString Uri, const FString Database,
+	const int32 BatchSize, const float FlushInterval)
+{
+	if (MongoSink.IsValid())
+	{
+		return false;
+	}
+
+	TSharedRef<FSLRawDataMongoSink> NewMongoSink = MakeShareable(new FSLRawDataMongoSink());
+	if (!NewMongoSink->Connect(Uri, Database, EpisodeId, BatchSize, FlushInterval))
+	{
+		return false;
+	}
+
+	// Allow a batch to pile up while the server is busy, then merge the frames, never stall the logger nor leave holes
+	NewMongoSink->SetQueue(NewMongoSink->GetBatchSize() * 2, ESLRawDataQueuePolicy::Merge);
+	USLRawDataLogger::AddSink(NewMongoSink);
+	MongoSink = NewMongoSink;
+	return true;
+}
+
+// Stream the frames to the clients connected on the local port
+bool USLRawDataLogger::InitStreamServer(const int32 Port, const int32 MaxClientBacklogKB)
+{
+	if (StreamSink.IsValid())
+	{
+		return false;
+	}
+
+	TSharedRef<FSLRawDataStreamSink> NewStreamSink = MakeShareable(new FSLRawDataStreamSink());
+	if (!NewStreamSink->Listen(Port, MaxClientBacklogKB * 1024))
+	{
+		return false;
+	}
+
+	// The slow clients drop frames on their own, the queue merges frames if the sink thread falls behind
+	NewStreamSink->SetQueue(256, ESLRawDataQueuePolicy::Merge);
+	USLRawDataLogger::AddSink(NewStreamSink);
+	StreamSink = NewStreamSink;
+	return true;
+}
+
+// Publish the frames into a named shared memory ring for the local readers
+bool USLRawDataLogger::InitSharedMemory(const FString Name, const int32 NumSlots, const int32 MaxPosesPerFrame)
+{
+	if (SharedMemorySink.IsValid())
+	{
+		return false;
+	}
+
+	TSharedRef<FSLRawDataSharedMemorySink> NewSharedMemorySink = MakeShareable(new FSLRawDataSharedMemorySink());
+	if (!NewSharedMemorySink->Create(Name, NumSlots, MaxPosesPerFrame))
+	{
+		return false;
+	}
+
+	// The writer never waits for the readers, nor for the other sinks
+	NewSharedMemorySink->SetQueue(256, ESLRawDataQueuePolicy::Merge);
+	USLRawDataLogger::AddSink(NewSharedMemorySink);
+	SharedMemorySink = NewSharedMemorySink;
+	return true;
+}
+
+// Set per class sampling periods and the adaptive sampling (call before LogFirstEntry)
+void USLRawDataLogger::InitSampling(const TMap<FString, float>& InClassSamplingPeriods, bool bAdaptive, float InMaxSamplingPeriod)
+{
+	ClassSamplingPeriods = InClassSamplingPeriods;
+	bAdaptiveSampling = bAdaptive;
+	MaxSamplingPeriod = InMaxSamplingPeriod;
+	bUseScheduler = bAdaptiveSampling || ClassSamplingPeriods.Num() > 0;
+}
+
+// Sample at a fixed rate independent of the tick rate (call before LogFirstEntry)
+void USLRawDataLogger::InitFixedTimestep(const float SamplePeriod, const int32 InMaxCatchUpSamples)
+{
+	bFixedTimestep = SamplePeriod > 0.f;
+	FixedSamplePeriod = SamplePeriod;
+	MaxCatchUpSamples = FMath::Max(InMaxCatchUpSamples, 1);
+}
+
+// Quantize the poses, with the position precision (cm) per class (call before LogFirstEntry)
+void USLRawDataLogger::InitQuantization(const float InDefaultPositionPrecision, const TMap<FString, float>& InClassPositionPrecisions,
+	const bool bDeltaEncoding)
+{
+	bQuantize = InDefaultPositionPrecision > 0.f;
+	DefaultPositionPrecision = InDefaultPositionPrecision;
+	ClassPositionPrecisions = InClassPositionPrecisions;
+	bDeltaEncode = bDeltaEncoding;
+	if (FileSink.IsValid())
+	{
+		FileSink->SetQuantization(bQuantize, bDeltaEncode);
+	}
 }
 
 // Allow broadcasting the data as events
 void USLRawDataLogger::InitBroadcaster()
 {
-	bBroadcastData = true;
+	// Set up with the sinks, the json file can be created after this call
+	bBroadcast = true;
+}
+
+// Add an output for the frames, started with the first entry
+void USLRawDataLogger::AddSink(const TSharedRef<FSLRawDataSink>& Sink)
+{
+	// The sinks build their entity tables from the frames, they cannot join later
+	if (bSinksStarted)
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Sinks have to be added before the first entry"), TEXT(__FUNCTION__), __LINE__);
+		return;
+	}
+	Sinks.Add(Sink);
 }
 
 // Log dynamic and static entities to file
 void USLRawDataLogger::LogFirstEntry()
 {
-	// Get the dynamic entities data as json
-	FString FristEntryJsonOutputString;
-	if (USLRawDataLogger::GetAllEntitiesAsJson(FristEntryJsonOutputString))
+	if (!bIsInit)
 	{
-		// Append json to file 
-		if (bLogToFile)
-		{
-			USLRawDataLogger::InsertJsonContentToFile(FristEntryJsonOutputString);
-		}
+		return;
+	}
 
-		// Broadcast json
-		if (bBroadcastData)
-		{
-			USLRawDataLogger::BroadcastJsonContent(FristEntryJsonOutputString);
-		}
+	USLRawDataLogger::StartSinks();
+
+	// Get the dynamic and static entities data
+	if (!USLRawDataLogger::AcquireFrame())
+	{
+		return;
 	}
+	CurrFrame->Timestamp = World->GetTimeSeconds();
+	bInterpolateSample = false;
+	USLRawDataLogger::CaptureAllEntities();
+	USLRawDataLogger::CaptureDynamicEntities(true);
+	USLRawDataLogger::DispatchFrame();
+
+	// Fixed timestep samples are counted from the first entry
+	FirstSampleTime = World->GetTimeSeconds();
+	LastTickTime = FirstSampleTime;
+	NumSamples = 0;
 }
 
 // Log dynamic entities
 void USLRawDataLogger::LogDynamicEntities()
 {
-	// Get the dynamic entities data as json
-	FString DynamicJsonOutputString;
-	if (USLRawDataLogger::GetDynamicEntitiesAsJson(DynamicJsonOutputString))
+	// Get the dynamic entities data, the changes are written at the next update if no frame is free
+	if (!USLRawDataLogger::AcquireFrame())
 	{
-		// Append json to file 
-		if (bLogToFile)
-		{
-			USLRawDataLogger::InsertJsonContentToFile(DynamicJsonOutputString);
-		}
+		return;
+	}
+	CurrFrame->Timestamp = World->GetTimeSeconds();
+	bInterpolateSample = false;
+	USLRawDataLogger::CaptureDynamicEntities(false);
+	USLRawDataLogger::DispatchFrame();
+}
+
+// Log the dynamic entities at the fixed sample times passed since the previous tick (call every tick)
+void USLRawDataLogger::LogDynamicEntitiesFixedStep()
+{
+	if (!bFixedTimestep)
+	{
+		USLRawDataLogger::LogDynamicEntities();
+		return;
+	}
+
+	// Poses at the tick, the samples are interpolated from the previous tick
+	const double TickTime = World->GetTimeSeconds();
+	DynamicEntities.ReadTickPoses();
+
+	// Sample times are multiples of the period from the first entry, they do not accumulate errors
+	const int64 LastSample = (int64)FMath::FloorToDouble((TickTime - FirstSampleTime) / FixedSamplePeriod);
+	if (LastSample - NumSamples > MaxCatchUpSamples)
+	{
+		// Too far behind (e.g. a hitch), only write the latest samples
+		NumSamples = LastSample - MaxCatchUpSamples;
+	}
+
+	const double TickDuration = TickTime - LastTickTime;
+	while (NumSamples < LastSample)
+	{
+		NumSamples++;
+		const double SampleTime = FirstSampleTime + NumSamples * (double)FixedSamplePeriod;
 
-		// Broadcast json
-		if (bBroadcastData)
+		if (!USLRawDataLogger::AcquireFrame())
 		{
-			USLRawDataLogger::BroadcastJsonContent(DynamicJsonOutputString);
+			continue;
 		}
+		CurrFrame->Timestamp = (float)SampleTime;
+		bInterpolateSample = true;
+		SampleAlpha = TickDuration > 0.0 ? FMath::Clamp((float)((SampleTime - LastTickTime) / TickDuration), 0.f, 1.f) : 1.f;
+		USLRawDataLogger::CaptureDynamicEntities(false);
+		USLRawDataLogger::DispatchFrame();
+	}
+	LastTickTime = TickTime;
+}
+
+// Write the remaining data and close the outputs
+void USLRawDataLogger::Finish()
+{
+	// Blocks until the queued frames are consumed
+	for (const auto& SinkItr : Sinks)
+	{
+		SinkItr->Finish();
 	}
+	Sinks.Empty();
+	FileSink.Reset();
+	MongoSink.Reset();
+	StreamSink.Reset();
+	SharedMemorySink.Reset();
+	bSinksStarted = false;
 }
 
 // Add new dynamic entity for logging
@@ -114,15 +333,15 @@ void USLRawDataLogger::AddNewDynamicEntity(AActor* Actor)
 	{
 		const FString Id = FTagStatics::GetKeyValue(Actor->Tags[TagIndex], "Id");
 		const FString Class = FTagStatics::GetKeyValue(Actor->Tags[TagIndex], "Class");
-		if (!Id.IsEmpty() && !Class.IsEmpty())
+		if (!Id.IsEmpty() && !Class.IsEmpty() && Actor->GetRootComponent() && !DynamicEntities.Contains(Actor))
 		{
-			// Location is init automatically to -INF
 			const FString UniqueName = Class + "_" + Id;
-			FUniqueNameAndLocation UniqueNameAndInitLoc(UniqueName);
+			ASkeletalMeshActor* SkelActor = Cast<ASkeletalMeshActor>(Actor);
+			USkeletalMeshComponent* SkelMesh = SkelActor ? SkelActor->GetSkeletalMeshComponent() : nullptr;
+			const int32 EntityIndex = USLRawDataLogger::RegisterEntity(UniqueName, Actor->Tags[TagIndex], SkelMesh);
 
-			// Store the UniqueName and the Location of the dynamic entity
-			DynamicActorsWithData.Add(Actor,
-				FUniqueNameAndLocation(UniqueName, Actor->GetActorLocation()));
+			// Store the entity, it is written at the next update
+			USLRawDataLogger::AddToDynamicEntities(Actor, Actor->GetRootComponent(), SkelMesh, EntityIndex, Actor->Tags[TagIndex]);
 		}
 	}
 }
@@ -130,24 +349,12 @@ void USLRawDataLogger::AddNewDynamicEntity(AActor* Actor)
 // Remove dynamic entity from logging
 void USLRawDataLogger::RemoveDynamicEntity(AActor* Actor)
 {
-	DynamicActorsWithData.Remove(Actor);
+	DynamicEntities.Remove(Actor);
 }
 
-// Get the dynamic and static entities as json string
-bool USLRawDataLogger::GetAllEntitiesAsJson(FString& FirstJsonEntry)
+// Add the static entities to the frame and register the dynamic ones
+void USLRawDataLogger::CaptureAllEntities()
 {
-	if (!bIsInit)
-	{
-		return false;
-	}
-
-	// Create Json root object
-	TSharedPtr<FJsonObject> JsonRootObj = MakeShareable(new FJsonObject);
-	// Set timestamp
-	JsonRootObj->SetNumberField("timestamp", World->GetTimeSeconds());
-	// Json array of actors
-	TArray< TSharedPtr<FJsonValue> > JsonActorArr;
-
 	// Log static entities (logged only once at init)
 	TArray<AActor*> StaticActors = FTagStatics::GetActorsWithKeyValuePair(
 		World, "SemLog", "LogType", "Static");
@@ -159,11 +366,13 @@ bool USLRawDataLogger::GetAllEntitiesAsJson(FString& FirstJsonEntry)
 		{
 			const FString Id = FTagStatics::GetKeyValue(ActItr->Tags[TagIndex], "Id");
 			const FString Class = FTagStatics::GetKeyValue(ActItr->Tags[TagIndex], "Class");
-			if (!Id.IsEmpty() && !Class.IsEmpty())
+			if (!Id.IsEmpty() && !Class.IsEmpty() && ActItr->GetRootComponent())
 			{
-				// Location is init automatically to -INF
-				FUniqueNameAndLocation UniqueNameAndInitLoc(Class + "_" + Id);
-				USLRawDataLogger::AddActorToJsonArray(JsonActorArr, ActItr, UniqueNameAndInitLoc);
+				const FString UniqueName = Class + "_" + Id;
+				ASkeletalMeshActor* SkelActor = Cast<ASkeletalMeshActor>(ActItr);
+				USkeletalMeshComponent* SkelMesh = SkelActor ? SkelActor->GetSkeletalMeshComponent() : nullptr;
+				const int32 EntityIndex = USLRawDataLogger::RegisterEntity(UniqueName, ActItr->Tags[TagIndex], SkelMesh);
+				USLRawDataLogger::AddPoseToFrame(EntityIndex, ActItr->GetRootComponent(), SkelMesh);
 			}
 		}
 	}
@@ -190,8 +399,10 @@ bool USLRawDataLogger::GetAllEntitiesAsJson(FString& FirstJsonEntry)
 			const FString Class = FTagStatics::GetKeyValue(CompItr->ComponentTags[TagIndex], "Class");
 			if (!Id.IsEmpty() && !Class.IsEmpty())
 			{
-				FUniqueNameAndLocation UniqueNameAndInitLoc(Class + "_" + Id);
-				USLRawDataLogger::AddComponentToJsonArray(JsonActorArr, CompItr, UniqueNameAndInitLoc);
+				const FString UniqueName = Class + "_" + Id;
+				USkeletalMeshComponent* SkelMesh = Cast<USkeletalMeshComponent>(CompItr);
+				const int32 EntityIndex = USLRawDataLogger::RegisterEntity(UniqueName, CompItr->ComponentTags[TagIndex], SkelMesh);
+				USLRawDataLogger::AddPoseToFrame(EntityIndex, CompItr, SkelMesh);
 			}
 		}
 	}
@@ -207,16 +418,15 @@ bool USLRawDataLogger::GetAllEntitiesAsJson(FString& FirstJsonEntry)
 		{
 			const FString Id = FTagStatics::GetKeyValue(DynActItr->Tags[TagIndex], "Id");
 			const FString Class = FTagStatics::GetKeyValue(DynActItr->Tags[TagIndex], "Class");
-			if (!Id.IsEmpty() && !Class.IsEmpty())
+			if (!Id.IsEmpty() && !Class.IsEmpty() && DynActItr->GetRootComponent() && !DynamicEntities.Contains(DynActItr))
 			{
-				// Location is init automatically to -INF
 				const FString UniqueName = Class + "_" + Id;
-				FUniqueNameAndLocation UniqueNameAndInitLoc(UniqueName);
-				USLRawDataLogger::AddActorToJsonArray(JsonActorArr, DynActItr, UniqueNameAndInitLoc);
+				ASkeletalMeshActor* SkelActor = Cast<ASkeletalMeshActor>(DynActItr);
+				USkeletalMeshComponent* SkelMesh = SkelActor ? SkelActor->GetSkeletalMeshComponent() : nullptr;
+				const int32 EntityIndex = USLRawDataLogger::RegisterEntity(UniqueName, DynActItr->Tags[TagIndex], SkelMesh);
 
-				// Store the UniqueName and the Location of the dynamic entity
-				DynamicActorsWithData.Add(DynActItr,
-					FUniqueNameAndLocation(UniqueName, DynActItr->GetActorLocation()));
+				// Store the entity, it is written at the next update
+				USLRawDataLogger::AddToDynamicEntities(DynActItr, DynActItr->GetRootComponent(), SkelMesh, EntityIndex, DynActItr->Tags[TagIndex]);
 			}
 		}
 	}
@@ -241,234 +451,477 @@ bool USLRawDataLogger::GetAllEntitiesAsJson(FString& FirstJsonEntry)
 		{
 			const FString Id = FTagStatics::GetKeyValue(DynCompItr->ComponentTags[TagIndex], "Id");
 			const FString Class = FTagStatics::GetKeyValue(DynCompItr->ComponentTags[TagIndex], "Class");
-			if (!Id.IsEmpty() && !Class.IsEmpty())
+			if (!Id.IsEmpty() && !Class.IsEmpty() && !DynamicEntities.Contains(DynCompItr))
 			{
-				// Location is init automatically to -INF
 				const FString UniqueName = Class + "_" + Id;
-				FUniqueNameAndLocation UniqueNameAndInitLoc(UniqueName);
-				USLRawDataLogger::AddComponentToJsonArray(JsonActorArr, DynCompItr, UniqueNameAndInitLoc);
+				USkeletalMeshComponent* SkelMesh = Cast<USkeletalMeshComponent>(DynCompItr);
+				const int32 EntityIndex = USLRawDataLogger::RegisterEntity(UniqueName, DynCompItr->ComponentTags[TagIndex], SkelMesh);
+
+				// Store the entity, it is written at the next update
+				USLRawDataLogger::AddToDynamicEntities(DynCompItr, DynCompItr, SkelMesh, EntityIndex, DynCompItr->ComponentTags[TagIndex]);
+			}
+		}
+	}
+}
+
+// Add the dynamic entities which changed to the frame
+void USLRawDataLogger::CaptureDynamicEntities(bool bForceKeyframe)
+{
+	// Every KeyframeInterval updates all dynamic entities are written with all their bones
+	bool bKeyframe = bForceKeyframe;
+	if (KeyframeInterval > 0 && ++UpdatesSinceKeyframe >= KeyframeInterval)
+	{
+		bKeyframe = true;
+	}
+	if (bKeyframe)
+	{
+		UpdatesSinceKeyframe = 0;
+		CurrFrame->bIsKeyframe = true;
+	}
+
+	// Only the entities due in the sampling schedule are read (all of them on keyframes)
+	const float Time = CurrFrame->Timestamp;
+	if (bUseScheduler)
+	{
+		USLRawDataLogger::PopDueEntities(Time);
+	}
 
-				// Store the UniqueName and the Location of the dynamic entity
-				DynamicComponentsWithData.Add(DynCompItr,
-					FUniqueNameAndLocation(UniqueName, DynCompItr->GetComponentLocation()));
+	// Read (or interpolate to the sample time) the current poses first, then compare them in batches
+	const TArray<uint32>* SampledMask = (bUseScheduler && !bKeyframe) ? &DueMask : nullptr;
+	if (bInterpolateSample)
+	{
+		DynamicEntities.InterpolateCurrPoses(SampleAlpha, SampledMask);
+	}
+	else if (SampledMask)
+	{
+		DynamicEntities.UpdateCurrPoses(*SampledMask);
+	}
+	else
+	{
+		DynamicEntities.UpdateCurrPoses();
+	}
+	FSLRawDataMotion::ComputeMovedMask(DynamicEntities.CurrLocations.GetData(),
+		DynamicEntities.PrevLocations.GetData(), DynamicEntities.SquaredDistanceThresholds.GetData(),
+		DynamicEntities.Num(), MovedMask);
+	FSLRawDataMotion::AddRotatedToMask(DynamicEntities.CurrRotations.GetData(),
+		DynamicEntities.PrevRotations.GetData(), DynamicEntities.MinQuatDots.GetData(),
+		DynamicEntities.Num(), MovedMask);
+
+	// Skeletal entities are always visited, their bones can change while the root stays still
+	const TArray<uint32>& SkeletalMask = DynamicEntities.GetSkeletalMask();
+
+	// Only visit the entities which moved or rotated, or may have moved bones
+	const int32 NumDynamicEntities = DynamicEntities.Num();
+	for (int32 WordIdx = 0; WordIdx < MovedMask.Num(); ++WordIdx)
+	{
+		const uint32 MovedWord = MovedMask[WordIdx];
+		uint32 Word = bKeyframe ? ~0u : (MovedWord | SkeletalMask[WordIdx]);
+		if (bUseScheduler && !bKeyframe)
+		{
+			Word &= DueMask[WordIdx];
+		}
+		while (Word)
+		{
+			const int32 Slot = (WordIdx << 5) + FMath::CountTrailingZeros(Word);
+			Word &= Word - 1;
+			if (Slot >= NumDynamicEntities)
+			{
+				break;
 			}
+
+			const bool bRootChanged = bKeyframe || (MovedWord & (1u << (Slot & 31))) != 0;
+			USLRawDataLogger::AddDynamicEntityToFrame(Slot, bRootChanged, bKeyframe);
 		}
 	}
 
-	// Add actors to Json root
-	JsonRootObj->SetArrayField("actors", JsonActorArr);
+	if (bUseScheduler)
+	{
+		USLRawDataLogger::ScheduleNextSamples(Time);
+	}
+}
 
-	// Transform to string
-	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&FirstJsonEntry);
-	FJsonSerializer::Serialize(JsonRootObj.ToSharedRef(), Writer);
+// Get the entities due for sampling, sets their bits in the due mask
+void USLRawDataLogger::PopDueEntities(float Time)
+{
+	DueSlots.Reset();
+	Scheduler.PopDue(Time, DueSlots);
 
-	return (!FirstJsonEntry.IsEmpty());
+	DueMask.Reset();
+	DueMask.AddZeroed((DynamicEntities.Num() + 31) / 32);
+	for (int32 Idx = DueSlots.Num() - 1; Idx >= 0; --Idx)
+	{
+		// Entity indexes are replaced by their slots, removed entities leave the schedule
+		const int32 Slot = DynamicEntities.GetSlot(DueSlots[Idx]);
+		if (Slot == INDEX_NONE)
+		{
+			DueSlots.RemoveAtSwap(Idx, 1, false);
+			continue;
+		}
+		DueSlots[Idx] = Slot;
+		DueMask[Slot >> 5] |= 1u << (Slot & 31);
+	}
 }
 
-// Get logged dynamic entities as json string
-bool USLRawDataLogger::GetDynamicEntitiesAsJson(FString& DynamicJsonEntry)
+// Schedule the next sample of the entities sampled at this update
+void USLRawDataLogger::ScheduleNextSamples(float Time)
 {
-	// Create Json root object
-	// Json root object
-	TSharedPtr<FJsonObject> JsonRootObj = MakeShareable(new FJsonObject);
+	for (const int32 Slot : DueSlots)
+	{
+		const float Period = bAdaptiveSampling ?
+			USLRawDataLogger::GetAdaptiveSamplingPeriod(Slot, Time) : DynamicEntities.SamplingPeriods[Slot];
+
+		DynamicEntities.CurrSamplingPeriods[Slot] = Period;
+		DynamicEntities.LastSampleTimes[Slot] = Time;
+		DynamicEntities.LastSampleLocations[Slot] = DynamicEntities.CurrLocations[Slot];
+		DynamicEntities.LastSampleRotations[Slot] = DynamicEntities.CurrRotations[Slot];
+		Scheduler.Schedule(DynamicEntities.EntityIndices[Slot], Time + Period);
+	}
+}
 
-	// Json array of actors
-	TArray<TSharedPtr<FJsonValue>> JsonActorArr;
+// Get the time until the next sample from the change since the last one
+float USLRawDataLogger::GetAdaptiveSamplingPeriod(int32 Slot, float Time) const
+{
+	// Periods grow by this factor per sample while the entity is idle
+	const float IdleGrowth = 1.5f;
 
-	// Iterate and log dynamic actors
-	for (auto& ActWithDataItr : DynamicActorsWithData)
+	const float MinPeriod = DynamicEntities.SamplingPeriods[Slot];
+	const float MaxPeriod = FMath::Max(MaxSamplingPeriod, MinPeriod);
+	const float Elapsed = Time - DynamicEntities.LastSampleTimes[Slot];
+	if (!(Elapsed > 0.f) || !FMath::IsFinite(Elapsed))
 	{
-		USLRawDataLogger::AddActorToJsonArray(JsonActorArr,
-			ActWithDataItr.Key, ActWithDataItr.Value);
+		// First sample
+		return MinPeriod;
 	}
 
-	// Iterate and log dynamic components
-	for (auto& CompWithDataItr : DynamicComponentsWithData)
+	// Change since the last sample in multiples of the thresholds of the entity
+	float Change = 0.f;
+	const float EntitySquaredDistanceThreshold = DynamicEntities.SquaredDistanceThresholds[Slot];
+	if (EntitySquaredDistanceThreshold > 0.f)
 	{
-		USLRawDataLogger::AddComponentToJsonArray(JsonActorArr,
-			CompWithDataItr.Key, CompWithDataItr.Value);
+		Change = FMath::Sqrt(FVector::DistSquared(DynamicEntities.CurrLocations[Slot],
+			DynamicEntities.LastSampleLocations[Slot]) / EntitySquaredDistanceThreshold);
+	}
+	const float EntityMinQuatDot = DynamicEntities.MinQuatDots[Slot];
+	if (EntityMinQuatDot > -1.f && EntityMinQuatDot < 1.f)
+	{
+		const float Dot = FMath::Min(FMath::Abs(DynamicEntities.CurrRotations[Slot] | DynamicEntities.LastSampleRotations[Slot]), 1.f);
+		Change = FMath::Max(Change, FMath::Acos(Dot) / FMath::Acos(EntityMinQuatDot));
 	}
 
-	// Avoid appending empty entries
-	if (JsonActorArr.Num() > 0)
+	// Time to change by one threshold at the current speed, faster entities are sampled
+	// at once at the higher rate, idle ones slow down gradually
+	const float TargetPeriod = Change > KINDA_SMALL_NUMBER ? Elapsed / Change : MaxPeriod;
+	return FMath::Clamp(FMath::Min(TargetPeriod, Elapsed * IdleGrowth), MinPeriod, MaxPeriod);
+}
+
+// Add the dynamic entity to the frame, skeletal entities only with the bones which changed
+void USLRawDataLogger::AddDynamicEntityToFrame(int32 Slot, bool bRootChanged, bool bAllBones)
+{
+	const int32 EntityIndex = DynamicEntities.EntityIndices[Slot];
+	USkeletalMeshComponent* SkelMesh = DynamicEntities.SkelMeshes[Slot];
+	if (!SkelMesh)
 	{
-		// Set timestamp
-		JsonRootObj->SetNumberField("timestamp", World->GetTimeSeconds());
+		// Update previous pose
+		DynamicEntities.CommitPose(Slot);
+		CurrFrame->Poses.Emplace(EntityIndex, INDEX_NONE,
+			DynamicEntities.CurrLocations[Slot], DynamicEntities.CurrRotations[Slot]);
+		return;
+	}
 
-		// Add actors to Json root
-		JsonRootObj->SetArrayField("actors", JsonActorArr);
+	// Compare the bones against their last written poses
+	FSLRawDataBoneStates& BoneStates = DynamicEntities.BoneStates[Slot];
+	if (bInterpolateSample)
+	{
+		// The bones keep their pose of the tick, relative to the interpolated entity pose
+		const FTransform& RootToWorld = DynamicEntities.Components[Slot]->GetComponentTransform();
+		const FTransform SkelToRoot = SkelMesh->GetComponentTransform().GetRelativeTransform(RootToWorld);
+		const FTransform SampleRootToWorld(DynamicEntities.CurrRotations[Slot],
+			DynamicEntities.CurrLocations[Slot], RootToWorld.GetScale3D());
+		FSLRawDataEntityRegistry::ReadBonePoses(SkelMesh, BoneStates.BoneIndices, SkelToRoot * SampleRootToWorld,
+			BoneLocations, BoneRotations);
+	}
+	else
+	{
+		FSLRawDataEntityRegistry::ReadBonePoses(SkelMesh, BoneStates.BoneIndices, BoneLocations, BoneRotations);
+	}
+	if (BoneStates.PrevLocations.Num() != BoneLocations.Num())
+	{
+		// Never written
+		BoneStates.PrevLocations.SetNum(BoneLocations.Num());
+		BoneStates.PrevRotations.SetNum(BoneRotations.Num());
+		bAllBones = true;
+	}
 
-		// Transform to string
-		FString JsonOutputString;
-		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&DynamicJsonEntry);
-		FJsonSerializer::Serialize(JsonRootObj.ToSharedRef(), Writer);
+	const float BoneSquaredDistanceThreshold = DynamicEntities.SquaredDistanceThresholds[Slot];
+	const float BoneMinQuatDot = DynamicEntities.MinQuatDots[Slot];
+	ChangedBones.Reset();
+	for (int32 BoneIndex = 0; BoneIndex < BoneLocations.Num(); ++BoneIndex)
+	{
+		if (bAllBones ||
+			FVector::DistSquared(BoneLocations[BoneIndex], BoneStates.PrevLocations[BoneIndex]) > BoneSquaredDistanceThreshold ||
+			FMath::Abs(BoneRotations[BoneIndex] | BoneStates.PrevRotations[BoneIndex]) < BoneMinQuatDot)
+		{
+			ChangedBones.Add(BoneIndex);
+		}
+	}
 
-		return true;
+	if (!bRootChanged && ChangedBones.Num() == 0)
+	{
+		return;
 	}
 
-	// No dynamic entities to be logged
-	return false;
-}
+	// The entity pose is always written before its bones
+	DynamicEntities.CommitPose(Slot);
+	CurrFrame->Poses.Emplace(EntityIndex, INDEX_NONE,
+		DynamicEntities.CurrLocations[Slot], DynamicEntities.CurrRotations[Slot]);
 
-// Append string to the file
-bool USLRawDataLogger::InsertJsonContentToFile(const FString& JsonString)
-{
-	if (!FileHandle)
+	for (const int32 BoneIndex : ChangedBones)
 	{
-		return false;
+		BoneStates.PrevLocations[BoneIndex] = BoneLocations[BoneIndex];
+		BoneStates.PrevRotations[BoneIndex] = BoneRotations[BoneIndex];
+		CurrFrame->Poses.Emplace(EntityIndex, BoneIndex, BoneLocations[BoneIndex], BoneRotations[BoneIndex]);
 	}
-	// Write string to file
-	return FileHandle->Write((const uint8*)TCHAR_TO_ANSI(*JsonString), JsonString.Len());
 }
 
-// Broadcast json content
-void USLRawDataLogger::BroadcastJsonContent(const FString& JsonString)
+// Store the dynamic entity with its change thresholds and sampling period, it is written at the next update
+void USLRawDataLogger::AddToDynamicEntities(UObject* Key, USceneComponent* Component, USkeletalMeshComponent* SkelMesh,
+	int32 EntityIndex, const FName& SemLogTag)
 {
-	OnNewData.Broadcast(JsonString);
+	float EntitySquaredDistanceThreshold, EntityMinQuatDot;
+	USLRawDataLogger::GetChangeThresholds(SemLogTag, EntitySquaredDistanceThreshold, EntityMinQuatDot);
+	const float SamplingPeriod = USLRawDataLogger::GetSamplingPeriod(SemLogTag);
+	if (SamplingPeriod > 0.f)
+	{
+		bUseScheduler = true;
+	}
+
+	DynamicEntities.Add(Key, Component, SkelMesh,
+		EntityIndex, EntitySquaredDistanceThreshold, EntityMinQuatDot, SamplingPeriod);
+	Scheduler.Schedule(EntityIndex, World->GetTimeSeconds());
 }
 
-// Create Json object with a 3d location
-FORCEINLINE TSharedPtr<FJsonObject> USLRawDataLogger::CreateLocationJsonObject(const FVector& Location)
+// Get the sampling period of the entity (SemLog tag, class period, or 0 for every update)
+float USLRawDataLogger::GetSamplingPeriod(const FName& SemLogTag) const
 {
-	// Json location object
-	TSharedPtr<FJsonObject> JsonObj = MakeShareable(new FJsonObject);
-	// Add fields
-	JsonObj->SetNumberField("x", Location.X);
-	JsonObj->SetNumberField("y", -Location.Y); // left to right handed
-	JsonObj->SetNumberField("z", Location.Z);
+	const FString SamplingPeriodValue = FTagStatics::GetKeyValue(SemLogTag, "SamplingPeriod");
+	if (!SamplingPeriodValue.IsEmpty())
+	{
+		return FMath::Max(FCString::Atof(*SamplingPeriodValue), 0.f);
+	}
 
-	return JsonObj;
+	if (const float* ClassSamplingPeriod = ClassSamplingPeriods.Find(FTagStatics::GetKeyValue(SemLogTag, "Class")))
+	{
+		return FMath::Max(*ClassSamplingPeriod, 0.f);
+	}
+	return 0.f;
 }
 
-// Create Json object with a 3d rotation as quaternion 
-FORCEINLINE TSharedPtr<FJsonObject> USLRawDataLogger::CreateRotationJsonObject(const FQuat& Rotation)
+// Get the position precision of the entity (0 if not quantized or flagged as lossless)
+float USLRawDataLogger::GetPositionPrecision(const FName& SemLogTag) const
 {
-	// Json rotation object
-	TSharedPtr<FJsonObject> JsonObj = MakeShareable(new FJsonObject);
-	// Add fields
-	JsonObj->SetNumberField("w", Rotation.W);
-	JsonObj->SetNumberField("x", -Rotation.X); // left to right handed
-	JsonObj->SetNumberField("y", Rotation.Y);
-	JsonObj->SetNumberField("z", -Rotation.Z); // left to right handed
+	if (!bQuantize || FTagStatics::GetKeyValue(SemLogTag, "Lossless").Equals("true", ESearchCase::IgnoreCase))
+	{
+		return 0.f;
+	}
+
+	const FString PrecisionValue = FTagStatics::GetKeyValue(SemLogTag, "Precision");
+	if (!PrecisionValue.IsEmpty())
+	{
+		return FMath::Max(FCString::Atof(*PrecisionValue), 0.f);
+	}
 
-	return JsonObj;
+	if (const float* ClassPositionPrecision = ClassPositionPrecisions.Find(FTagStatics::GetKeyValue(SemLogTag, "Class")))
+	{
+		return FMath::Max(*ClassPositionPrecision, 0.f);
+	}
+	return DefaultPositionPrecision;
 }
 
-// Create Json object with name location and rotation
-FORCEINLINE TSharedPtr<FJsonObject> USLRawDataLogger::CreateNameLocRotJsonObject(
-	const FString& Name, const FVector& Location, const FQuat& Rotation)
+// Get the change thresholds of the entity, the defaults can be overridden in the SemLog tag
+// (e.g. SemLog;Class,Mug;Id,a1B2;LogType,Dynamic;DistanceThreshold,0.1;AngularThreshold,2;)
+void USLRawDataLogger::GetChangeThresholds(const FName& SemLogTag, float& OutSquaredDistanceThreshold, float& OutMinQuatDot) const
 {
-	// Json  actor object
-	TSharedPtr<FJsonObject> JsonObj = MakeShareable(new FJsonObject);
-	// Add fields
-	JsonObj->SetStringField("name", Name);
-	JsonObj->SetObjectField("pos", USLRawDataLogger::CreateLocationJsonObject(Location));
-	JsonObj->SetObjectField("rot", USLRawDataLogger::CreateRotationJsonObject(Rotation));
+	OutSquaredDistanceThreshold = SquaredDistanceThreshold;
+	OutMinQuatDot = MinQuatDot;
+
+	const FString DistanceThresholdValue = FTagStatics::GetKeyValue(SemLogTag, "DistanceThreshold");
+	if (!DistanceThresholdValue.IsEmpty())
+	{
+		const float EntityDistanceThreshold = FCString::Atof(*DistanceThresholdValue);
+		OutSquaredDistanceThreshold = EntityDistanceThreshold * EntityDistanceThreshold;
+	}
 
-	return JsonObj;
+	const FString AngularThresholdValue = FTagStatics::GetKeyValue(SemLogTag, "AngularThreshold");
+	if (!AngularThresholdValue.IsEmpty())
+	{
+		OutMinQuatDot = FSLRawDataMotion::AngularThresholdToMinQuatDot(FCString::Atof(*AngularThresholdValue));
+	}
 }
 
-// Add the actors raw data to the json array
-void USLRawDataLogger::AddActorToJsonArray(
-	TArray<TSharedPtr<FJsonValue>>& OutJsonArray,
-	AActor* Actor,
-	FUniqueNameAndLocation &UniqueNameAndLocation)
+// Get a free frame from the pool as the current frame
+bool USLRawDataLogger::AcquireFrame()
 {
-	// Get entity current location
-	const FVector CurrLocation = Actor->GetActorLocation();
-	// Write raw data if distance larger than threshold
-	if (FVector::DistSquared(CurrLocation, UniqueNameAndLocation.Location) > SquaredDistanceThreshold)
+	CurrFrame = FramePool->Acquire();
+	if (!CurrFrame.IsValid())
 	{
-		// Update previous location
-		UniqueNameAndLocation.Location = CurrLocation;
+		// The sinks and the subscribers hold all the frames, the update is skipped
+		if (NumSkippedFrames++ == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT(" %s::%d All %d raw data frames are in use, skipping updates"),
+				TEXT(__FUNCTION__), __LINE__, FramePool->GetNumFrames());
+		}
+		return false;
+	}
+	return true;
+}
 
-		// Json actor object with name location and rotation
-		TSharedPtr<FJsonObject> JsonActorObj = USLRawDataLogger::CreateNameLocRotJsonObject(
-			UniqueNameAndLocation.UniqueName, CurrLocation * 0.01f, Actor->GetActorQuat());
+// Hand the captured frame over to the frame subscribers and the sinks
+void USLRawDataLogger::DispatchFrame()
+{
+	// The frame goes back to the pool once released by the sinks and the subscribers
+	const TSharedRef<FSLRawDataFrame, ESPMode::ThreadSafe> Frame = CurrFrame.ToSharedRef();
+	CurrFrame.Reset();
 
-		// Check if actor is skeletal
-		if (Actor->IsA(ASkeletalMeshActor::StaticClass()))
-		{
-			// Cast and get the skeletal mesh component
-			USkeletalMeshComponent* CurrSkelMesh = Cast<ASkeletalMeshActor>(Actor)->GetSkeletalMeshComponent();
+	// Avoid appending empty entries
+	if (Frame->Poses.Num() == 0)
+	{
+		return;
+	}
 
-			// Json array of bones
-			TArray<TSharedPtr<FJsonValue>> JsonBoneArr;
+	// Entity descriptions not yet written out go with this frame
+	Exchange(Frame->NewEntities, PendingEntities);
+	DispatchedEntities.Append(Frame->NewEntities);
 
-			// Get bone names
-			TArray<FName> BoneNames;
-			CurrSkelMesh->GetBoneNames(BoneNames);
+	// Subscribers read the captured frame, concurrently with its serialization
+	if (OnNewFrame.IsBound())
+	{
+		OnNewFrame.Broadcast(Frame, DispatchedEntities);
+	}
 
-			// Iterate through the bones of the skeletal mesh
-			for (const auto& BoneName : BoneNames)
-			{
-				// TODO black voodo magic crashes, bug report, crashes if this is not called before
-				CurrSkelMesh->GetBoneQuaternion(BoneName);
+	// Every sink consumes the frames in order on its own thread
+	for (const auto& SinkItr : Sinks)
+	{
+		SinkItr->Enqueue(Frame);
+	}
+}
 
-				// Json bone object with name location and rotation
-				TSharedPtr<FJsonObject> JsonBoneObj = USLRawDataLogger::CreateNameLocRotJsonObject(
-					BoneName.ToString(), CurrSkelMesh->GetBoneLocation(BoneName) * 0.01f,
-					CurrSkelMesh->GetBoneQuaternion(BoneName));
+// Start the sink threads
+void USLRawDataLogger::StartSinks()
+{
+	if (bSinksStarted)
+	{
+		return;
+	}
 
-				// Add bone to Json array
-				JsonBoneArr.Add(MakeShareable(new FJsonValueObject(JsonBoneObj)));
-			}
-			// Add bones to Json actor
-			JsonActorObj->SetArrayField("bones", JsonBoneArr);
-		}
+	if (bBroadcast)
+	{
+		USLRawDataLogger::StartBroadcast();
+	}
 
-		// Add actor to Json array
-		OutJsonArray.Add(MakeShareable(new FJsonValueObject(JsonActorObj)));
+	// Bound the frames to the ones the sinks and subscribers can hold, unless a sink queue grows
+	int32 MaxFrames = NumPreallocatedFrames + NumSubscriberFrames;
+	for (const auto& SinkItr : Sinks)
+	{
+		SinkItr->Start();
+		const int32 MaxHeldFrames = SinkItr->GetMaxHeldFrames();
+		MaxFrames = (MaxFrames > 0 && MaxHeldFrames != INDEX_NONE) ? MaxFrames + MaxHeldFrames : 0;
 	}
+	FramePool->SetMaxFrames(MaxFrames);
+	bSinksStarted = true;
 }
 
-// Add component's data to the json array
-void USLRawDataLogger::AddComponentToJsonArray(
-	TArray<TSharedPtr<FJsonValue>>& OutJsonArray,
-	USceneComponent* Component,
-	FUniqueNameAndLocation &UniqueNameAndLocation)
+// Pass the json bytes to the game thread subscribers
+void USLRawDataLogger::StartBroadcast()
 {
-	// Get entity current location
-	const FVector CurrLocation = Component->GetComponentLocation();
-	// Write raw data if distance larger than threshold
-	if (FVector::DistSquared(CurrLocation, UniqueNameAndLocation.Location) > SquaredDistanceThreshold)
+	// One game thread task per batch, the buffers are shared, not copied
+	TWeakObjectPtr<USLRawDataLogger> WeakThis(this);
+	FSLRawDataJsonBytesCallback OnJsonBytes = [WeakThis](TArray<FSLRawDataJsonBytesRef>& JsonBatch)
 	{
-		// Update previous location
-		UniqueNameAndLocation.Location = CurrLocation;
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Batch = MoveTemp(JsonBatch)]()
+		{
+			if (WeakThis.IsValid())
+			{
+				for (const FSLRawDataJsonBytesRef& BytesItr : Batch)
+				{
+					WeakThis->BroadcastJsonContent(*BytesItr);
+				}
+			}
+		});
+	};
 
-		// Json actor object with name location and rotation
-		TSharedPtr<FJsonObject> JsonActorObj = USLRawDataLogger::CreateNameLocRotJsonObject(
-			UniqueNameAndLocation.UniqueName, CurrLocation * 0.01f, Component->GetComponentQuat());
+	TSharedRef<FSLRawDataSink> BroadcastSink = MakeShareable(new FSLRawDataBroadcastSink(OnJsonBytes));
+	if (!FileSink.IsValid() || FileSink->GetFormat() != ESLRawDataFormat::Json)
+	{
+		USLRawDataLogger::AddSink(BroadcastSink);
+		return;
+	}
 
-		// Check if actor is skeletal
-		if (USkeletalMeshComponent* CurrSkelMesh = Cast<USkeletalMeshComponent>(Component))
-		{
-			// Json array of bones
-			TArray<TSharedPtr<FJsonValue>> JsonBoneArr;
+	// The frames are serialized once for the json file and the broadcast, a slow disk does not delay the broadcast
+	// (the encoding waits only if the file queue is full and blocks)
+	TSharedRef<FSLRawDataJsonEncodeSink> EncodeSink = MakeShareable(new FSLRawDataJsonEncodeSink());
+	EncodeSink->SetQueue(FileSink->GetCapacity(), FileSink->GetPolicy());
+	Sinks.Remove(FileSink.ToSharedRef());
+	EncodeSink->AddTarget(FileSink.ToSharedRef());
+	EncodeSink->AddTarget(BroadcastSink);
+	USLRawDataLogger::AddSink(EncodeSink);
+}
 
-			// Get bone names
-			TArray<FName> BoneNames;
-			CurrSkelMesh->GetBoneNames(BoneNames);
+// Broadcast json content (called on the game thread)
+void USLRawDataLogger::BroadcastJsonContent(const TArray<uint8>& JsonBytes)
+{
+	OnNewJsonBytes.Broadcast(JsonBytes);
 
-			// Iterate through the bones of the skeletal mesh
-			for (const auto& BoneName : BoneNames)
-			{
-				// TODO black voodo magic crashes, bug report, crashes if this is not called before
-				CurrSkelMesh->GetBoneQuaternion(BoneName);
+	// Convert only if there are string subscribers
+	if (OnNewData.IsBound())
+	{
+		FUTF8ToTCHAR Converter((const ANSICHAR*)JsonBytes.GetData(), JsonBytes.Num());
+		OnNewData.Broadcast(FString(Converter.Length(), Converter.Get()));
+	}
+}
 
-				// Json bone object with name location and rotation
-				TSharedPtr<FJsonObject> JsonBoneObj = USLRawDataLogger::CreateNameLocRotJsonObject(
-					BoneName.ToString(), CurrSkelMesh->GetBoneLocation(BoneName) * 0.01f,
-					CurrSkelMesh->GetBoneQuaternion(BoneName));
+// Give the entity an index and store its description
+int32 USLRawDataLogger::RegisterEntity(const FString& UniqueName, const FName& SemLogTag, USkeletalMeshComponent* SkelMesh)
+{
+	// The description is sent with the next frame
+	const int32 EntityIndex = NumEntities++;
+	FSLRawDataEntityDesc& EntityDesc = PendingEntities[PendingEntities.Emplace(EntityIndex, UniqueName)];
+	EntityDesc.PositionPrecision = USLRawDataLogger::GetPositionPrecision(SemLogTag);
 
-				// Add bone to Json array
-				JsonBoneArr.Add(MakeShareable(new FJsonValueObject(JsonBoneObj)));
-			}
-			// Add bones to Json actor
-			JsonActorObj->SetArrayField("bones", JsonBoneArr);
+	// Bones are indexed in the order given by the skeletal mesh
+	if (SkelMesh)
+	{
+		TArray<FName> BoneNames;
+		SkelMesh->GetBoneNames(BoneNames);
+		for (const auto& BoneName : BoneNames)
+		{
+			EntityDesc.BoneNames.Emplace(BoneName.ToString());
 		}
+	}
+	return EntityIndex;
+}
+
+// Add the pose of the entity (and of its bones) to the frame
+void USLRawDataLogger::AddPoseToFrame(int32 EntityIndex, USceneComponent* Component, USkeletalMeshComponent* SkelMesh)
+{
+	// Entity pose
+	CurrFrame->Poses.Emplace(EntityIndex, INDEX_NONE,
+		Component->GetComponentLocation(), Component->GetComponentQuat());
 
-		// Add actor to Json array
-		OutJsonArray.Add(MakeShareable(new FJsonValueObject(JsonActorObj)));
+	// Check if entity is skeletal
+	if (SkelMesh)
+	{
+		USLRawDataLogger::AddBonesToFrame(EntityIndex, SkelMesh);
 	}
-}
\ No newline at end of file
+}
+
+// Add all the bones of the skeletal mesh to the frame
+void USLRawDataLogger::AddBonesToFrame(int32 EntityIndex, USkeletalMeshComponent* SkelMesh)
+{
+	// Logged only once, no need to keep the indexes
+	FSLRawDataEntityRegistry::ResolveBoneIndices(SkelMesh, BoneIndices);
+	FSLRawDataEntityRegistry::ReadBonePoses(SkelMesh, BoneIndices, BoneLocations, BoneRotations);
+	for (int32 BoneIndex = 0; BoneIndex < BoneLocations.Num(); ++BoneIndex)
+	{
+		CurrFrame->Poses.Emplace(EntityIndex, BoneIndex, BoneLocations[BoneIndex], BoneRotations[BoneIndex]);
+	}
+}
@@ -0,0 +1,223 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataMongoSink.h"
+
+// Constructor
+FSLRawDataMongoSink::FSLRawDataMongoSink()
+	:
+#ifdef WITH_MONGO
+	Client(nullptr), Collection(nullptr), Bulk(nullptr),
+#endif //WITH_MONGO
+	BatchSize(1000), FlushInterval(1.f), NumInBulk(0), BulkStartTime(0.0)
+{
+}
+
+// Destructor, sends the queued frames
+FSLRawDataMongoSink::~FSLRawDataMongoSink()
+{
+	FSLRawDataSink::Finish();
+#ifdef WITH_MONGO
+	FSLRawDataMongoSink::Disconnect();
+#endif //WITH_MONGO
+}
+
+// Connect to the server
+bool FSLRawDataMongoSink::Connect(const FString& Uri, const FString& Database, const FString& InCollection,
+	int32 InBatchSize, float InFlushInterval)
+{
+#ifdef WITH_MONGO
+	if (IsStarted() || Client)
+	{
+		return false;
+	}
+
+	mongoc_uri_t* MongoUri = mongoc_uri_new(TCHAR_TO_UTF8(*Uri));
+	if (!MongoUri)
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Invalid mongo uri: %s"), TEXT(__FUNCTION__), __LINE__, *Uri);
+		return false;
+	}
+
+	// The ping runs on the calling (game) thread, do not wait the default 30s for an unreachable server,
+	// unless the uri sets its own timeout (inserts to a lost server fail as fast)
+	if (mongoc_uri_get_option_as_int32(MongoUri, MONGOC_URI_SERVERSELECTIONTIMEOUTMS, 0) == 0)
+	{
+		mongoc_uri_set_option_as_int32(MongoUri, MONGOC_URI_SERVERSELECTIONTIMEOUTMS, ServerSelectionTimeoutMs);
+	}
+	Client = mongoc_client_new_from_uri(MongoUri);
+	mongoc_uri_destroy(MongoUri);
+	if (!Client)
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Could not create the mongo client for %s"), TEXT(__FUNCTION__), __LINE__, *Uri);
+		return false;
+	}
+	mongoc_client_set_appname(Client, "SemLogRawData");
+
+	// Fail early if the server cannot be reached
+	bson_t* Ping = BCON_NEW("ping", BCON_INT32(1));
+	bson_error_t Error;
+	const bool bConnected = mongoc_client_command_simple(Client, "admin", Ping, nullptr, nullptr, &Error);
+	bson_destroy(Ping);
+	if (!bConnected)
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Could not connect to %s: %s"),
+			TEXT(__FUNCTION__), __LINE__, *Uri, UTF8_TO_TCHAR(Error.message));
+		mongoc_client_destroy(Client);
+		Client = nullptr;
+		return false;
+	}
+
+	DatabaseName = Database;
+	CollectionName = InCollection;
+	Collection = mongoc_client_get_collection(Client, TCHAR_TO_UTF8(*DatabaseName), TCHAR_TO_UTF8(*CollectionName));
+	BatchSize = FMath::Max(InBatchSize, 1);
+	FlushInterval = FMath::Max(InFlushInterval, 0.f);
+	return true;
+#else
+	UE_LOG(LogTemp, Error, TEXT(" %s::%d Built without mongo support (WITH_MONGO)"), TEXT(__FUNCTION__), __LINE__);
+	return false;
+#endif //WITH_MONGO
+}
+
+// Create the indexes before the first frame
+void FSLRawDataMongoSink::OnStart()
+{
+#ifdef WITH_MONGO
+	if (Client)
+	{
+		FSLRawDataMongoSink::CreateIndexes();
+	}
+#endif //WITH_MONGO
+}
+
+// Encode the frames and add them to the bulk insert, send it when full
+void FSLRawDataMongoSink::Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+#ifdef WITH_MONGO
+	if (!Collection)
+	{
+		return;
+	}
+
+	for (const FSLRawDataFrameRef& Frame : Frames)
+	{
+		if (!BsonWriter.WriteFrame(*Frame, Entities))
+		{
+			continue;
+		}
+
+		if (!Bulk)
+		{
+			// Unordered, the server can apply the inserts in parallel
+			bson_t* Opts = BCON_NEW("ordered", BCON_BOOL(false));
+			Bulk = mongoc_collection_create_bulk_operation_with_opts(Collection, Opts);
+			bson_destroy(Opts);
+			BulkStartTime = FPlatformTime::Seconds();
+		}
+		mongoc_bulk_operation_insert(Bulk, BsonWriter.GetDocument());
+		if (++NumInBulk >= BatchSize)
+		{
+			FSLRawDataMongoSink::SendBulk();
+		}
+	}
+
+	// Frames trickling in below the batch size are sent on time as well
+	FSLRawDataMongoSink::OnIdle();
+#endif //WITH_MONGO
+}
+
+// Send the partial bulk insert once it waited long enough
+void FSLRawDataMongoSink::OnIdle()
+{
+#ifdef WITH_MONGO
+	if (Bulk && FPlatformTime::Seconds() - BulkStartTime >= FlushInterval)
+	{
+		FSLRawDataMongoSink::SendBulk();
+	}
+#endif //WITH_MONGO
+}
+
+// Send the remaining documents and close the connection
+void FSLRawDataMongoSink::OnFinish()
+{
+#ifdef WITH_MONGO
+	FSLRawDataMongoSink::SendBulk();
+	FSLRawDataMongoSink::Disconnect();
+
+	// Failed inserts leave holes, merged frames only miss the intermediate poses
+	if (GetNumDropped() > 0 || GetNumMerged() > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT(" %s::%d %s: %d frames not inserted, %d frames merged while the server was busy"),
+			TEXT(__FUNCTION__), __LINE__, *CollectionName, GetNumDropped(), GetNumMerged());
+	}
+#endif //WITH_MONGO
+}
+
+#ifdef WITH_MONGO
+// Create the timestamp and actor name indexes
+void FSLRawDataMongoSink::CreateIndexes()
+{
+	mongoc_database_t* Database = mongoc_client_get_database(Client, TCHAR_TO_UTF8(*DatabaseName));
+	bson_t* Command = BCON_NEW("createIndexes", BCON_UTF8(TCHAR_TO_UTF8(*CollectionName)),
+		"indexes", "[",
+			"{", "key", "{", "timestamp", BCON_INT32(1), "}", "name", BCON_UTF8("timestamp"), "}",
+			"{", "key", "{", "actors.name", BCON_INT32(1), "}", "name", BCON_UTF8("actors.name"), "}",
+		"]");
+
+	bson_error_t Error;
+	if (!mongoc_database_write_command_with_opts(Database, Command, nullptr, nullptr, &Error))
+	{
+		UE_LOG(LogTemp, Warning, TEXT(" %s::%d Could not create the indexes: %s"),
+			TEXT(__FUNCTION__), __LINE__, UTF8_TO_TCHAR(Error.message));
+	}
+	bson_destroy(Command);
+	mongoc_database_destroy(Database);
+}
+
+// Send the documents added since the last bulk insert
+void FSLRawDataMongoSink::SendBulk()
+{
+	if (!Bulk)
+	{
+		return;
+	}
+
+	bson_t Reply;
+	bson_error_t Error;
+	if (!mongoc_bulk_operation_execute(Bulk, &Reply, &Error))
+	{
+		// Unordered, the failed documents are counted from the reply
+		bson_iter_t Iter;
+		const int32 NumInserted = bson_iter_init_find(&Iter, &Reply, "nInserted") ? (int32)bson_iter_as_int64(&Iter) : 0;
+		FSLRawDataSink::AddDropped(NumInBulk - NumInserted);
+		UE_LOG(LogTemp, Warning, TEXT(" %s::%d Bulk insert failed (%d/%d inserted): %s"),
+			TEXT(__FUNCTION__), __LINE__, NumInserted, NumInBulk, UTF8_TO_TCHAR(Error.message));
+	}
+	bson_destroy(&Reply);
+	mongoc_bulk_operation_destroy(Bulk);
+	Bulk = nullptr;
+	NumInBulk = 0;
+}
+
+// Close the connection
+void FSLRawDataMongoSink::Disconnect()
+{
+	if (Bulk)
+	{
+		mongoc_bulk_operation_destroy(Bulk);
+		Bulk = nullptr;
+		NumInBulk = 0;
+	}
+	if (Collection)
+	{
+		mongoc_collection_destroy(Collection);
+		Collection = nullptr;
+	}
+	if (Client)
+	{
+		mongoc_client_destroy(Client);
+		Client = nullptr;
+	}
+}
+#endif //WITH_MONGO
@@ -0,0 +1,89 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataMotion.h"
+#include "Math/VectorRegister.h"
+
+// Set the bit of every entity which moved more than its distance threshold
+void FSLRawDataMotion::ComputeMovedMask(const FVector* CurrLocations, const FVector* PrevLocations,
+	const float* SquaredDistanceThresholds, int32 Num, TArray<uint32>& OutMovedMask)
+{
+	OutMovedMask.Reset();
+	OutMovedMask.AddZeroed((Num + 31) / 32);
+	uint32* MaskWords = OutMovedMask.GetData();
+
+	// Four entities are twelve consecutive floats, read as three registers
+	const int32 NumBatched = Num & ~3;
+	for (int32 Idx = 0; Idx < NumBatched; Idx += 4)
+	{
+		const float* Curr = &CurrLocations[Idx].X;
+		const float* Prev = &PrevLocations[Idx].X;
+
+		// Squared differences: A = x0 y0 z0 x1, B = y1 z1 x2 y2, C = z2 x3 y3 z3
+		VectorRegister A = VectorSubtract(VectorLoad(Curr), VectorLoad(Prev));
+		VectorRegister B = VectorSubtract(VectorLoad(Curr + 4), VectorLoad(Prev + 4));
+		VectorRegister C = VectorSubtract(VectorLoad(Curr + 8), VectorLoad(Prev + 8));
+		A = VectorMultiply(A, A);
+		B = VectorMultiply(B, B);
+		C = VectorMultiply(C, C);
+
+		// Transpose into one register per axis
+		const VectorRegister X = VectorShuffle(VectorShuffle(A, A, 0, 0, 3, 3), VectorShuffle(B, C, 2, 2, 1, 1), 0, 2, 0, 2);
+		const VectorRegister Y = VectorShuffle(VectorShuffle(A, B, 1, 1, 0, 0), VectorShuffle(B, C, 3, 3, 2, 2), 0, 2, 0, 2);
+		const VectorRegister Z = VectorShuffle(VectorShuffle(A, B, 2, 2, 1, 1), VectorShuffle(C, C, 0, 0, 3, 3), 0, 2, 0, 2);
+
+		// Squared distances of the four entities against their thresholds
+		const VectorRegister DistSquared = VectorAdd(VectorAdd(X, Y), Z);
+		const VectorRegister Thresholds = VectorLoad(SquaredDistanceThresholds + Idx);
+		const uint32 Moved = (uint32)VectorMaskBits(VectorCompareGT(DistSquared, Thresholds));
+
+		// Batches of four never straddle a word
+		MaskWords[Idx >> 5] |= Moved << (Idx & 31);
+	}
+
+	// Remaining entities
+	for (int32 Idx = NumBatched; Idx < Num; ++Idx)
+	{
+		if (FVector::DistSquared(CurrLocations[Idx], PrevLocations[Idx]) > SquaredDistanceThresholds[Idx])
+		{
+			MaskWords[Idx >> 5] |= 1u << (Idx & 31);
+		}
+	}
+}
+
+// Additionally set the bit of every entity which rotated more than its angular threshold
+void FSLRawDataMotion::AddRotatedToMask(const FQuat* CurrRotations, const FQuat* PrevRotations,
+	const float* MinQuatDots, int32 Num, TArray<uint32>& InOutMovedMask)
+{
+	uint32* MaskWords = InOutMovedMask.GetData();
+
+	const int32 NumBatched = Num & ~3;
+	for (int32 Idx = 0; Idx < NumBatched; Idx += 4)
+	{
+		// Component products of the four quaternion pairs
+		const VectorRegister M0 = VectorMultiply(VectorLoad(&CurrRotations[Idx]), VectorLoad(&PrevRotations[Idx]));
+		const VectorRegister M1 = VectorMultiply(VectorLoad(&CurrRotations[Idx + 1]), VectorLoad(&PrevRotations[Idx + 1]));
+		const VectorRegister M2 = VectorMultiply(VectorLoad(&CurrRotations[Idx + 2]), VectorLoad(&PrevRotations[Idx + 2]));
+		const VectorRegister M3 = VectorMultiply(VectorLoad(&CurrRotations[Idx + 3]), VectorLoad(&PrevRotations[Idx + 3]));
+
+		// Horizontal sums: one dot product per lane
+		const VectorRegister S01 = VectorAdd(VectorShuffle(M0, M1, 0, 1, 0, 1), VectorShuffle(M0, M1, 2, 3, 2, 3));
+		const VectorRegister S23 = VectorAdd(VectorShuffle(M2, M3, 0, 1, 0, 1), VectorShuffle(M2, M3, 2, 3, 2, 3));
+		const VectorRegister Dots = VectorAdd(VectorShuffle(S01, S23, 0, 2, 0, 2), VectorShuffle(S01, S23, 1, 3, 1, 3));
+
+		// q and -q are the same rotation
+		const VectorRegister MinDots = VectorLoad(MinQuatDots + Idx);
+		const uint32 Rotated = (uint32)VectorMaskBits(VectorCompareGT(MinDots, VectorAbs(Dots)));
+
+		MaskWords[Idx >> 5] |= Rotated << (Idx & 31);
+	}
+
+	// Remaining entities
+	for (int32 Idx = NumBatched; Idx < Num; ++Idx)
+	{
+		if (FMath::Abs(CurrRotations[Idx] | PrevRotations[Idx]) < MinQuatDots[Idx])
+		{
+			MaskWords[Idx >> 5] |= 1u << (Idx & 31);
+		}
+	}
+}
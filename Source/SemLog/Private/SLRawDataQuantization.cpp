@@ -0,0 +1,121 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataQuantization.h"
+
+// The smallest three components are within +-1/sqrt(2)
+static const float SmallestThreeRange = 0.70710678f;
+static const uint32 ComponentMask = (1u << 15) - 1;
+
+// Pack the rotation into its smallest three components
+uint64 FSLRawDataQuantization::PackQuat(const FQuat& Rotation)
+{
+	const FQuat Normalized = Rotation.GetNormalized();
+	const float Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+
+	// The largest component is left out and restored from the unit length
+	int32 Largest = 0;
+	for (int32 Idx = 1; Idx < 4; ++Idx)
+	{
+		if (FMath::Abs(Components[Idx]) > FMath::Abs(Components[Largest]))
+		{
+			Largest = Idx;
+		}
+	}
+
+	// q and -q are the same rotation, keep the largest component positive
+	const float Sign = Components[Largest] < 0.f ? -1.f : 1.f;
+
+	uint64 Packed = (uint64)Largest;
+	int32 Shift = 2;
+	for (int32 Idx = 0; Idx < 4; ++Idx)
+	{
+		if (Idx != Largest)
+		{
+			const float Normal = (Components[Idx] * Sign / SmallestThreeRange) * 0.5f + 0.5f;
+			const uint32 Quantized = (uint32)FMath::Clamp(FMath::RoundToInt(Normal * ComponentMask), 0, (int32)ComponentMask);
+			Packed |= (uint64)Quantized << Shift;
+			Shift += 15;
+		}
+	}
+	return Packed;
+}
+
+// Unpack a rotation packed with PackQuat
+FQuat FSLRawDataQuantization::UnpackQuat(uint64 Packed)
+{
+	const int32 Largest = (int32)(Packed & 3);
+	float Components[4];
+	float SumSquares = 0.f;
+	int32 Shift = 2;
+	for (int32 Idx = 0; Idx < 4; ++Idx)
+	{
+		if (Idx != Largest)
+		{
+			const float Normal = (float)((Packed >> Shift) & ComponentMask) / ComponentMask;
+			Components[Idx] = (Normal * 2.f - 1.f) * SmallestThreeRange;
+			SumSquares += Components[Idx] * Components[Idx];
+			Shift += 15;
+		}
+	}
+	Components[Largest] = FMath::Sqrt(FMath::Max(1.f - SumSquares, 0.f));
+	return FQuat(Components[0], Components[1], Components[2], Components[3]);
+}
+
+// Write the packed rotation as little endian bytes
+void FSLRawDataQuantization::SerializePackedQuat(FArchive& Ar, uint64& Packed)
+{
+	uint8 Bytes[PackedQuatSize];
+	if (Ar.IsSaving())
+	{
+		for (int32 Idx = 0; Idx < PackedQuatSize; ++Idx)
+		{
+			Bytes[Idx] = (uint8)(Packed >> (8 * Idx));
+		}
+	}
+	Ar.Serialize(Bytes, PackedQuatSize);
+	if (Ar.IsLoading())
+	{
+		Packed = 0;
+		for (int32 Idx = 0; Idx < PackedQuatSize; ++Idx)
+		{
+			Packed |= (uint64)Bytes[Idx] << (8 * Idx);
+		}
+	}
+}
+
+// Quantize the four rotation components, the sign is chosen to be closest to the previous ones
+void FSLRawDataQuantization::QuantizeQuatComponents(const FQuat& Rotation, const int32 Previous[4], int32 OutComponents[4])
+{
+	const FQuat Normalized = Rotation.GetNormalized();
+	const float Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+
+	// q and -q are the same rotation, the one closer to the previous gives smaller deltas
+	// (without a previous rotation w is kept positive)
+	int64 Dot = 0;
+	for (int32 Idx = 0; Idx < 4; ++Idx)
+	{
+		Dot += (int64)FMath::RoundToInt(Components[Idx] * QuatComponentScale) * Previous[Idx];
+	}
+	const bool bHasPrevious = Previous[0] != 0 || Previous[1] != 0 || Previous[2] != 0 || Previous[3] != 0;
+	const float Sign = (bHasPrevious ? Dot < 0 : Normalized.W < 0.f) ? -1.f : 1.f;
+
+	for (int32 Idx = 0; Idx < 4; ++Idx)
+	{
+		OutComponents[Idx] = FMath::RoundToInt(Components[Idx] * Sign * QuatComponentScale);
+	}
+}
+
+// Restore the rotation from its quantized components
+FQuat FSLRawDataQuantization::DequantizeQuatComponents(const int32 Components[4])
+{
+	const float InvScale = 1.f / QuatComponentScale;
+	return FQuat(Components[0] * InvScale, Components[1] * InvScale,
+		Components[2] * InvScale, Components[3] * InvScale).GetNormalized();
+}
+
+// Number of decimals needed to print positions in meters with the precision
+int32 FSLRawDataQuantization::GetMeterDecimals(float Precision)
+{
+	return FMath::Clamp(FMath::CeilToInt(-FMath::LogX(10.f, Precision * 0.01f) - KINDA_SMALL_NUMBER), 0, 9);
+}
@@ -0,0 +1,208 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataReplayPrefetcher.h"
+#include "HAL/RunnableThread.h"
+
+// Constructor
+FSLRawDataReplayPrefetcher::FSLRawDataReplayPrefetcher()
+	: SpareFrame(nullptr), NumQueued(0), MaxQueuedFrames(0), Window(0.0), ConsumerTime(0.0), Generation(0),
+	bSeekPending(false), SeekTime(0.0), bEndReached(false), NextFrameIndex(0),
+	StartTime(0.0), EndTime(0.0), WakeEvent(nullptr), Thread(nullptr), bStopping(false)
+{
+}
+
+// Destructor, stops the thread
+FSLRawDataReplayPrefetcher::~FSLRawDataReplayPrefetcher()
+{
+	FSLRawDataReplayPrefetcher::Finish();
+}
+
+// Open the episode and start the thread
+bool FSLRawDataReplayPrefetcher::Start(const FString& Path, double InWindow, int32 InMaxQueuedFrames)
+{
+	if (Thread || !Reader.Open(Path) || Reader.NumFrames() == 0)
+	{
+		Reader.Close();
+		return false;
+	}
+
+	Window = FMath::Max(InWindow, 0.0);
+	MaxQueuedFrames = FMath::Max(InMaxQueuedFrames, 2);
+	StartTime = Reader.GetIndex()[0].Timestamp;
+	EndTime = Reader.GetIndex().Last().Timestamp;
+	ConsumerTime.store(StartTime);
+	NextFrameIndex = Reader.NumFrames();
+	bEndReached.store(false);
+	bStopping.store(false);
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("SLRawDataReplayPrefetcher"), 0, TPri_BelowNormal);
+	return Thread != nullptr;
+}
+
+// Stop the thread and close the episode
+void FSLRawDataReplayPrefetcher::Finish()
+{
+	if (Thread)
+	{
+		bStopping.store(true);
+		WakeEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+
+	FSLRawDataReplayFrame* Frame = nullptr;
+	while (ReadFrames.Dequeue(Frame)) {}
+	while (FreeFrames.Dequeue(Frame)) {}
+	for (const auto& FrameItr : AllFrames)
+	{
+		delete FrameItr;
+	}
+	AllFrames.Empty();
+	SpareFrame = nullptr;
+	NumQueued.store(0);
+	SentBoneCounts.Empty();
+	Reader.Close();
+}
+
+// Restart reading at the time
+int32 FSLRawDataReplayPrefetcher::Seek(double Time)
+{
+	int32 NewGeneration;
+	{
+		FScopeLock Lock(&SeekLock);
+		SeekTime = Time;
+		NewGeneration = ++Generation;
+		bSeekPending.store(true);
+	}
+	ConsumerTime.store(Time);
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+	return NewGeneration;
+}
+
+// Set the replay time
+void FSLRawDataReplayPrefetcher::SetConsumerTime(double Time)
+{
+	ConsumerTime.store(Time);
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+// Get the oldest read frame without removing it
+bool FSLRawDataReplayPrefetcher::Peek(FSLRawDataReplayFrame*& OutFrame)
+{
+	return ReadFrames.Peek(OutFrame);
+}
+
+// Remove the oldest read frame and give it back for reuse
+void FSLRawDataReplayPrefetcher::Pop()
+{
+	FSLRawDataReplayFrame* Frame = nullptr;
+	if (ReadFrames.Dequeue(Frame))
+	{
+		NumQueued--;
+		FreeFrames.Enqueue(Frame);
+	}
+}
+
+// Read the frames ahead of the replay time
+uint32 FSLRawDataReplayPrefetcher::Run()
+{
+	const TArray<FSLRawDataFrameIndexEntry>& Index = Reader.GetIndex();
+	int32 CurrGeneration = Generation.load();
+	while (!bStopping.load())
+	{
+		if (bSeekPending.load())
+		{
+			double Time;
+			{
+				FScopeLock Lock(&SeekLock);
+				Time = SeekTime;
+				CurrGeneration = Generation.load();
+				bSeekPending.store(false);
+			}
+			// Restart at the keyframe, the replay needs every pose up to the seek time
+			const int32 FrameIndex = Reader.FindFrame(Time);
+			NextFrameIndex = FrameIndex == INDEX_NONE ? 0 : Index[FrameIndex].KeyframeIndex;
+			bEndReached.store(false);
+		}
+
+		if (NextFrameIndex >= Index.Num())
+		{
+			bEndReached.store(true);
+			WakeEvent->Wait(10);
+			continue;
+		}
+
+		// Stay within the window, and always keep at least one frame ahead for interpolation
+		if (NumQueued.load() >= MaxQueuedFrames ||
+			(NumQueued.load() > 0 && Index[NextFrameIndex].Timestamp > ConsumerTime.load() + Window))
+		{
+			WakeEvent->Wait(10);
+			continue;
+		}
+
+		FSLRawDataReplayFrame* Frame = SpareFrame;
+		SpareFrame = nullptr;
+		if (!Frame && !FreeFrames.Dequeue(Frame))
+		{
+			Frame = new FSLRawDataReplayFrame();
+			AllFrames.Add(Frame);
+		}
+
+		Frame->Generation = CurrGeneration;
+		if (!Reader.ReadFrame(NextFrameIndex, Frame->Frame))
+		{
+			// Corrupted frame, skip it
+			UE_LOG(LogTemp, Warning, TEXT(" %s::%d Could not read frame %d"), TEXT(__FUNCTION__), __LINE__, NextFrameIndex);
+			SpareFrame = Frame;
+			NextFrameIndex++;
+			continue;
+		}
+		FSLRawDataReplayPrefetcher::AddUnsentEntities(Frame->Frame);
+
+		ReadFrames.Enqueue(Frame);
+		NumQueued++;
+		NextFrameIndex++;
+	}
+	return 0;
+}
+
+// Stop the thread
+void FSLRawDataReplayPrefetcher::Stop()
+{
+	bStopping.store(true);
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+// Copy the entities, or bones, the replay does not know yet into the frame
+void FSLRawDataReplayPrefetcher::AddUnsentEntities(FSLRawDataFrame& Frame)
+{
+	// The entities of the index, sent again if they get new bones
+	const TArray<FSLRawDataEntityDesc>& Entities = Reader.GetEntities();
+	for (int32 EntityIndex = SentBoneCounts.Num(); EntityIndex < Entities.Num(); ++EntityIndex)
+	{
+		SentBoneCounts.Add(INDEX_NONE);
+	}
+	for (int32 EntityIndex = 0; EntityIndex < Entities.Num(); ++EntityIndex)
+	{
+		if (SentBoneCounts[EntityIndex] != Entities[EntityIndex].BoneNames.Num())
+		{
+			Frame.NewEntities.Add(Entities[EntityIndex]);
+			SentBoneCounts[EntityIndex] = Entities[EntityIndex].BoneNames.Num();
+		}
+	}
+}
@@ -0,0 +1,346 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataReplayer.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "EngineUtils.h"
+#include "TagStatics.h"
+
+// Sets default values
+ASLRawDataReplayer::ASLRawDataReplayer()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Defaults
+	bAutoPlay = true;
+	bLoop = false;
+	PlaybackSpeed = 1.f;
+	bInterpolate = true;
+	MaxInterpolationGap = 0.25f;
+	PrefetchWindow = 2.f;
+	MaxPrefetchedFrames = 1024;
+	bDisablePhysics = true;
+	CurrTime = 0.0;
+	Generation = 0;
+	bIsPlaying = false;
+	bIsInit = false;
+}
+
+// Called when the game starts or when spawned
+void ASLRawDataReplayer::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!EpisodePath.IsEmpty() && ASLRawDataReplayer::Init(EpisodePath) && bAutoPlay)
+	{
+		ASLRawDataReplayer::Play();
+	}
+}
+
+// Called when actor removed from game or game ended
+void ASLRawDataReplayer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+	Prefetcher.Finish();
+	bIsPlaying = false;
+	bIsInit = false;
+}
+
+// Called every frame
+void ASLRawDataReplayer::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsInit)
+	{
+		return;
+	}
+
+	if (bIsPlaying)
+	{
+		CurrTime += DeltaTime * PlaybackSpeed;
+		Prefetcher.SetConsumerTime(CurrTime);
+	}
+
+	// Store the poses of every frame up to the replay time
+	FSLRawDataReplayFrame* Frame = nullptr;
+	const FSLRawDataFrame* NextFrame = nullptr;
+	while (Prefetcher.Peek(Frame))
+	{
+		// Entities are sent once, also with frames skipped after a seek
+		if (Frame->Frame.NewEntities.Num() > 0)
+		{
+			ASLRawDataReplayer::AddEntities(Frame->Frame.NewEntities);
+			Frame->Frame.NewEntities.Reset();
+		}
+
+		if (Frame->Generation != Generation)
+		{
+			Prefetcher.Pop();
+			continue;
+		}
+
+		if (Frame->Frame.Timestamp > CurrTime)
+		{
+			NextFrame = &Frame->Frame;
+			break;
+		}
+
+		ASLRawDataReplayer::StoreFramePoses(Frame->Frame);
+		Prefetcher.Pop();
+	}
+
+	ASLRawDataReplayer::ApplyPoses(bInterpolate ? NextFrame : nullptr);
+
+	// End of the episode
+	if (bIsPlaying && !NextFrame && CurrTime >= Prefetcher.GetEndTime() && Prefetcher.IsEndReached(Generation))
+	{
+		if (bLoop)
+		{
+			ASLRawDataReplayer::Seek((float)Prefetcher.GetStartTime());
+		}
+		else
+		{
+			ASLRawDataReplayer::Pause();
+		}
+	}
+}
+
+// Open the episode and bind the entities
+bool ASLRawDataReplayer::Init(const FString& InEpisodePath)
+{
+	if (bIsInit)
+	{
+		return true;
+	}
+
+	if (!Prefetcher.Start(InEpisodePath, PrefetchWindow, MaxPrefetchedFrames))
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Could not open episode %s"), TEXT(__FUNCTION__), __LINE__, *InEpisodePath);
+		return false;
+	}
+
+	ASLRawDataReplayer::GatherTaggedComponents();
+	bIsInit = true;
+
+	// Read from the first frame, static entities are only there
+	ASLRawDataReplayer::Seek((float)Prefetcher.GetStartTime());
+	return true;
+}
+
+// Start or resume the replay
+void ASLRawDataReplayer::Play()
+{
+	bIsPlaying = bIsInit;
+}
+
+// Pause the replay
+void ASLRawDataReplayer::Pause()
+{
+	bIsPlaying = false;
+}
+
+// Jump to the episode time
+void ASLRawDataReplayer::Seek(float Time)
+{
+	if (!bIsInit)
+	{
+		return;
+	}
+
+	CurrTime = FMath::Clamp((double)Time, Prefetcher.GetStartTime(), Prefetcher.GetEndTime());
+	Generation = Prefetcher.Seek(CurrTime);
+
+	// The poses are read again from the keyframe before the time
+	for (auto& EntityItr : Entities)
+	{
+		EntityItr.Root.Time = -1.0;
+		for (auto& BoneItr : EntityItr.Bones)
+		{
+			BoneItr.Time = -1.0;
+		}
+	}
+}
+
+// Map the unique names of the tagged actors and components of the level
+void ASLRawDataReplayer::GatherTaggedComponents()
+{
+	TaggedComponents.Empty();
+	for (TActorIterator<AActor> ActItr(GetWorld()); ActItr; ++ActItr)
+	{
+		int32 TagIndex = FTagStatics::GetTagTypeIndex(*ActItr, "SemLog");
+		if (TagIndex != INDEX_NONE && ActItr->GetRootComponent())
+		{
+			const FString Id = FTagStatics::GetKeyValue(ActItr->Tags[TagIndex], "Id");
+			const FString Class = FTagStatics::GetKeyValue(ActItr->Tags[TagIndex], "Class");
+			if (!Id.IsEmpty() && !Class.IsEmpty())
+			{
+				TaggedComponents.Add(Class + "_" + Id, ActItr->GetRootComponent());
+			}
+		}
+
+		TArray<USceneComponent*> SceneComponents;
+		ActItr->GetComponents<USceneComponent>(SceneComponents);
+		for (const auto& CompItr : SceneComponents)
+		{
+			TagIndex = FTagStatics::GetTagTypeIndex(CompItr, "SemLog");
+			if (TagIndex != INDEX_NONE)
+			{
+				const FString Id = FTagStatics::GetKeyValue(CompItr->ComponentTags[TagIndex], "Id");
+				const FString Class = FTagStatics::GetKeyValue(CompItr->ComponentTags[TagIndex], "Class");
+				if (!Id.IsEmpty() && !Class.IsEmpty())
+				{
+					TaggedComponents.Add(Class + "_" + Id, CompItr);
+				}
+			}
+		}
+	}
+}
+
+// Bind the entities sent with the frame
+void ASLRawDataReplayer::AddEntities(const TArray<FSLRawDataEntityDesc>& NewEntities)
+{
+	for (const auto& EntityDescItr : NewEntities)
+	{
+		if (Entities.Num() <= EntityDescItr.EntityIndex)
+		{
+			Entities.SetNum(EntityDescItr.EntityIndex + 1);
+		}
+		FReplayEntity& Entity = Entities[EntityDescItr.EntityIndex];
+
+		// Bones can be sent again once more of them are known
+		Entity.BoneNames.Reset(EntityDescItr.BoneNames.Num());
+		for (const auto& BoneNameItr : EntityDescItr.BoneNames)
+		{
+			Entity.BoneNames.Add(FName(*BoneNameItr));
+		}
+		Entity.Bones.SetNum(Entity.BoneNames.Num());
+
+		if (Entity.Component.IsValid())
+		{
+			continue;
+		}
+		const TWeakObjectPtr<USceneComponent>* Component = TaggedComponents.Find(EntityDescItr.UniqueName);
+		if (!Component || !Component->IsValid())
+		{
+			UE_LOG(LogTemp, Warning, TEXT(" %s::%d No tagged actor or component for %s, it will not be replayed"),
+				TEXT(__FUNCTION__), __LINE__, *EntityDescItr.UniqueName);
+			continue;
+		}
+		Entity.Component = *Component;
+
+		// Skeletal meshes cannot be posed directly, the bones go to a poseable mesh of the owner
+		UPoseableMeshComponent* PoseableMesh = Cast<UPoseableMeshComponent>(Component->Get());
+		if (!PoseableMesh && (*Component)->GetOwner())
+		{
+			PoseableMesh = (*Component)->GetOwner()->FindComponentByClass<UPoseableMeshComponent>();
+		}
+		Entity.PoseableMesh = PoseableMesh;
+
+		if (bDisablePhysics)
+		{
+			if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component->Get()))
+			{
+				Primitive->SetSimulatePhysics(false);
+			}
+		}
+	}
+}
+
+// Store the poses of the frame as the last ones
+void ASLRawDataReplayer::StoreFramePoses(const FSLRawDataFrame& Frame)
+{
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		if (!Entities.IsValidIndex(PoseItr.EntityIndex))
+		{
+			continue;
+		}
+		FReplayEntity& Entity = Entities[PoseItr.EntityIndex];
+		FReplaySample* Sample = PoseItr.BoneIndex == INDEX_NONE ? &Entity.Root
+			: (Entity.Bones.IsValidIndex(PoseItr.BoneIndex) ? &Entity.Bones[PoseItr.BoneIndex] : nullptr);
+		if (!Sample)
+		{
+			continue;
+		}
+		Sample->Time = Frame.Timestamp;
+		Sample->Location = PoseItr.Location;
+		Sample->Rotation = PoseItr.Rotation;
+
+		if (!Entity.bIsDirty)
+		{
+			Entity.bIsDirty = true;
+			DirtyEntities.Add(PoseItr.EntityIndex);
+		}
+	}
+}
+
+// Apply the last poses, and interpolate towards the next frame
+void ASLRawDataReplayer::ApplyPoses(const FSLRawDataFrame* NextFrame)
+{
+	for (const int32 EntityIndex : DirtyEntities)
+	{
+		FReplayEntity& Entity = Entities[EntityIndex];
+		if (Entity.Root.Time >= 0.0)
+		{
+			ASLRawDataReplayer::ApplyPose(Entity, INDEX_NONE, Entity.Root.Location, Entity.Root.Rotation);
+		}
+		for (int32 BoneIndex = 0; BoneIndex < Entity.Bones.Num(); ++BoneIndex)
+		{
+			if (Entity.Bones[BoneIndex].Time >= 0.0)
+			{
+				ASLRawDataReplayer::ApplyPose(Entity, BoneIndex, Entity.Bones[BoneIndex].Location, Entity.Bones[BoneIndex].Rotation);
+			}
+		}
+		Entity.bIsDirty = false;
+	}
+	DirtyEntities.Reset();
+
+	if (!NextFrame)
+	{
+		return;
+	}
+
+	// Only the poses written in the next frame move until then
+	for (const auto& PoseItr : NextFrame->Poses)
+	{
+		if (!Entities.IsValidIndex(PoseItr.EntityIndex))
+		{
+			continue;
+		}
+		FReplayEntity& Entity = Entities[PoseItr.EntityIndex];
+		const FReplaySample* Sample = PoseItr.BoneIndex == INDEX_NONE ? &Entity.Root
+			: (Entity.Bones.IsValidIndex(PoseItr.BoneIndex) ? &Entity.Bones[PoseItr.BoneIndex] : nullptr);
+		if (!Sample || Sample->Time < 0.0)
+		{
+			continue;
+		}
+
+		const double Gap = NextFrame->Timestamp - Sample->Time;
+		if (Gap <= 0.0 || Gap > MaxInterpolationGap)
+		{
+			continue;
+		}
+		const float Alpha = FMath::Clamp((float)((CurrTime - Sample->Time) / Gap), 0.f, 1.f);
+		ASLRawDataReplayer::ApplyPose(Entity, PoseItr.BoneIndex,
+			FMath::Lerp(Sample->Location, PoseItr.Location, Alpha),
+			FQuat::Slerp(Sample->Rotation, PoseItr.Rotation, Alpha));
+	}
+}
+
+// Move the entity or bone
+void ASLRawDataReplayer::ApplyPose(FReplayEntity& Entity, int32 BoneIndex, const FVector& Location, const FQuat& Rotation)
+{
+	if (BoneIndex == INDEX_NONE)
+	{
+		if (USceneComponent* Component = Entity.Component.Get())
+		{
+			Component->SetWorldLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		}
+	}
+	else if (UPoseableMeshComponent* PoseableMesh = Entity.PoseableMesh.Get())
+	{
+		PoseableMesh->SetBoneTransformByName(Entity.BoneNames[BoneIndex], FTransform(Rotation, Location), EBoneSpaces::WorldSpace);
+	}
+}
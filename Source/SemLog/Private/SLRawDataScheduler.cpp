@@ -0,0 +1,80 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataScheduler.h"
+
+// Default constructor
+FSLRawDataScheduler::FSLRawDataScheduler() : BucketDuration(1.f / 120.f), NextTick(0), NumEntries(0)
+{
+}
+
+// Set the bucket width and the number of buckets
+void FSLRawDataScheduler::Init(float InBucketDuration, int32 InNumBuckets)
+{
+	BucketDuration = FMath::Max(InBucketDuration, KINDA_SMALL_NUMBER);
+	Buckets.Empty(InNumBuckets);
+	Buckets.SetNum(FMath::Max(InNumBuckets, 1));
+	NextTick = 0;
+	NumEntries = 0;
+}
+
+// Schedule the entity for the given time
+void FSLRawDataScheduler::Schedule(int32 EntityIndex, float DueTime)
+{
+	const int32 NumBuckets = Buckets.Num();
+
+	// Overdue entities go in the next visited bucket, far ones in the last bucket of the horizon
+	const int64 Tick = FMath::Clamp(GetTick(DueTime), NextTick, NextTick + NumBuckets - 1);
+	FEntry Entry;
+	Entry.EntityIndex = EntityIndex;
+	Entry.DueTime = DueTime;
+	Buckets[(int32)(Tick % NumBuckets)].Add(Entry);
+	NumEntries++;
+}
+
+// Move the entities due at the given time to the output
+void FSLRawDataScheduler::PopDue(float Time, TArray<int32>& OutEntityIndices)
+{
+	const int32 NumBuckets = Buckets.Num();
+	const int64 LastTick = GetTick(Time);
+
+	// A full turn visits every bucket, no need to go around more than once
+	const int64 FirstTick = FMath::Max(NextTick, LastTick - NumBuckets + 1);
+	for (int64 Tick = FirstTick; Tick <= LastTick; ++Tick)
+	{
+		TArray<FEntry>& Bucket = Buckets[(int32)(Tick % NumBuckets)];
+		for (const auto& Entry : Bucket)
+		{
+			if (Entry.DueTime <= Time)
+			{
+				OutEntityIndices.Add(Entry.EntityIndex);
+			}
+			else
+			{
+				// Later in the current bucket, or clamped from past the horizon
+				NotDue.Add(Entry);
+			}
+		}
+		NumEntries -= Bucket.Num();
+		Bucket.Reset();
+	}
+	NextTick = FMath::Max(NextTick, LastTick + 1);
+
+	// Put back the visited entries which are not yet due, relative to the new position
+	for (const auto& Entry : NotDue)
+	{
+		FSLRawDataScheduler::Schedule(Entry.EntityIndex, Entry.DueTime);
+	}
+	NotDue.Reset();
+}
+
+// Remove all entries
+void FSLRawDataScheduler::Reset()
+{
+	for (auto& Bucket : Buckets)
+	{
+		Bucket.Reset();
+	}
+	NextTick = 0;
+	NumEntries = 0;
+}
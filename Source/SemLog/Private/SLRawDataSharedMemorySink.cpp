@@ -0,0 +1,261 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataSharedMemorySink.h"
+#include "Misc/DateTime.h"
+
+// Constructor
+FSLRawDataSharedMemorySink::FSLRawDataSharedMemorySink()
+	: Region(nullptr), Header(nullptr), NumFrames(0), bEntityTableFull(false), bPoseTableFull(false)
+{
+}
+
+// Destructor, unmaps the region
+FSLRawDataSharedMemorySink::~FSLRawDataSharedMemorySink()
+{
+	FSLRawDataSink::Finish();
+	FSLRawDataSharedMemorySink::Close();
+}
+
+// Create the named region
+bool FSLRawDataSharedMemorySink::Create(const FString& Name, int32 NumSlots, int32 MaxPosesPerFrame, int32 EntityTableCapacity,
+	int32 PoseTableCapacity)
+{
+	if (IsStarted() || Region)
+	{
+		return false;
+	}
+
+	NumSlots = FMath::Max(NumSlots, 2);
+	MaxPosesPerFrame = FMath::Max(MaxPosesPerFrame, 1);
+	EntityTableCapacity = FMath::Max(EntityTableCapacity, 1024);
+	PoseTableCapacity = FMath::Max(PoseTableCapacity, 1);
+
+	const uint64 SlotSize = FSLRawDataSharedMemory::Align(
+		sizeof(FSLRawDataSharedMemorySlot) + (uint64)MaxPosesPerFrame * sizeof(FSLRawDataSharedMemoryPose));
+	const uint64 EntityTableOffset = FSLRawDataSharedMemory::Align(sizeof(FSLRawDataSharedMemoryHeader));
+	const uint64 PoseTableOffset = EntityTableOffset + FSLRawDataSharedMemory::Align(EntityTableCapacity);
+	const uint64 SlotsOffset = PoseTableOffset + (uint64)PoseTableCapacity * sizeof(FSLRawDataSharedMemoryPoseEntry);
+	const uint64 RegionSize = SlotsOffset + SlotSize * NumSlots;
+
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, true,
+		FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, RegionSize);
+	if (!Region)
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Could not create the shared memory region %s (%llu bytes)"),
+			TEXT(__FUNCTION__), __LINE__, *Name, RegionSize);
+		return false;
+	}
+
+	// The region can be left over from a previous session, readers wait for the magic
+	uint8* Base = (uint8*)Region->GetAddress();
+	Header = (FSLRawDataSharedMemoryHeader*)Base;
+	Header->Magic.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	FMemory::Memzero(Base + sizeof(Header->Magic), RegionSize - sizeof(Header->Magic));
+
+	Header->Version = FSLRawDataSharedMemory::Version;
+	Header->Epoch = (uint64)FDateTime::UtcNow().GetTicks();
+	Header->NumSlots = NumSlots;
+	Header->SlotSize = (uint32)SlotSize;
+	Header->MaxPosesPerFrame = MaxPosesPerFrame;
+	Header->EntityTableOffset = EntityTableOffset;
+	Header->EntityTableCapacity = EntityTableCapacity;
+	Header->SlotsOffset = SlotsOffset;
+	Header->PoseTableOffset = PoseTableOffset;
+	Header->PoseTableCapacity = PoseTableCapacity;
+	Header->bWriterActive.store(1, std::memory_order_relaxed);
+	Header->Magic.store(FSLRawDataSharedMemory::Magic, std::memory_order_release);
+
+	NumFrames = 0;
+	bEntityTableFull = false;
+	bPoseTableFull = false;
+	FirstPoseEntries.Reset();
+	NumEntityPoseEntries.Reset();
+	return true;
+}
+
+// Publish the new entities and the frames
+void FSLRawDataSharedMemorySink::Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	if (!Header)
+	{
+		return;
+	}
+
+	for (const FSLRawDataFrameRef& Frame : Frames)
+	{
+		// Entities are published before the frames using them
+		for (const auto& EntityItr : Frame->NewEntities)
+		{
+			if (!bEntityTableFull && !FSLRawDataSharedMemorySink::PublishEntity(EntityItr))
+			{
+				bEntityTableFull = true;
+				UE_LOG(LogTemp, Error, TEXT(" %s::%d Shared memory entity table full, new entities are not published"),
+					TEXT(__FUNCTION__), __LINE__);
+			}
+		}
+
+		if (Frame->Poses.Num() > 0)
+		{
+			FSLRawDataSharedMemorySink::PublishFrame(*Frame);
+		}
+	}
+}
+
+// Tell the readers no more frames are coming and unmap the region
+void FSLRawDataSharedMemorySink::OnFinish()
+{
+	FSLRawDataSharedMemorySink::Close();
+}
+
+// Append the entity to the table
+bool FSLRawDataSharedMemorySink::PublishEntity(const FSLRawDataEntityDesc& Entity)
+{
+	FTCHARToUTF8 NameConverter(*Entity.UniqueName);
+	uint64 EntrySize = sizeof(int32) + 3 * sizeof(uint32) + NameConverter.Length();
+	for (const FString& BoneName : Entity.BoneNames)
+	{
+		EntrySize += sizeof(uint32) + FTCHARToUTF8(*BoneName).Length();
+	}
+
+	uint64 Offset = Header->EntityTableSize.load(std::memory_order_relaxed);
+	if (Offset + EntrySize > Header->EntityTableCapacity)
+	{
+		return false;
+	}
+
+	// The entity pose entry is followed by the bone entries, the entity keeps no entries if they do not fit
+	const uint32 NumPoseEntries = Header->NumPoseEntries.load(std::memory_order_relaxed);
+	const uint32 NumNewPoseEntries = Entity.BoneNames.Num() + 1;
+	const bool bHasPoseEntries = NumPoseEntries + (uint64)NumNewPoseEntries <= Header->PoseTableCapacity;
+	const uint32 FirstPoseEntry = bHasPoseEntries ? NumPoseEntries : FSLRawDataSharedMemory::NoPoseEntry;
+	if (!bHasPoseEntries && !bPoseTableFull)
+	{
+		bPoseTableFull = true;
+		UE_LOG(LogTemp, Warning, TEXT(" %s::%d Shared memory pose table full, %s has no latest poses"),
+			TEXT(__FUNCTION__), __LINE__, *Entity.UniqueName);
+	}
+
+	// Only the writer appends, the bytes are published with the new size
+	const int32 EntityIndex = Entity.EntityIndex;
+	const uint32 NameSize = NameConverter.Length();
+	const uint32 NumBones = Entity.BoneNames.Num();
+	FSLRawDataSharedMemorySink::AppendToEntityTable(&EntityIndex, sizeof(EntityIndex), Offset);
+	FSLRawDataSharedMemorySink::AppendToEntityTable(&FirstPoseEntry, sizeof(FirstPoseEntry), Offset);
+	FSLRawDataSharedMemorySink::AppendToEntityTable(&NameSize, sizeof(NameSize), Offset);
+	FSLRawDataSharedMemorySink::AppendToEntityTable(NameConverter.Get(), NameSize, Offset);
+	FSLRawDataSharedMemorySink::AppendToEntityTable(&NumBones, sizeof(NumBones), Offset);
+	for (const FString& BoneName : Entity.BoneNames)
+	{
+		FTCHARToUTF8 BoneNameConverter(*BoneName);
+		const uint32 BoneNameSize = BoneNameConverter.Length();
+		FSLRawDataSharedMemorySink::AppendToEntityTable(&BoneNameSize, sizeof(BoneNameSize), Offset);
+		FSLRawDataSharedMemorySink::AppendToEntityTable(BoneNameConverter.Get(), BoneNameSize, Offset);
+	}
+
+	while (FirstPoseEntries.Num() <= EntityIndex)
+	{
+		FirstPoseEntries.Add(FSLRawDataSharedMemory::NoPoseEntry);
+		NumEntityPoseEntries.Add(0);
+	}
+	FirstPoseEntries[EntityIndex] = FirstPoseEntry;
+	NumEntityPoseEntries[EntityIndex] = bHasPoseEntries ? NumNewPoseEntries : 0;
+	if (bHasPoseEntries)
+	{
+		Header->NumPoseEntries.store(NumPoseEntries + NumNewPoseEntries, std::memory_order_release);
+	}
+
+	Header->EntityTableSize.store(Offset, std::memory_order_release);
+	Header->NumEntities.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+// Update the latest poses, write the frame into its slot and publish it
+void FSLRawDataSharedMemorySink::PublishFrame(const FSLRawDataFrame& Frame)
+{
+	// A reader seeing the frame in the ring finds the latest poses at least as new, truncated poses included
+	for (const FSLRawDataPose& Pose : Frame.Poses)
+	{
+		FSLRawDataSharedMemorySink::PublishLatestPose(Pose, Frame.Timestamp);
+	}
+
+	uint8* SlotBytes = (uint8*)Region->GetAddress() + Header->SlotsOffset + (NumFrames % Header->NumSlots) * Header->SlotSize;
+	FSLRawDataSharedMemorySlot* Slot = (FSLRawDataSharedMemorySlot*)SlotBytes;
+	FSLRawDataSharedMemoryPose* Poses = (FSLRawDataSharedMemoryPose*)(SlotBytes + sizeof(FSLRawDataSharedMemorySlot));
+
+	// Odd while writing, readers of the previous frame in this slot see the change
+	Slot->Sequence.store(2 * NumFrames + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const int32 NumPoses = FMath::Min(Frame.Poses.Num(), (int32)Header->MaxPosesPerFrame);
+	Slot->Timestamp = Frame.Timestamp;
+	Slot->Flags = (Frame.bIsKeyframe ? FSLRawDataSharedMemory::KeyframeFlag : 0) |
+		(NumPoses < Frame.Poses.Num() ? FSLRawDataSharedMemory::TruncatedFlag : 0);
+	Slot->NumPoses = NumPoses;
+	for (int32 Idx = 0; Idx < NumPoses; ++Idx)
+	{
+		FSLRawDataSharedMemorySink::ToSharedPose(Frame.Poses[Idx], Poses[Idx]);
+	}
+
+	Slot->Sequence.store(FSLRawDataSharedMemory::CompleteSequence(NumFrames), std::memory_order_release);
+	Header->NumFrames.store(++NumFrames, std::memory_order_release);
+}
+
+// Write the pose into the latest pose table under the entry sequence lock
+FORCEINLINE void FSLRawDataSharedMemorySink::PublishLatestPose(const FSLRawDataPose& Pose, double Timestamp)
+{
+	// Entities which did not fit into the table (or into the entity table) have no entries
+	const int32 EntryOffset = Pose.BoneIndex + 1;
+	if (!NumEntityPoseEntries.IsValidIndex(Pose.EntityIndex) || EntryOffset < 0 || EntryOffset >= NumEntityPoseEntries[Pose.EntityIndex])
+	{
+		return;
+	}
+	FSLRawDataSharedMemoryPoseEntry* Entry = (FSLRawDataSharedMemoryPoseEntry*)((uint8*)Region->GetAddress() + Header->PoseTableOffset) +
+		FirstPoseEntries[Pose.EntityIndex] + EntryOffset;
+
+	// Odd while writing, only the writer changes the sequence
+	const uint64 Sequence = Entry->Sequence.load(std::memory_order_relaxed);
+	Entry->Sequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Entry->FrameNumber = NumFrames;
+	Entry->Timestamp = Timestamp;
+	FSLRawDataSharedMemorySink::ToSharedPose(Pose, Entry->Pose);
+
+	Entry->Sequence.store(Sequence + 2, std::memory_order_release);
+}
+
+// Copy the pose into the shared layout
+FORCEINLINE void FSLRawDataSharedMemorySink::ToSharedPose(const FSLRawDataPose& Pose, FSLRawDataSharedMemoryPose& OutPose)
+{
+	OutPose.EntityIndex = Pose.EntityIndex;
+	OutPose.BoneIndex = Pose.BoneIndex;
+	OutPose.Location[0] = Pose.Location.X;
+	OutPose.Location[1] = Pose.Location.Y;
+	OutPose.Location[2] = Pose.Location.Z;
+	OutPose.Rotation[0] = Pose.Rotation.X;
+	OutPose.Rotation[1] = Pose.Rotation.Y;
+	OutPose.Rotation[2] = Pose.Rotation.Z;
+	OutPose.Rotation[3] = Pose.Rotation.W;
+}
+
+// Append the bytes to the entity table
+FORCEINLINE void FSLRawDataSharedMemorySink::AppendToEntityTable(const void* Data, uint64 Size, uint64& InOutOffset)
+{
+	uint8* Table = (uint8*)Region->GetAddress() + Header->EntityTableOffset;
+	FMemory::Memcpy(Table + InOutOffset, Data, Size);
+	InOutOffset += Size;
+}
+
+// Unmap the region
+void FSLRawDataSharedMemorySink::Close()
+{
+	if (Region)
+	{
+		Header->bWriterActive.store(0, std::memory_order_release);
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+		Region = nullptr;
+		Header = nullptr;
+	}
+}
@@ -0,0 +1,304 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataSink.h"
+#include "HAL/RunnableThread.h"
+
+// Constructor
+FSLRawDataSink::FSLRawDataSink()
+	: QueueHead(0), QueueTail(0), bHasOverflow(false), Capacity(256), Policy(ESLRawDataQueuePolicy::Block), NumDropped(0),
+	NumMerged(0), bHasMergedFrame(false), MergedTimestamp(0.f), bMergedKeyframe(false), DataEvent(nullptr), SpaceEvent(nullptr),
+	Thread(nullptr), bStopping(false)
+{
+}
+
+// Destructor, consumes the queued frames
+FSLRawDataSink::~FSLRawDataSink()
+{
+	FSLRawDataSink::Finish();
+}
+
+// Set the queue size and what to do when it is full
+void FSLRawDataSink::SetQueue(int32 InCapacity, ESLRawDataQueuePolicy InPolicy)
+{
+	if (!Thread)
+	{
+		Capacity = FMath::Max(InCapacity, 1);
+		Policy = InPolicy;
+	}
+}
+
+// Start the sink thread
+bool FSLRawDataSink::Start()
+{
+	if (Thread)
+	{
+		return false;
+	}
+
+	Queue.Reset();
+	Queue.SetNum(Capacity);
+	QueueHead.store(0);
+	QueueTail.store(0);
+	Overflow.Empty();
+	bHasOverflow = false;
+	NumDropped.store(0);
+	NumMerged.store(0);
+	bHasMergedFrame = false;
+	bStopping.store(false);
+
+	DataEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	SpaceEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, GetThreadName(), 0, TPri_BelowNormal);
+	return Thread != nullptr;
+}
+
+// Queue the frame
+void FSLRawDataSink::Enqueue(const FSLRawDataFrameRef& Frame)
+{
+	if (!Thread)
+	{
+		return;
+	}
+
+	// The frames waiting for room go first, the new frame waits behind them
+	if (!FSLRawDataSink::TryEnqueuePending() || !FSLRawDataSink::TryEnqueue(Frame))
+	{
+		if (Policy == ESLRawDataQueuePolicy::Merge)
+		{
+			// Never waits, the frames behind a full ring are merged until there is room again
+			FSLRawDataSink::MergeFrame(*Frame);
+		}
+		else if (Policy == ESLRawDataQueuePolicy::Grow)
+		{
+			// Never waits, the frames behind a full ring are kept in order
+			Overflow.Enqueue(Frame);
+			bHasOverflow = true;
+		}
+		else
+		{
+			// Block waits for the sink thread to catch up
+			do
+			{
+				DataEvent->Trigger();
+				SpaceEvent->Wait(1);
+			} while (!FSLRawDataSink::TryEnqueue(Frame));
+		}
+	}
+	DataEvent->Trigger();
+}
+
+// Consume the queued frames, stop the thread and close the output
+void FSLRawDataSink::Finish()
+{
+	if (Thread)
+	{
+		// The merged or grown frames are the newest, they are queued last
+		while (!FSLRawDataSink::TryEnqueuePending())
+		{
+			DataEvent->Trigger();
+			SpaceEvent->Wait(1);
+		}
+
+		// The thread consumes the remaining frames before returning
+		bStopping.store(true);
+		DataEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+
+		FPlatformProcess::ReturnSynchEventToPool(DataEvent);
+		FPlatformProcess::ReturnSynchEventToPool(SpaceEvent);
+		DataEvent = nullptr;
+		SpaceEvent = nullptr;
+		Queue.Empty();
+		Overflow.Empty();
+		bHasOverflow = false;
+	}
+}
+
+// Sink thread loop
+uint32 FSLRawDataSink::Run()
+{
+	OnStart();
+
+	// Released after every batch, the frames go back to the pool
+	TArray<FSLRawDataFrameRef> Batch;
+	Batch.Reserve(MaxBatchSize);
+	while (true)
+	{
+		// Read before the ring, the frames queued before the stop are seen
+		const bool bStop = bStopping.load();
+		if (FSLRawDataSink::DequeueBatch(Batch))
+		{
+			Consume(Batch, Entities);
+			Batch.Reset();
+		}
+		else if (bStop)
+		{
+			// Queue drained
+			break;
+		}
+		else
+		{
+			OnIdle();
+			DataEvent->Wait(IdleWaitMs);
+		}
+	}
+
+	OnFinish();
+	return 0;
+}
+
+// Ask the thread to stop after consuming the queued frames
+void FSLRawDataSink::Stop()
+{
+	bStopping.store(true);
+	if (DataEvent)
+	{
+		DataEvent->Trigger();
+	}
+}
+
+// Add the frame to the ring
+bool FSLRawDataSink::TryEnqueue(const FSLRawDataFrameRef& Frame)
+{
+	// Only this thread moves the tail, the head only moves forward
+	const uint64 Tail = QueueTail.load(std::memory_order_relaxed);
+	if (Tail - QueueHead.load(std::memory_order_acquire) == (uint64)Capacity)
+	{
+		return false;
+	}
+
+	// The slot was cleared by the sink thread before it released it
+	Queue[(int32)(Tail % Capacity)] = Frame;
+	QueueTail.store(Tail + 1, std::memory_order_release);
+	return true;
+}
+
+// Queue the frames waiting for room
+bool FSLRawDataSink::TryEnqueuePending()
+{
+	if (bHasMergedFrame)
+	{
+		return FSLRawDataSink::TryEnqueueMerged();
+	}
+
+	if (bHasOverflow)
+	{
+		TSharedPtr<const FSLRawDataFrame, ESPMode::ThreadSafe> Frame;
+		while (Overflow.Peek(Frame) && FSLRawDataSink::TryEnqueue(Frame.ToSharedRef()))
+		{
+			Overflow.Pop();
+		}
+		bHasOverflow = !Overflow.IsEmpty();
+		return !bHasOverflow;
+	}
+	return true;
+}
+
+// Merge the frame into the pending merged frame
+void FSLRawDataSink::MergeFrame(const FSLRawDataFrame& Frame)
+{
+	if (bHasMergedFrame)
+	{
+		NumMerged++;
+	}
+	bHasMergedFrame = true;
+	MergedTimestamp = Frame.Timestamp;
+	bMergedKeyframe |= Frame.bIsKeyframe;
+	MergedNewEntities.Append(Frame.NewEntities);
+
+	// The bone poses follow the pose of their entity
+	FSLRawDataMergedEntity* Entity = nullptr;
+	for (const FSLRawDataPose& Pose : Frame.Poses)
+	{
+		if (Pose.BoneIndex == INDEX_NONE)
+		{
+			if (const int32* Position = MergedEntityPositions.Find(Pose.EntityIndex))
+			{
+				Entity = &MergedEntities[*Position];
+			}
+			else
+			{
+				const int32 NewPosition = MergedEntities.AddDefaulted();
+				MergedEntityPositions.Add(Pose.EntityIndex, NewPosition);
+				Entity = &MergedEntities[NewPosition];
+			}
+			Entity->EntityPose = Pose;
+		}
+		else if (Entity)
+		{
+			while (Entity->BonePositions.Num() <= Pose.BoneIndex)
+			{
+				Entity->BonePositions.Add(INDEX_NONE);
+			}
+			int32& BonePosition = Entity->BonePositions[Pose.BoneIndex];
+			if (BonePosition == INDEX_NONE)
+			{
+				BonePosition = Entity->BonePoses.Add(Pose);
+			}
+			else
+			{
+				Entity->BonePoses[BonePosition] = Pose;
+			}
+		}
+	}
+}
+
+// Queue the pending merged frame
+bool FSLRawDataSink::TryEnqueueMerged()
+{
+	// Only this thread adds frames, the room cannot be taken before the frame is queued
+	if (QueueTail.load(std::memory_order_relaxed) - QueueHead.load(std::memory_order_acquire) == (uint64)Capacity)
+	{
+		return false;
+	}
+
+	// Not a pooled frame, the merged poses are copied
+	FSLRawDataFrame* Merged = new FSLRawDataFrame();
+	Merged->Timestamp = MergedTimestamp;
+	Merged->bIsKeyframe = bMergedKeyframe;
+	Exchange(Merged->NewEntities, MergedNewEntities);
+	for (const FSLRawDataMergedEntity& EntityItr : MergedEntities)
+	{
+		Merged->Poses.Add(EntityItr.EntityPose);
+		Merged->Poses.Append(EntityItr.BonePoses);
+	}
+	MergedEntities.Reset();
+	MergedEntityPositions.Reset();
+	MergedNewEntities.Reset();
+	bMergedKeyframe = false;
+	bHasMergedFrame = false;
+
+	FSLRawDataSink::TryEnqueue(MakeShareable(Merged));
+	return true;
+}
+
+// Take the next frames out of the ring
+bool FSLRawDataSink::DequeueBatch(TArray<FSLRawDataFrameRef>& OutBatch)
+{
+	// Only this thread moves the head, the frames up to the tail are published
+	const uint64 Head = QueueHead.load(std::memory_order_relaxed);
+	const int32 NumDequeued = (int32)FMath::Min(QueueTail.load(std::memory_order_acquire) - Head, (uint64)MaxBatchSize);
+	if (NumDequeued == 0)
+	{
+		return false;
+	}
+
+	// The slots are cleared before they are released to the producer
+	for (int32 Idx = 0; Idx < NumDequeued; ++Idx)
+	{
+		TSharedPtr<const FSLRawDataFrame, ESPMode::ThreadSafe>& Slot = Queue[(int32)((Head + Idx) % Capacity)];
+		OutBatch.Add(Slot.ToSharedRef());
+		Slot.Reset();
+	}
+	QueueHead.store(Head + NumDequeued, std::memory_order_release);
+
+	for (const FSLRawDataFrameRef& Frame : OutBatch)
+	{
+		Entities.Append(Frame->NewEntities);
+	}
+	SpaceEvent->Trigger();
+	return true;
+}
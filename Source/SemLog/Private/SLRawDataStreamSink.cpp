@@ -0,0 +1,412 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataStreamSink.h"
+#include "SLRawDataFraming.h"
+#include "Common/TcpListener.h"
+#include "Common/TcpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+// Constructor
+FSLRawDataStreamSink::FSLRawDataStreamSink()
+	: ListenSocket(nullptr), Listener(nullptr), NumClients(0), MaxClientBacklog(4 * 1024 * 1024), LastTimestamp(0.f)
+{
+}
+
+// Destructor, disconnects the clients
+FSLRawDataStreamSink::~FSLRawDataStreamSink()
+{
+	FSLRawDataSink::Finish();
+	FSLRawDataStreamSink::OnFinish();
+}
+
+// Listen on the local port
+bool FSLRawDataStreamSink::Listen(int32 Port, int32 InMaxClientBacklog)
+{
+	if (IsStarted() || Listener)
+	{
+		return false;
+	}
+	MaxClientBacklog = FMath::Max(InMaxClientBacklog, 1024);
+
+	// Every client gets the same stream header
+	StreamHeader.Reset();
+	FSLRawDataFramed::WriteHeader(StreamHeader);
+	BinaryWriter.WriteHeader();
+	FSLRawDataFramed::WriteRecord(BinaryWriter.GetBuffer().GetData(), BinaryWriter.GetBuffer().Num(), StreamHeader);
+	BinaryWriter.Reset();
+
+	// Local connections only, bound here to report a taken port right away
+	ListenSocket = FTcpSocketBuilder(TEXT("SLRawDataStream"))
+		.AsReusable()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address(127, 0, 0, 1), Port))
+		.Listening(8);
+	if (!ListenSocket)
+	{
+		UE_LOG(LogTemp, Error, TEXT(" %s::%d Could not listen on port %d"), TEXT(__FUNCTION__), __LINE__, Port);
+		return false;
+	}
+
+	Listener = new FTcpListener(*ListenSocket, FTimespan::FromMilliseconds(100));
+	Listener->OnConnectionAccepted().BindRaw(this, &FSLRawDataStreamSink::OnConnectionAccepted);
+	return true;
+}
+
+// Port the sink listens on
+int32 FSLRawDataStreamSink::GetPort() const
+{
+	return ListenSocket ? ListenSocket->GetPortNo() : 0;
+}
+
+// Add the frames to the clients and send them
+void FSLRawDataStreamSink::Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	FSLRawDataStreamSink::AddNewClients();
+	for (FClient& Client : Clients)
+	{
+		FSLRawDataStreamSink::UpdateMatches(Client, Entities);
+	}
+
+	// The last poses are kept without clients as well, for the snapshots of the clients joining later
+	for (const FSLRawDataFrameRef& Frame : Frames)
+	{
+		for (FClient& Client : Clients)
+		{
+			FSLRawDataStreamSink::AddFrameToClient(Client, *Frame, Entities);
+		}
+		FSLRawDataStreamSink::UpdateLastPoses(*Frame);
+	}
+
+	if (Clients.Num() > 0)
+	{
+		FSLRawDataStreamSink::UpdateClients();
+	}
+}
+
+// Take over the new connections, read the subscriptions and send the pending bytes
+void FSLRawDataStreamSink::OnIdle()
+{
+	FSLRawDataStreamSink::AddNewClients();
+	FSLRawDataStreamSink::UpdateClients();
+}
+
+// Stop listening and disconnect the clients
+void FSLRawDataStreamSink::OnFinish()
+{
+	if (Listener)
+	{
+		// Joins the listener thread, the socket is not owned by the listener
+		delete Listener;
+		Listener = nullptr;
+	}
+	if (ListenSocket)
+	{
+		ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+		ListenSocket = nullptr;
+	}
+
+	FSLRawDataStreamSink::AddNewClients();
+	for (FClient& Client : Clients)
+	{
+		FSLRawDataStreamSink::CloseClient(Client);
+	}
+	Clients.Empty();
+	NumClients.store(0);
+}
+
+// Accept the connection (listener thread)
+bool FSLRawDataStreamSink::OnConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint)
+{
+	NewSockets.Enqueue(Socket);
+	return true;
+}
+
+// Take over the accepted connections
+void FSLRawDataStreamSink::AddNewClients()
+{
+	FSocket* Socket = nullptr;
+	while (NewSockets.Dequeue(Socket))
+	{
+		// Writes never block the sink thread, small frames are sent right away
+		Socket->SetNonBlocking(true);
+		Socket->SetNoDelay(true);
+
+		FClient& Client = Clients[Clients.AddDefaulted()];
+		Client.Socket = Socket;
+		Client.Address = Socket->GetDescription();
+		Client.SendBuffer.Append(StreamHeader);
+		Client.bNeedsSnapshot = true;
+		NumClients.store(Clients.Num());
+		UE_LOG(LogTemp, Log, TEXT(" %s::%d Raw data client %s connected (%d clients)"),
+			TEXT(__FUNCTION__), __LINE__, *Client.Address, Clients.Num());
+	}
+}
+
+// Read the subscription messages and send the pending bytes, removes the disconnected clients
+void FSLRawDataStreamSink::UpdateClients()
+{
+	for (int32 Idx = Clients.Num() - 1; Idx >= 0; --Idx)
+	{
+		FClient& Client = Clients[Idx];
+		if (!FSLRawDataStreamSink::ReceiveFromClient(Client) || !FSLRawDataStreamSink::SendToClient(Client))
+		{
+			UE_LOG(LogTemp, Log, TEXT(" %s::%d Raw data client %s disconnected (%d frames dropped)"),
+				TEXT(__FUNCTION__), __LINE__, *Client.Address, Client.NumDropped);
+			FSLRawDataStreamSink::CloseClient(Client);
+			Clients.RemoveAtSwap(Idx);
+		}
+	}
+	NumClients.store(Clients.Num());
+}
+
+// Add the frame to the client, with the entity chunks it did not receive yet
+bool FSLRawDataStreamSink::AddFrameToClient(FClient& Client, const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	// Unsent entities stay unsent, they go out with the snapshot before the next delivered frame
+	if (Client.SendBuffer.Num() - Client.SendOffset > MaxClientBacklog)
+	{
+		Client.NumDropped++;
+		Client.bNeedsSnapshot = true;
+		FSLRawDataSink::AddDropped(1);
+		return false;
+	}
+
+	// New, resubscribed or lagging clients first get the poses they miss
+	if (Client.bNeedsSnapshot)
+	{
+		FSLRawDataStreamSink::AddSnapshotToClient(Client, Entities);
+		Client.bNeedsSnapshot = false;
+	}
+
+	ClientFrame.Reset();
+	ClientFrame.Timestamp = Frame.Timestamp;
+	ClientFrame.bIsKeyframe = Frame.bIsKeyframe;
+	FSLRawDataStreamSink::AddMissingEntities(Client, Entities, ClientFrame);
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		if (Client.Matches.IsValidIndex(PoseItr.EntityIndex) && Client.Matches[PoseItr.EntityIndex])
+		{
+			ClientFrame.Poses.Add(PoseItr);
+		}
+	}
+	FSLRawDataStreamSink::WriteClientFrame(Client);
+	return true;
+}
+
+// Add a keyframe with the last poses of the subscribed entities to the client
+void FSLRawDataStreamSink::AddSnapshotToClient(FClient& Client, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	ClientFrame.Reset();
+	ClientFrame.Timestamp = LastTimestamp;
+	ClientFrame.bIsKeyframe = true;
+	for (TConstSetBitIterator<> MatchItr(Client.Matches); MatchItr; ++MatchItr)
+	{
+		if (LastPoses.IsValidIndex(MatchItr.GetIndex()))
+		{
+			for (const FSLRawDataPose& PoseItr : LastPoses[MatchItr.GetIndex()])
+			{
+				if (PoseItr.EntityIndex != INDEX_NONE)
+				{
+					ClientFrame.Poses.Add(PoseItr);
+				}
+			}
+		}
+	}
+
+	// Nothing consumed yet, the entities go out with the frame
+	if (ClientFrame.Poses.Num() > 0)
+	{
+		FSLRawDataStreamSink::AddMissingEntities(Client, Entities, ClientFrame);
+		FSLRawDataStreamSink::WriteClientFrame(Client);
+	}
+}
+
+// Add the subscribed entities the client did not receive yet to the client frame
+void FSLRawDataStreamSink::AddMissingEntities(FClient& Client, const TArray<FSLRawDataEntityDesc>& Entities, FSLRawDataFrame& OutFrame)
+{
+	// Late or resubscribed clients get all the subscribed entities they miss
+	while (Client.SentEntities.Num() < Entities.Num())
+	{
+		Client.SentEntities.Add(false);
+	}
+	for (TConstSetBitIterator<> MatchItr(Client.Matches); MatchItr; ++MatchItr)
+	{
+		const int32 EntityIndex = MatchItr.GetIndex();
+		if (!Client.SentEntities[EntityIndex])
+		{
+			OutFrame.NewEntities.Add(Entities[EntityIndex]);
+			Client.SentEntities[EntityIndex] = true;
+		}
+	}
+}
+
+// Write the client frame as a record to the client, unless it is empty
+void FSLRawDataStreamSink::WriteClientFrame(FClient& Client)
+{
+	if (ClientFrame.NewEntities.Num() == 0 && ClientFrame.Poses.Num() == 0)
+	{
+		return;
+	}
+
+	BinaryWriter.WriteFrame(ClientFrame);
+	FSLRawDataFramed::WriteRecord(BinaryWriter.GetBuffer().GetData(), BinaryWriter.GetBuffer().Num(), Client.SendBuffer);
+	BinaryWriter.Reset();
+}
+
+// Keep the poses of the frame as the last poses
+void FSLRawDataStreamSink::UpdateLastPoses(const FSLRawDataFrame& Frame)
+{
+	LastTimestamp = Frame.Timestamp;
+	for (const FSLRawDataPose& PoseItr : Frame.Poses)
+	{
+		if (LastPoses.Num() <= PoseItr.EntityIndex)
+		{
+			LastPoses.SetNum(PoseItr.EntityIndex + 1);
+		}
+
+		// The entity pose is first, followed by the bone poses
+		TArray<FSLRawDataPose>& EntityPoses = LastPoses[PoseItr.EntityIndex];
+		const int32 Slot = PoseItr.BoneIndex + 1;
+		while (EntityPoses.Num() <= Slot)
+		{
+			EntityPoses.Emplace(INDEX_NONE, EntityPoses.Num() - 1, FVector::ZeroVector, FQuat::Identity);
+		}
+		EntityPoses[Slot] = PoseItr;
+	}
+}
+
+// Check the entities added since the last call against the subscribed classes
+void FSLRawDataStreamSink::UpdateMatches(FClient& Client, const TArray<FSLRawDataEntityDesc>& Entities)
+{
+	for (int32 EntityIndex = Client.Matches.Num(); EntityIndex < Entities.Num(); ++EntityIndex)
+	{
+		bool bMatch = Client.Classes.Num() == 0;
+		if (!bMatch)
+		{
+			// Unique names are Class_Id
+			FString Class;
+			FString Id;
+			Entities[EntityIndex].UniqueName.Split(TEXT("_"), &Class, &Id, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+			bMatch = Client.Classes.Contains(Class);
+		}
+		Client.Matches.Add(bMatch);
+	}
+}
+
+// Read the received bytes
+bool FSLRawDataStreamSink::ReceiveFromClient(FClient& Client)
+{
+	uint8 Bytes[1024];
+	int32 BytesRead = 0;
+	while (true)
+	{
+		// False once the client closed the connection, no bytes read if none are pending
+		if (!Client.Socket->Recv(Bytes, sizeof(Bytes), BytesRead))
+		{
+			return false;
+		}
+		if (BytesRead <= 0)
+		{
+			return true;
+		}
+
+		for (int32 Idx = 0; Idx < BytesRead; ++Idx)
+		{
+			if (Bytes[Idx] != '\n')
+			{
+				// Ignore overlong lines
+				if (Client.LineBuffer.Num() < MaxLineLength)
+				{
+					Client.LineBuffer.Add(Bytes[Idx]);
+				}
+				continue;
+			}
+
+			FUTF8ToTCHAR Converter((const ANSICHAR*)Client.LineBuffer.GetData(), Client.LineBuffer.Num());
+			FSLRawDataStreamSink::ParseLine(Client, FString(Converter.Length(), Converter.Get()));
+			Client.LineBuffer.Reset();
+		}
+	}
+}
+
+// Send as much of the pending bytes as the socket takes
+bool FSLRawDataStreamSink::SendToClient(FClient& Client)
+{
+	while (Client.SendOffset < Client.SendBuffer.Num())
+	{
+		int32 BytesSent = 0;
+		if (!Client.Socket->Send(Client.SendBuffer.GetData() + Client.SendOffset,
+			Client.SendBuffer.Num() - Client.SendOffset, BytesSent))
+		{
+			// The socket buffer is full, try again later
+			return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+		}
+		if (BytesSent <= 0)
+		{
+			break;
+		}
+		Client.SendOffset += BytesSent;
+	}
+
+	// Keep the unsent tail, drop the sent head once it grew large
+	if (Client.SendOffset < Client.SendBuffer.Num())
+	{
+		if (Client.SendOffset > MaxClientBacklog)
+		{
+			Client.SendBuffer.RemoveAt(0, Client.SendOffset, false);
+			Client.SendOffset = 0;
+		}
+		return true;
+	}
+
+	// Everything sent, keep the allocation
+	Client.SendBuffer.Reset();
+	Client.SendOffset = 0;
+	return true;
+}
+
+// Set the subscribed classes from a received line
+void FSLRawDataStreamSink::ParseLine(FClient& Client, const FString& Line)
+{
+	FString Command;
+	FString Args;
+	if (!Line.TrimStartAndEnd().Split(TEXT(" "), &Command, &Args))
+	{
+		Command = Line.TrimStartAndEnd();
+	}
+	if (!Command.Equals(TEXT("classes")))
+	{
+		return;
+	}
+
+	Client.Classes.Reset();
+	TArray<FString> Classes;
+	Args.ParseIntoArray(Classes, TEXT(","), true);
+	for (const FString& Class : Classes)
+	{
+		const FString TrimmedClass = Class.TrimStartAndEnd();
+		if (!TrimmedClass.IsEmpty() && !TrimmedClass.Equals(TEXT("*")))
+		{
+			Client.Classes.Add(TrimmedClass);
+		}
+	}
+
+	// Checked again with the next frame, the already sent entities are not sent again,
+	// the last poses of the newly subscribed entities are sent before the next frame
+	Client.Matches.Empty();
+	Client.bNeedsSnapshot = true;
+}
+
+// Close the connection
+void FSLRawDataStreamSink::CloseClient(FClient& Client)
+{
+	if (Client.Socket)
+	{
+		Client.Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Client.Socket);
+		Client.Socket = nullptr;
+	}
+}
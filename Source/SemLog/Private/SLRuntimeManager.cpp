@@ -20,10 +20,36 @@ ASLRuntimeManager::ASLRuntimeManager()
 	
 	bLogRawData = true;
 	RawDataUpdateRate = 0.f;
+	bRawDataFixedTimestep = true;
+	RawDataMaxCatchUpSamples = 4;
+	bRawDataAdaptiveSampling = false;
+	RawDataMaxSamplingPeriod = 1.f;
 	RawDataDistanceThreshold = 0.5f;
+	RawDataAngularThreshold = 2.f;
+	RawDataKeyframeInterval = 100;
 	TimePassedSinceLastUpdate = 0.f;
 	bWriteRawDataToFile = true;
+	RawDataFormat = ESLRawDataFormat::Json;
+	bCompressRawData = false;
+	bFrameRawData = false;
+	bQuantizeRawData = false;
+	RawDataPositionPrecision = 0.1f;
+	bDeltaEncodeRawData = false;
+	RawDataWriterQueueSize = 256;
+	RawDataWriterQueuePolicy = ESLRawDataQueuePolicy::Block;
 	bBroadcastRawData = false;
+	bWriteRawDataToMongo = false;
+	RawDataMongoUri = "mongodb://127.0.0.1:27017";
+	RawDataMongoDatabase = "SemLog";
+	RawDataMongoBatchSize = 1000;
+	RawDataMongoFlushInterval = 1.f;
+	bStreamRawData = false;
+	RawDataStreamPort = 7100;
+	RawDataStreamMaxClientBacklog = 4096;
+	bPublishRawDataToSharedMemory = false;
+	RawDataSharedMemoryName = "SLRawData";
+	RawDataSharedMemorySlots = 64;
+	RawDataSharedMemoryMaxPoses = 4096;
 	
 	bLogEventData = true;
 	bWriteEventDataToFile = true;
@@ -76,6 +102,13 @@ void ASLRuntimeManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
 void ASLRuntimeManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	if (bRawDataFixedTimestep && RawDataUpdateRate > 0.f)
+	{
+		// The logger keeps the sample times
+		RawDataLogger->LogDynamicEntitiesFixedStep();
+		return;
+	}
 	
 	// Increase duration
 	TimePassedSinceLastUpdate += DeltaTime;
@@ -106,12 +139,44 @@ void ASLRuntimeManager::Init()
 			RawDataLogger = NewObject<USLRawDataLogger>(this, TEXT("RawDataLogger"));
 
 			// Init logger 
-			RawDataLogger->Init(GetWorld(), RawDataDistanceThreshold);
+			RawDataLogger->Init(GetWorld(), RawDataDistanceThreshold, RawDataAngularThreshold, RawDataKeyframeInterval);
+
+			// Sample at exact times
+			if (bRawDataFixedTimestep)
+			{
+				RawDataLogger->InitFixedTimestep(RawDataUpdateRate, RawDataMaxCatchUpSamples);
+			}
+
+			// Set the quantization
+			if (bQuantizeRawData)
+			{
+				RawDataLogger->InitQuantization(RawDataPositionPrecision, RawDataClassPositionPrecisions, bDeltaEncodeRawData);
+			}
+
+			// Set the sampling periods
+			RawDataLogger->InitSampling(RawDataClassSamplingPeriods, bRawDataAdaptiveSampling, RawDataMaxSamplingPeriod);
 
 			// Set logging type
 			if (bWriteRawDataToFile)
 			{
-				RawDataLogger->InitFileHandle(EpisodeId, LogDirectory);
+				RawDataLogger->InitFileHandle(EpisodeId, LogDirectory, RawDataFormat, bCompressRawData, bFrameRawData);
+				RawDataLogger->InitFileQueue(RawDataWriterQueueSize, RawDataWriterQueuePolicy);
+			}
+
+			if (bWriteRawDataToMongo)
+			{
+				RawDataLogger->InitMongoWriter(EpisodeId, RawDataMongoUri, RawDataMongoDatabase,
+					RawDataMongoBatchSize, RawDataMongoFlushInterval);
+			}
+
+			if (bStreamRawData)
+			{
+				RawDataLogger->InitStreamServer(RawDataStreamPort, RawDataStreamMaxClientBacklog);
+			}
+
+			if (bPublishRawDataToSharedMemory)
+			{
+				RawDataLogger->InitSharedMemory(RawDataSharedMemoryName, RawDataSharedMemorySlots, RawDataSharedMemoryMaxPoses);
 			}
 
 			if (bBroadcastRawData)
@@ -183,6 +248,13 @@ void ASLRuntimeManager::Finish()
 {
 	if (bIsStarted && !bIsFinished)
 	{
+		if (bLogRawData && RawDataLogger)
+		{
+			// Stop capturing, write the queued raw data and close the file
+			SetActorTickEnabled(false);
+			RawDataLogger->Finish();
+		}
+
 		if (bLogEventData && EventDataLogger)
 		{
 			// Finish up the logger - Terminate idle events
@@ -0,0 +1,110 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataBinary.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Frames written by the test
+static const int32 BinaryTestNumFrames = 10;
+
+// Frame with a cup (0) and a two bone hand (2), the entity index 1 is never used,
+// the first frame adds the cup, the hand is added in the third frame
+static void MakeBinaryTestFrame(int32 FrameIdx, FSLRawDataFrame& OutFrame)
+{
+	OutFrame.Reset();
+	OutFrame.Timestamp = FrameIdx * 0.25f;
+	OutFrame.bIsKeyframe = FrameIdx % 5 == 0;
+	if (FrameIdx == 0)
+	{
+		OutFrame.NewEntities.Emplace(0, TEXT("Cup_1"));
+	}
+	if (FrameIdx == 2)
+	{
+		FSLRawDataEntityDesc& Hand = OutFrame.NewEntities[OutFrame.NewEntities.Emplace(2, TEXT("Hand_3"))];
+		Hand.BoneNames.Add(TEXT("palm"));
+		Hand.BoneNames.Add(TEXT("thumb"));
+	}
+	OutFrame.Poses.Emplace(0, INDEX_NONE, FVector(1.5f * FrameIdx, -20.25f, 300.f),
+		FQuat(FVector::UpVector, 0.1f * FrameIdx));
+	if (FrameIdx >= 2)
+	{
+		OutFrame.Poses.Emplace(2, INDEX_NONE, FVector(0.f, 50.f, 100.f + FrameIdx), FQuat::Identity);
+		OutFrame.Poses.Emplace(2, 0, FVector(0.f, 50.f, 110.f), FQuat(FVector::ForwardVector, 0.5f));
+		OutFrame.Poses.Emplace(2, 1, FVector(0.f, 55.f - FrameIdx, 110.f), FQuat::Identity);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataBinaryTest, "SemLog.RawData.Binary",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Write frames with the binary writer and read them back unchanged
+bool FSLRawDataBinaryTest::RunTest(const FString& Parameters)
+{
+	FSLRawDataBinaryWriter Writer;
+	Writer.WriteHeader();
+	TArray<FSLRawDataFrame> Written;
+	Written.SetNum(BinaryTestNumFrames);
+	for (int32 FrameIdx = 0; FrameIdx < BinaryTestNumFrames; ++FrameIdx)
+	{
+		MakeBinaryTestFrame(FrameIdx, Written[FrameIdx]);
+		Writer.WriteFrame(Written[FrameIdx]);
+	}
+
+	FSLRawDataBinaryReader Reader;
+	if (!TestTrue(TEXT("The written bytes are parsed"), Reader.LoadFromBuffer(Writer.GetBuffer())))
+	{
+		return false;
+	}
+
+	// Entities indexed by EntityIndex, the unused index stays empty
+	if (TestTrue(TEXT("Entity table size"), Reader.Entities.Num() == 3))
+	{
+		TestTrue(TEXT("Cup name"), Reader.Entities[0].UniqueName == TEXT("Cup_1"));
+		TestTrue(TEXT("The unused index has no name"), Reader.Entities[1].UniqueName.IsEmpty());
+		TestEqual(TEXT("Hand index"), Reader.Entities[2].EntityIndex, 2);
+		TestTrue(TEXT("Hand name"), Reader.Entities[2].UniqueName == TEXT("Hand_3"));
+		TestEqual(TEXT("Hand bones"), Reader.Entities[2].BoneNames.Num(), 2);
+		if (Reader.Entities[2].BoneNames.Num() == 2)
+		{
+			TestTrue(TEXT("Second bone name"), Reader.Entities[2].BoneNames[1] == TEXT("thumb"));
+		}
+	}
+
+	// Float poses are stored as they are
+	if (!TestTrue(TEXT("Number of frames"), Reader.Frames.Num() == BinaryTestNumFrames))
+	{
+		return false;
+	}
+	for (int32 FrameIdx = 0; FrameIdx < BinaryTestNumFrames; ++FrameIdx)
+	{
+		const FSLRawDataFrame& Expected = Written[FrameIdx];
+		const FSLRawDataFrame& Read = Reader.Frames[FrameIdx];
+		const FString Prefix = FString::Printf(TEXT("Frame %d "), FrameIdx);
+		TestTrue(Prefix + TEXT("timestamp"), Read.Timestamp == Expected.Timestamp);
+		TestTrue(Prefix + TEXT("keyframe"), Read.bIsKeyframe == Expected.bIsKeyframe);
+		if (!TestTrue(Prefix + TEXT("number of poses"), Read.Poses.Num() == Expected.Poses.Num()))
+		{
+			continue;
+		}
+		for (int32 PoseIdx = 0; PoseIdx < Expected.Poses.Num(); ++PoseIdx)
+		{
+			const FSLRawDataPose& ExpectedPose = Expected.Poses[PoseIdx];
+			const FSLRawDataPose& ReadPose = Read.Poses[PoseIdx];
+			TestTrue(Prefix + FString::Printf(TEXT("pose %d"), PoseIdx),
+				ReadPose.EntityIndex == ExpectedPose.EntityIndex && ReadPose.BoneIndex == ExpectedPose.BoneIndex &&
+				ReadPose.Location == ExpectedPose.Location && ReadPose.Rotation == ExpectedPose.Rotation);
+		}
+	}
+
+	// Truncated files are rejected
+	TArray<uint8> Truncated = Writer.GetBuffer();
+	Truncated.SetNum(Truncated.Num() - 5);
+	TestFalse(TEXT("A truncated pose is rejected"), Reader.LoadFromBuffer(Truncated));
+	Truncated.SetNum(FSLRawDataBinary::HeaderSize - 1);
+	TestFalse(TEXT("A truncated header is rejected"), Reader.LoadFromBuffer(Truncated));
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,185 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataCompression.h"
+#include "SLRawDataBinary.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "FileHelper.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Frames written by the test
+static const int32 CompressionTestNumFrames = 200;
+
+// Uncompressed block size, small enough for several blocks
+static const int32 CompressionTestBlockSize = 1024;
+
+// Frame with a cup (0) and a two bone hand (1), each added in its own frame
+static void MakeCompressionTestFrame(int32 FrameIdx, FSLRawDataFrame& OutFrame)
+{
+	OutFrame.Reset();
+	OutFrame.Timestamp = FrameIdx * 0.05f;
+	OutFrame.bIsKeyframe = FrameIdx == 0;
+	if (FrameIdx == 0)
+	{
+		OutFrame.NewEntities.Emplace(0, TEXT("Cup_1"));
+	}
+	if (FrameIdx == 1)
+	{
+		FSLRawDataEntityDesc& Hand = OutFrame.NewEntities[OutFrame.NewEntities.Emplace(1, TEXT("Hand_2"))];
+		Hand.BoneNames.Add(TEXT("palm"));
+		Hand.BoneNames.Add(TEXT("thumb"));
+	}
+	OutFrame.Poses.Emplace(0, INDEX_NONE, FVector(FrameIdx, 2.f, 3.f), FQuat(FVector::UpVector, FrameIdx * 0.01f));
+	if (FrameIdx >= 1)
+	{
+		OutFrame.Poses.Emplace(1, INDEX_NONE, FVector(0.f, FrameIdx, 100.f), FQuat::Identity);
+		OutFrame.Poses.Emplace(1, 1, FVector(0.f, 55.f, FrameIdx), FQuat::Identity);
+	}
+}
+
+// Check that the decompressed bytes hold the written frames from the first index on
+static bool TestCompressionTestFrames(FAutomationTestBase& Test, const FString& What,
+	const TArray<uint8>& Bytes, const TArray<FSLRawDataFrame>& Written, int32 FirstFrameIdx, int32 NumFrames)
+{
+	FSLRawDataBinaryReader Reader;
+	if (!Test.TestTrue(What + TEXT(" is parsed"), Reader.LoadFromBuffer(Bytes)) ||
+		!Test.TestTrue(What + TEXT(" number of frames"), Reader.Frames.Num() == NumFrames) ||
+		!Test.TestTrue(What + TEXT(" entities"), Reader.Entities.Num() == 2 && Reader.Entities[1].BoneNames.Num() == 2))
+	{
+		return false;
+	}
+	bool bEqual = true;
+	for (int32 Idx = 0; Idx < NumFrames; ++Idx)
+	{
+		const FSLRawDataFrame& Expected = Written[FirstFrameIdx + Idx];
+		const FSLRawDataFrame& Read = Reader.Frames[Idx];
+		bool bFrameEqual = Read.Timestamp == Expected.Timestamp && Read.Poses.Num() == Expected.Poses.Num();
+		for (int32 PoseIdx = 0; bFrameEqual && PoseIdx < Expected.Poses.Num(); ++PoseIdx)
+		{
+			bFrameEqual = Read.Poses[PoseIdx].EntityIndex == Expected.Poses[PoseIdx].EntityIndex &&
+				Read.Poses[PoseIdx].BoneIndex == Expected.Poses[PoseIdx].BoneIndex &&
+				Read.Poses[PoseIdx].Location == Expected.Poses[PoseIdx].Location &&
+				Read.Poses[PoseIdx].Rotation == Expected.Poses[PoseIdx].Rotation;
+		}
+		bEqual &= Test.TestTrue(What + FString::Printf(TEXT(" frame %d"), FirstFrameIdx + Idx), bFrameEqual);
+	}
+	return bEqual;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataCompressionTest, "SemLog.RawData.Compression",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Compress binary frames into blocks, read them back with the index and with the index rebuilt from the blocks
+bool FSLRawDataCompressionTest::RunTest(const FString& Parameters)
+{
+	// Written as by the file sink, every block starts with the known entities
+	FSLRawDataBinaryWriter BinaryWriter;
+	BinaryWriter.WriteHeader();
+	FSLRawDataCompressedWriter CompressedWriter;
+	CompressedWriter.Init(BinaryWriter.GetBuffer(), CompressionTestBlockSize);
+	BinaryWriter.Reset();
+
+	TArray<uint8> Bytes;
+	CompressedWriter.WriteHeader(Bytes);
+	TArray<FSLRawDataFrame> Written;
+	Written.SetNum(CompressionTestNumFrames);
+	TArray<FSLRawDataEntityDesc> Entities;
+	TArray<int32> BlockFirstFrames;
+	for (int32 FrameIdx = 0; FrameIdx < CompressionTestNumFrames; ++FrameIdx)
+	{
+		MakeCompressionTestFrame(FrameIdx, Written[FrameIdx]);
+		if (CompressedWriter.IsBlockEmpty())
+		{
+			BlockFirstFrames.Add(FrameIdx);
+			BinaryWriter.WriteEntities(Entities, Entities.Num());
+			BinaryWriter.ResetDeltas();
+		}
+		BinaryWriter.WriteFrame(Written[FrameIdx]);
+		CompressedWriter.AddFrame(BinaryWriter.GetBuffer(), Written[FrameIdx].Timestamp, Bytes);
+		BinaryWriter.Reset();
+		Entities.Append(Written[FrameIdx].NewEntities);
+	}
+
+	// Without the last block, the index and the footer, as after a crash
+	const TArray<uint8> Unfinished = Bytes;
+	const int32 NumFullBlocks = CompressedWriter.IsBlockEmpty() ? BlockFirstFrames.Num() : BlockFirstFrames.Num() - 1;
+	CompressedWriter.Finish(Bytes);
+	if (!TestTrue(TEXT("Several full blocks"), NumFullBlocks >= 3))
+	{
+		return false;
+	}
+
+	const FString Path = FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("SLRawDataCompressionTest"), TEXT(".slrz"));
+	FSLRawDataCompressedReader Reader;
+
+	// Finished file, the index is read from the footer
+	if (TestTrue(TEXT("The finished file is saved"), FFileHelper::SaveArrayToFile(Bytes, *Path)) &&
+		TestTrue(TEXT("The finished file is opened"), Reader.Open(Path)))
+	{
+		TestFalse(TEXT("The finished file has an index"), Reader.IsRecovered());
+		TestTrue(TEXT("Number of blocks"), Reader.GetIndex().Num() == BlockFirstFrames.Num());
+
+		TArray<uint8> Decompressed = Reader.GetStreamHeader();
+		bool bAllBlocks = true;
+		for (int32 BlockIndex = 0; BlockIndex < Reader.GetIndex().Num(); ++BlockIndex)
+		{
+			bAllBlocks &= Reader.ReadBlock(BlockIndex, Decompressed);
+		}
+		if (TestTrue(TEXT("All blocks are decompressed"), bAllBlocks))
+		{
+			TestCompressionTestFrames(*this, TEXT("Whole file"), Decompressed, Written, 0, CompressionTestNumFrames);
+		}
+
+		// A time range inside the second block only decompresses that block, which is readable on its own
+		const int32 SecondBlockEnd = BlockFirstFrames[2];
+		const double RangeTime = Written[BlockFirstFrames[1] + 1].Timestamp;
+		if (TestTrue(TEXT("The range is read"), Reader.ReadRange(RangeTime, RangeTime, Decompressed)))
+		{
+			TestCompressionTestFrames(*this, TEXT("Second block"), Decompressed, Written,
+				BlockFirstFrames[1], SecondBlockEnd - BlockFirstFrames[1]);
+		}
+		Reader.Close();
+	}
+
+	// Unfinished file, the index is rebuilt from the block headers
+	if (TestTrue(TEXT("The unfinished file is saved"), FFileHelper::SaveArrayToFile(Unfinished, *Path)))
+	{
+		AddExpectedError(TEXT("Compressed raw data file without index"), EAutomationExpectedErrorFlags::Contains, 2);
+		if (TestTrue(TEXT("The unfinished file is opened"), Reader.Open(Path)))
+		{
+			TestTrue(TEXT("The index is recovered"), Reader.IsRecovered());
+			TestTrue(TEXT("All full blocks are recovered"), Reader.GetIndex().Num() == NumFullBlocks);
+
+			TArray<uint8> Decompressed = Reader.GetStreamHeader();
+			bool bAllBlocks = true;
+			for (int32 BlockIndex = 0; BlockIndex < Reader.GetIndex().Num(); ++BlockIndex)
+			{
+				bAllBlocks &= Reader.ReadBlock(BlockIndex, Decompressed);
+			}
+			if (TestTrue(TEXT("The recovered blocks are decompressed"), bAllBlocks))
+			{
+				const int32 NumRecoveredFrames = BlockFirstFrames.IsValidIndex(NumFullBlocks) ? BlockFirstFrames[NumFullBlocks] : CompressionTestNumFrames;
+				TestCompressionTestFrames(*this, TEXT("Recovered file"), Decompressed, Written, 0, NumRecoveredFrames);
+			}
+			Reader.Close();
+		}
+
+		// The partially written last block is left out
+		TArray<uint8> Truncated = Unfinished;
+		Truncated.SetNum(Truncated.Num() - 10);
+		if (TestTrue(TEXT("The truncated file is saved"), FFileHelper::SaveArrayToFile(Truncated, *Path)) &&
+			TestTrue(TEXT("The truncated file is opened"), Reader.Open(Path)))
+		{
+			TestTrue(TEXT("The truncated block is left out"), Reader.IsRecovered() && Reader.GetIndex().Num() == NumFullBlocks - 1);
+			Reader.Close();
+		}
+	}
+
+	IFileManager::Get().Delete(*Path);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,160 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataEpisodeReader.h"
+#include "SLRawDataBinary.h"
+#include "SLRawDataJson.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "FileHelper.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Frames of the episode, several checkpoint intervals without keyframes after the first frame
+static const int32 EpisodeTestNumFrames = 1000;
+
+// Frames in which the thumb moves
+static const int32 EpisodeTestThumbFrames[] = { 100, 700, 710 };
+
+// Position precision (cm) of the quantized episode
+static const float EpisodeTestPrecision = 0.01f;
+
+// Entities of the episode: a moving cup (0), a static table (1) and a hand (2) which rarely moves its thumb
+static void MakeEpisodeTestEntities(TArray<FSLRawDataEntityDesc>& OutEntities, float Precision)
+{
+	OutEntities.Reset();
+	OutEntities.Emplace(0, TEXT("Cup_1"));
+	OutEntities.Emplace(1, TEXT("Table_2"));
+	OutEntities.Emplace(2, TEXT("Hand_3"));
+	OutEntities[2].BoneNames.Add(TEXT("palm"));
+	OutEntities[2].BoneNames.Add(TEXT("thumb"));
+	for (auto& EntityItr : OutEntities)
+	{
+		EntityItr.PositionPrecision = Precision;
+	}
+}
+
+// Location of the thumb written in the frame
+static FVector GetEpisodeTestThumbLocation(int32 FrameIdx)
+{
+	return FVector(FrameIdx * 0.5f, 5.f, 13.f);
+}
+
+// Frame of the episode, only the first one is a keyframe
+static void MakeEpisodeTestFrame(int32 FrameIdx, const TArray<FSLRawDataEntityDesc>& Entities, FSLRawDataFrame& OutFrame)
+{
+	OutFrame.Reset();
+	OutFrame.Timestamp = FrameIdx * 0.01f;
+	OutFrame.bIsKeyframe = FrameIdx == 0;
+	if (FrameIdx == 0)
+	{
+		OutFrame.NewEntities = Entities;
+	}
+	OutFrame.Poses.Emplace(0, INDEX_NONE, FVector(FrameIdx * 0.25f, -20.f, 30.f), FQuat::Identity);
+	if (FrameIdx == 0)
+	{
+		OutFrame.Poses.Emplace(1, INDEX_NONE, FVector(100.f, 200.f, 0.f), FQuat::Identity);
+	}
+	OutFrame.Poses.Emplace(2, INDEX_NONE, FVector(-1.f, FrameIdx * 0.1f, 3.f), FQuat::Identity);
+	bool bMovesThumb = FrameIdx == 0;
+	for (const int32 ThumbFrame : EpisodeTestThumbFrames)
+	{
+		bMovesThumb |= FrameIdx == ThumbFrame;
+	}
+	if (bMovesThumb)
+	{
+		OutFrame.Poses.Emplace(2, 1, GetEpisodeTestThumbLocation(FrameIdx), FQuat::Identity);
+	}
+}
+
+// Check the poses looked up at several times against the written ones
+static void TestEpisodeTestPoses(FAutomationTestBase& Test, const FString& What, FSLRawDataEpisodeReader& Reader)
+{
+	// Between two frames, the json timestamps are parsed back as doubles
+	auto GetTime = [](int32 FrameIdx) { return FrameIdx * 0.01 + 0.005; };
+	const float Tolerance = 0.01f;
+
+	FSLRawDataPose Pose;
+	if (Test.TestTrue(What + TEXT(" every frame is indexed"), Reader.NumFrames() == EpisodeTestNumFrames))
+	{
+		Test.TestTrue(What + TEXT(" moving entity"), Reader.GetPose(TEXT("Cup_1"), GetTime(500), Pose) &&
+			Pose.Location.Equals(FVector(500 * 0.25f, -20.f, 30.f), Tolerance));
+		Test.TestTrue(What + TEXT(" static entity from the first frame"), Reader.GetPose(TEXT("Table_2"), GetTime(999), Pose) &&
+			Pose.Location.Equals(FVector(100.f, 200.f, 0.f), Tolerance));
+		Test.TestTrue(What + TEXT(" bone from the first frame"), Reader.GetPose(TEXT("Hand_3"), GetTime(99), Pose, TEXT("thumb")) &&
+			Pose.Location.Equals(GetEpisodeTestThumbLocation(0), Tolerance));
+		Test.TestTrue(What + TEXT(" bone from an older interval"), Reader.GetPose(TEXT("Hand_3"), GetTime(650), Pose, TEXT("thumb")) &&
+			Pose.Location.Equals(GetEpisodeTestThumbLocation(100), Tolerance));
+		Test.TestTrue(What + TEXT(" bone written before the time in the interval"), Reader.GetPose(TEXT("Hand_3"), GetTime(705), Pose, TEXT("thumb")) &&
+			Pose.Location.Equals(GetEpisodeTestThumbLocation(700), Tolerance));
+		Test.TestTrue(What + TEXT(" bone written after the time in the interval"), Reader.GetPose(TEXT("Hand_3"), GetTime(699), Pose, TEXT("thumb")) &&
+			Pose.Location.Equals(GetEpisodeTestThumbLocation(100), Tolerance));
+		Test.TestTrue(What + TEXT(" bone at the end"), Reader.GetPose(TEXT("Hand_3"), GetTime(999), Pose, TEXT("thumb")) &&
+			Pose.Location.Equals(GetEpisodeTestThumbLocation(710), Tolerance));
+		Test.TestFalse(What + TEXT(" bone never written"), Reader.GetPose(TEXT("Hand_3"), GetTime(999), Pose, TEXT("palm")));
+		Test.TestFalse(What + TEXT(" unknown entity"), Reader.GetPose(TEXT("Mug_4"), GetTime(999), Pose));
+		Test.TestFalse(What + TEXT(" before the first frame"), Reader.GetPose(TEXT("Cup_1"), -1.0, Pose));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataEpisodeReaderTest, "SemLog.RawData.EpisodeReader",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Look up poses in json, binary and delta encoded episodes, with the index built and loaded from the file
+bool FSLRawDataEpisodeReaderTest::RunTest(const FString& Parameters)
+{
+	const FString BasePath = FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("SLRawDataEpisodeTest"), TEXT(""));
+	for (int32 Format = 0; Format < 3; ++Format)
+	{
+		const bool bJson = Format == 0;
+		const bool bDelta = Format == 2;
+		const FString Name = bJson ? TEXT("Json") : bDelta ? TEXT("Delta") : TEXT("Binary");
+		TArray<FSLRawDataEntityDesc> Entities;
+		MakeEpisodeTestEntities(Entities, bDelta ? EpisodeTestPrecision : 0.f);
+
+		FSLRawDataJsonWriter JsonWriter;
+		FSLRawDataBinaryWriter BinaryWriter;
+		BinaryWriter.SetQuantize(bDelta);
+		BinaryWriter.SetDeltaEncoding(bDelta);
+		BinaryWriter.WriteHeader();
+		FSLRawDataFrame Frame;
+		for (int32 FrameIdx = 0; FrameIdx < EpisodeTestNumFrames; ++FrameIdx)
+		{
+			MakeEpisodeTestFrame(FrameIdx, Entities, Frame);
+			if (bJson)
+			{
+				JsonWriter.WriteFrame(Frame, Entities);
+			}
+			else
+			{
+				BinaryWriter.WriteFrame(Frame);
+			}
+		}
+
+		const FString Path = BasePath + (bJson ? TEXT(".json") : TEXT(".bin"));
+		if (!TestTrue(Name + TEXT(" episode is saved"),
+			FFileHelper::SaveArrayToFile(bJson ? JsonWriter.GetBuffer() : BinaryWriter.GetBuffer(), *Path)))
+		{
+			continue;
+		}
+
+		// Built and saved, then loaded from the index file
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			FSLRawDataEpisodeReader Reader;
+			const FString What = Name + (Pass == 0 ? TEXT(" built") : TEXT(" loaded"));
+			if (TestTrue(What + TEXT(" episode is opened"), Reader.Open(Path, true)))
+			{
+				TestTrue(What + TEXT(" entities"), Reader.GetEntities().Num() == 3 && Reader.FindEntity(TEXT("Hand_3")) == 2 &&
+					Reader.GetEntities()[2].BoneNames.Num() >= 1);
+				TestEpisodeTestPoses(*this, What, Reader);
+			}
+		}
+		IFileManager::Get().Delete(*Path);
+		IFileManager::Get().Delete(*(Path + TEXT(".idx")));
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,123 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataFraming.h"
+#include "Misc/Crc.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Records written by the test
+static const int32 FramingTestNumRecords = 6;
+
+// Payload of the record, the third one is empty, the others hold a record header with a wrong checksum
+static void MakeFramingTestPayload(int32 RecordIdx, TArray<uint8>& OutPayload)
+{
+	OutPayload.Reset();
+	if (RecordIdx == 2)
+	{
+		return;
+	}
+	for (int32 Idx = 0; Idx < 10 + RecordIdx * 7; ++Idx)
+	{
+		OutPayload.Add((uint8)(RecordIdx * 31 + Idx));
+	}
+
+	// Looks like a record until the checksum is checked
+	const uint8 FakePayload[4] = { 1, 2, 3, 4 };
+	const uint32 FakeHeader[3] = { FSLRawDataFramed::RecordMagic, sizeof(FakePayload), FCrc::MemCrc32(FakePayload, sizeof(FakePayload)) + 1 };
+	OutPayload.Append((const uint8*)FakeHeader, sizeof(FakeHeader));
+	OutPayload.Append(FakePayload, sizeof(FakePayload));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataFramingTest, "SemLog.RawData.Framing",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Write records, read them back and find the record boundaries around truncated and corrupted records
+bool FSLRawDataFramingTest::RunTest(const FString& Parameters)
+{
+	TArray<uint8> Bytes;
+	FSLRawDataFramed::WriteHeader(Bytes);
+	TArray<TArray<uint8>> Payloads;
+	Payloads.SetNum(FramingTestNumRecords);
+	TArray<int64> RecordOffsets;
+	for (int32 RecordIdx = 0; RecordIdx < FramingTestNumRecords; ++RecordIdx)
+	{
+		MakeFramingTestPayload(RecordIdx, Payloads[RecordIdx]);
+		RecordOffsets.Add(Bytes.Num());
+		FSLRawDataFramed::WriteRecord(Payloads[RecordIdx].GetData(), Payloads[RecordIdx].Num(), Bytes);
+	}
+	RecordOffsets.Add(Bytes.Num());
+
+	// Header
+	TestTrue(TEXT("The header is found"), FSLRawDataFramed::HasHeader(Bytes.GetData(), Bytes.Num()));
+	TestFalse(TEXT("A short header is rejected"), FSLRawDataFramed::HasHeader(Bytes.GetData(), FSLRawDataFramed::HeaderSize - 1));
+	TestFalse(TEXT("A record is not a header"), FSLRawDataFramed::HasHeader(Bytes.GetData() + RecordOffsets[0], Bytes.Num() - RecordOffsets[0]));
+
+	// Records read one after the other
+	int64 PayloadOffset = 0;
+	int32 PayloadSize = 0;
+	for (int32 RecordIdx = 0; RecordIdx < FramingTestNumRecords; ++RecordIdx)
+	{
+		const FString What = FString::Printf(TEXT("Record %d"), RecordIdx);
+		if (TestTrue(What + TEXT(" is read"), FSLRawDataFramed::ReadRecord(Bytes.GetData(), Bytes.Num(), RecordOffsets[RecordIdx], PayloadOffset, PayloadSize)))
+		{
+			TestTrue(What + TEXT(" payload"), PayloadSize == Payloads[RecordIdx].Num() &&
+				PayloadOffset + PayloadSize == RecordOffsets[RecordIdx + 1] &&
+				FMemory::Memcmp(Bytes.GetData() + PayloadOffset, Payloads[RecordIdx].GetData(), PayloadSize) == 0);
+		}
+	}
+
+	// From any offset the next record start is found, the record headers inside the payloads are skipped
+	bool bAllFound = true;
+	for (int32 RecordIdx = 0; RecordIdx < FramingTestNumRecords; ++RecordIdx)
+	{
+		TestTrue(FString::Printf(TEXT("Record %d is found at its start"), RecordIdx),
+			FSLRawDataFramed::FindRecord(Bytes.GetData(), Bytes.Num(), RecordOffsets[RecordIdx]) == RecordOffsets[RecordIdx]);
+		for (int64 Offset = RecordOffsets[RecordIdx] + 1; Offset < RecordOffsets[RecordIdx + 1]; ++Offset)
+		{
+			bAllFound &= FSLRawDataFramed::FindRecord(Bytes.GetData(), Bytes.Num(), Offset) == RecordOffsets[RecordIdx + 1];
+		}
+	}
+	TestTrue(TEXT("The next record is found from inside a record"), bAllFound);
+	TestTrue(TEXT("The search starts at the header"), FSLRawDataFramed::FindRecord(Bytes.GetData(), Bytes.Num(), 0) == RecordOffsets[0]);
+	TestTrue(TEXT("Nothing is found after the last record"), FSLRawDataFramed::FindRecord(Bytes.GetData(), Bytes.Num(), RecordOffsets.Last()) == Bytes.Num());
+
+	// Corrupted payload, the record is skipped
+	TArray<uint8> Corrupted = Bytes;
+	Corrupted[RecordOffsets[1] + FSLRawDataFramed::RecordHeaderSize + 3] ^= 0xFF;
+	TestFalse(TEXT("A corrupted payload is rejected"),
+		FSLRawDataFramed::ReadRecord(Corrupted.GetData(), Corrupted.Num(), RecordOffsets[1], PayloadOffset, PayloadSize));
+	TestTrue(TEXT("The record after the corrupted one is found"),
+		FSLRawDataFramed::FindRecord(Corrupted.GetData(), Corrupted.Num(), RecordOffsets[1]) == RecordOffsets[2]);
+
+	// Corrupted size, larger than the data or negative
+	Corrupted = Bytes;
+	const uint32 LargeSize = (uint32)Bytes.Num();
+	FMemory::Memcpy(Corrupted.GetData() + RecordOffsets[3] + 4, &LargeSize, sizeof(uint32));
+	TestFalse(TEXT("A too large size is rejected"),
+		FSLRawDataFramed::ReadRecord(Corrupted.GetData(), Corrupted.Num(), RecordOffsets[3], PayloadOffset, PayloadSize));
+	const uint32 NegativeSize = (uint32)-1;
+	FMemory::Memcpy(Corrupted.GetData() + RecordOffsets[3] + 4, &NegativeSize, sizeof(uint32));
+	TestFalse(TEXT("A negative size is rejected"),
+		FSLRawDataFramed::ReadRecord(Corrupted.GetData(), Corrupted.Num(), RecordOffsets[3], PayloadOffset, PayloadSize));
+	TestTrue(TEXT("The record after the wrong size is found"),
+		FSLRawDataFramed::FindRecord(Corrupted.GetData(), Corrupted.Num(), RecordOffsets[3]) == RecordOffsets[4]);
+
+	// Truncated last record, in the payload and in the header
+	const int64 LastOffset = RecordOffsets[FramingTestNumRecords - 1];
+	const int64 TruncatedSizes[] = { RecordOffsets.Last() - 1, LastOffset + FSLRawDataFramed::RecordHeaderSize - 1 };
+	for (const int64 TruncatedSize : TruncatedSizes)
+	{
+		const FString What = FString::Printf(TEXT("Truncated at %d"), (int32)TruncatedSize);
+		TestFalse(What + TEXT(" is rejected"),
+			FSLRawDataFramed::ReadRecord(Bytes.GetData(), TruncatedSize, LastOffset, PayloadOffset, PayloadSize));
+		TestTrue(What + TEXT(" is not found"), FSLRawDataFramed::FindRecord(Bytes.GetData(), TruncatedSize, LastOffset) == TruncatedSize);
+		TestTrue(What + TEXT(" keeps the records before it"),
+			FSLRawDataFramed::FindRecord(Bytes.GetData(), TruncatedSize, RecordOffsets[FramingTestNumRecords - 2] + 1) == TruncatedSize &&
+			FSLRawDataFramed::ReadRecord(Bytes.GetData(), TruncatedSize, RecordOffsets[FramingTestNumRecords - 2], PayloadOffset, PayloadSize));
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
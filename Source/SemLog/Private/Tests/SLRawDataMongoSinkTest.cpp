@@ -0,0 +1,227 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataMongoSink.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Guid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#ifdef WITH_MONGO
+
+// Server used by the test, a local mongod unless set in the environment
+static const TCHAR* MongoTestUriVariable = TEXT("SL_MONGO_TEST_URI");
+static const TCHAR* MongoTestDefaultUri = TEXT("mongodb://localhost:27017");
+static const TCHAR* MongoTestDatabase = TEXT("SemLogTest");
+
+// Longest wait (s) for the sink thread to send the documents
+static const double MongoTestTimeout = 5.0;
+
+// Frame with a mug and a two bone hand, the first frame adds the entities
+static FSLRawDataFrameRef MakeMongoTestFrame(int32 FrameIdx)
+{
+	FSLRawDataFrame* Frame = new FSLRawDataFrame();
+	Frame->Timestamp = FrameIdx * 0.1f;
+	Frame->bIsKeyframe = FrameIdx == 0;
+	if (FrameIdx == 0)
+	{
+		Frame->NewEntities.Emplace(0, TEXT("Mug_1"));
+		FSLRawDataEntityDesc& Hand = Frame->NewEntities[Frame->NewEntities.Emplace(1, TEXT("Hand_2"))];
+		Hand.BoneNames.Add(TEXT("palm"));
+		Hand.BoneNames.Add(TEXT("thumb"));
+	}
+	Frame->Poses.Emplace(0, INDEX_NONE, FVector(100.f + FrameIdx, 200.f, 300.f), FQuat::Identity);
+	Frame->Poses.Emplace(1, INDEX_NONE, FVector(0.f, 50.f, 100.f), FQuat::Identity);
+	Frame->Poses.Emplace(1, 0, FVector(0.f, 50.f, 110.f), FQuat::Identity);
+	Frame->Poses.Emplace(1, 1, FVector(0.f, 55.f, 110.f), FQuat::Identity);
+	return MakeShareable(Frame);
+}
+
+// Count the documents of the collection
+static int64 CountMongoTestDocuments(mongoc_collection_t* Collection)
+{
+	bson_t Filter = BSON_INITIALIZER;
+	bson_error_t Error;
+#if MONGOC_CHECK_VERSION(1, 11, 0)
+	const int64 Count = mongoc_collection_count_documents(Collection, &Filter, nullptr, nullptr, nullptr, &Error);
+#else
+	const int64 Count = mongoc_collection_count(Collection, MONGOC_QUERY_NONE, &Filter, 0, 0, nullptr, &Error);
+#endif
+	bson_destroy(&Filter);
+	return Count;
+}
+
+// Wait until the collection holds the number of documents, false on timeout
+static bool WaitForMongoTestDocuments(mongoc_collection_t* Collection, int64 Num)
+{
+	const double EndTime = FPlatformTime::Seconds() + MongoTestTimeout;
+	while (CountMongoTestDocuments(Collection) < Num)
+	{
+		if (FPlatformTime::Seconds() > EndTime)
+		{
+			return false;
+		}
+		FPlatformProcess::Sleep(0.05f);
+	}
+	return CountMongoTestDocuments(Collection) == Num;
+}
+
+// Read the number at the dotted path of the document
+static bool GetMongoTestNumber(const bson_t* Document, const char* Path, double& OutValue)
+{
+	bson_iter_t Iter;
+	bson_iter_t Found;
+	if (!bson_iter_init(&Iter, Document) || !bson_iter_find_descendant(&Iter, Path, &Found) ||
+		!BSON_ITER_HOLDS_NUMBER(&Found))
+	{
+		return false;
+	}
+	OutValue = bson_iter_as_double(&Found);
+	return true;
+}
+
+// Read the string at the dotted path of the document
+static bool GetMongoTestString(const bson_t* Document, const char* Path, FString& OutValue)
+{
+	bson_iter_t Iter;
+	bson_iter_t Found;
+	if (!bson_iter_init(&Iter, Document) || !bson_iter_find_descendant(&Iter, Path, &Found) ||
+		!BSON_ITER_HOLDS_UTF8(&Found))
+	{
+		return false;
+	}
+	OutValue = UTF8_TO_TCHAR(bson_iter_utf8(&Found, nullptr));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataMongoSinkTest, "SemLog.RawData.MongoSink",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Insert frames through the sink and check the batching, the documents and the indexes
+bool FSLRawDataMongoSinkTest::RunTest(const FString& Parameters)
+{
+	TCHAR UriBuffer[512];
+	FPlatformMisc::GetEnvironmentVariable(MongoTestUriVariable, UriBuffer, ARRAY_COUNT(UriBuffer));
+	const FString Uri = FCString::Strlen(UriBuffer) > 0 ? FString(UriBuffer) : FString(MongoTestDefaultUri);
+
+	// Own client to check the results, the collections are unique to the run
+	mongoc_client_t* Client = mongoc_client_new(TCHAR_TO_UTF8(*Uri));
+	if (!Client)
+	{
+		AddError(FString::Printf(TEXT("Invalid mongo uri %s (set %s)"), *Uri, MongoTestUriVariable));
+		return false;
+	}
+	const FString RunId = FGuid::NewGuid().ToString();
+	const FString BatchCollectionName = TEXT("RawDataBatch_") + RunId;
+	const FString IntervalCollectionName = TEXT("RawDataInterval_") + RunId;
+	mongoc_collection_t* BatchCollection = mongoc_client_get_collection(Client,
+		TCHAR_TO_UTF8(MongoTestDatabase), TCHAR_TO_UTF8(*BatchCollectionName));
+	mongoc_collection_t* IntervalCollection = mongoc_client_get_collection(Client,
+		TCHAR_TO_UTF8(MongoTestDatabase), TCHAR_TO_UTF8(*IntervalCollectionName));
+
+	// Flush by batch size: full batches are sent at once, the rest waits for the (long) interval or the finish
+	{
+		FSLRawDataMongoSink Sink;
+		if (!Sink.Connect(Uri, MongoTestDatabase, BatchCollectionName, 10, 60.f))
+		{
+			AddError(FString::Printf(TEXT("Could not connect to %s (set %s to a running mongod)"), *Uri, MongoTestUriVariable));
+		}
+		else
+		{
+			Sink.Start();
+			for (int32 FrameIdx = 0; FrameIdx < 25; ++FrameIdx)
+			{
+				Sink.Enqueue(MakeMongoTestFrame(FrameIdx));
+			}
+			TestTrue(TEXT("Two full batches are inserted before the interval"), WaitForMongoTestDocuments(BatchCollection, 20));
+			FPlatformProcess::Sleep(0.2f);
+			TestTrue(TEXT("The partial batch waits for the interval"), CountMongoTestDocuments(BatchCollection) == 20);
+			Sink.Finish();
+			TestTrue(TEXT("Finish sends the partial batch"), CountMongoTestDocuments(BatchCollection) == 25);
+			TestEqual(TEXT("No frames are dropped"), Sink.GetNumDropped(), 0);
+			TestEqual(TEXT("No frames are merged"), Sink.GetNumMerged(), 0);
+		}
+	}
+
+	// Flush by interval: a partial batch is sent once it waited the interval
+	if (!HasAnyErrors())
+	{
+		FSLRawDataMongoSink Sink;
+		if (Sink.Connect(Uri, MongoTestDatabase, IntervalCollectionName, 1000, 0.2f))
+		{
+			Sink.Start();
+			for (int32 FrameIdx = 0; FrameIdx < 5; ++FrameIdx)
+			{
+				Sink.Enqueue(MakeMongoTestFrame(FrameIdx));
+			}
+			TestTrue(TEXT("The partial batch is inserted after the interval"), WaitForMongoTestDocuments(IntervalCollection, 5));
+			Sink.Finish();
+		}
+	}
+
+	if (HasAnyErrors())
+	{
+		mongoc_collection_drop(BatchCollection, nullptr);
+		mongoc_collection_drop(IntervalCollection, nullptr);
+		mongoc_collection_destroy(BatchCollection);
+		mongoc_collection_destroy(IntervalCollection);
+		mongoc_client_destroy(Client);
+		return false;
+	}
+
+	// Document layout, same as the json frames (meters, right handed)
+	bson_t Filter = BSON_INITIALIZER;
+	bson_t* Opts = BCON_NEW("sort", "{", "timestamp", BCON_INT32(1), "}", "limit", BCON_INT64(1));
+	mongoc_cursor_t* Cursor = mongoc_collection_find_with_opts(BatchCollection, &Filter, Opts, nullptr);
+	const bson_t* Document = nullptr;
+	if (TestTrue(TEXT("The first frame is stored"), mongoc_cursor_next(Cursor, &Document)))
+	{
+		double Value = 0.0;
+		FString Name;
+		TestTrue(TEXT("timestamp"), GetMongoTestNumber(Document, "timestamp", Value) && FMath::IsNearlyZero(Value));
+		bson_iter_t Iter;
+		TestTrue(TEXT("keyframe"), bson_iter_init_find(&Iter, Document, "keyframe") && BSON_ITER_HOLDS_BOOL(&Iter) &&
+			bson_iter_bool(&Iter));
+		TestTrue(TEXT("actors.0.name"), GetMongoTestString(Document, "actors.0.name", Name) && Name == TEXT("Mug_1"));
+		TestTrue(TEXT("actors.0.pos.x"), GetMongoTestNumber(Document, "actors.0.pos.x", Value) && FMath::IsNearlyEqual(Value, 1.0, 1e-5));
+		TestTrue(TEXT("actors.0.pos.y"), GetMongoTestNumber(Document, "actors.0.pos.y", Value) && FMath::IsNearlyEqual(Value, -2.0, 1e-5));
+		TestTrue(TEXT("actors.0.pos.z"), GetMongoTestNumber(Document, "actors.0.pos.z", Value) && FMath::IsNearlyEqual(Value, 3.0, 1e-5));
+		TestTrue(TEXT("actors.0.rot.w"), GetMongoTestNumber(Document, "actors.0.rot.w", Value) && FMath::IsNearlyEqual(Value, 1.0, 1e-5));
+		TestTrue(TEXT("actors.0.rot.x"), GetMongoTestNumber(Document, "actors.0.rot.x", Value) && FMath::IsNearlyZero(Value));
+		TestTrue(TEXT("actors.1.name"), GetMongoTestString(Document, "actors.1.name", Name) && Name == TEXT("Hand_2"));
+		TestTrue(TEXT("actors.1.bones.1.name"), GetMongoTestString(Document, "actors.1.bones.1.name", Name) && Name == TEXT("thumb"));
+		TestTrue(TEXT("actors.1.bones.1.pos.y"), GetMongoTestNumber(Document, "actors.1.bones.1.pos.y", Value) && FMath::IsNearlyEqual(Value, -0.55, 1e-5));
+		TestFalse(TEXT("Only the entity has a bones array"), GetMongoTestString(Document, "actors.0.bones.0.name", Name));
+	}
+	mongoc_cursor_destroy(Cursor);
+	bson_destroy(Opts);
+	bson_destroy(&Filter);
+
+	// Indexes created when the sink started
+	bool bHasTimestampIndex = false;
+	bool bHasActorNameIndex = false;
+	Cursor = mongoc_collection_find_indexes_with_opts(BatchCollection, nullptr);
+	while (mongoc_cursor_next(Cursor, &Document))
+	{
+		FString IndexName;
+		if (GetMongoTestString(Document, "name", IndexName))
+		{
+			bHasTimestampIndex |= IndexName == TEXT("timestamp");
+			bHasActorNameIndex |= IndexName == TEXT("actors.name");
+		}
+	}
+	mongoc_cursor_destroy(Cursor);
+	TestTrue(TEXT("timestamp index"), bHasTimestampIndex);
+	TestTrue(TEXT("actors.name index"), bHasActorNameIndex);
+
+	mongoc_collection_drop(BatchCollection, nullptr);
+	mongoc_collection_drop(IntervalCollection, nullptr);
+	mongoc_collection_destroy(BatchCollection);
+	mongoc_collection_destroy(IntervalCollection);
+	mongoc_client_destroy(Client);
+	return true;
+}
+
+#endif //WITH_MONGO
+#endif //WITH_DEV_AUTOMATION_TESTS
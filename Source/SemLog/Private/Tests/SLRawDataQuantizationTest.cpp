@@ -0,0 +1,260 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataQuantization.h"
+#include "SLRawDataBinary.h"
+#include "MemoryWriter.h"
+#include "MemoryReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Frames written by the codec tests, the second block starts in the middle
+static const int32 QuantizationTestNumFrames = 10;
+static const int32 QuantizationTestBlockStart = 5;
+
+// Position precision (cm) of the quantized entity
+static const float QuantizationTestPrecision = 0.1f;
+
+// Largest rotation error of the quantized components
+static const float QuantizationTestQuatTolerance = 1e-3f;
+
+// Entities of the codec tests: a quantized cup (0), a full precision table (1) and a quantized two bone hand (2)
+static void MakeQuantizationTestEntities(TArray<FSLRawDataEntityDesc>& OutEntities)
+{
+	OutEntities.Reset();
+	OutEntities.Emplace(0, TEXT("Cup_1"));
+	OutEntities[0].PositionPrecision = QuantizationTestPrecision;
+	OutEntities.Emplace(1, TEXT("Table_2"));
+	OutEntities.Emplace(2, TEXT("Hand_3"));
+	OutEntities[2].PositionPrecision = QuantizationTestPrecision;
+	OutEntities[2].BoneNames.Add(TEXT("palm"));
+	OutEntities[2].BoneNames.Add(TEXT("thumb"));
+}
+
+// Frame of the codec tests, the first frame adds the entities and is the only keyframe,
+// the rotations cross the sign flip of w to exercise the sign choice of the deltas
+static void MakeQuantizationTestFrame(int32 FrameIdx, const TArray<FSLRawDataEntityDesc>& Entities, FSLRawDataFrame& OutFrame)
+{
+	OutFrame.Reset();
+	OutFrame.Timestamp = FrameIdx * 0.1f;
+	OutFrame.bIsKeyframe = FrameIdx == 0;
+	if (FrameIdx == 0)
+	{
+		OutFrame.NewEntities = Entities;
+	}
+	OutFrame.Poses.Emplace(0, INDEX_NONE, FVector(12.34f + FrameIdx * 0.57f, -250.01f, 80.f - FrameIdx),
+		FQuat(FVector(1.f, 2.f, 3.f).GetSafeNormal(), 2.6f + FrameIdx * 0.2f));
+	OutFrame.Poses.Emplace(1, INDEX_NONE, FVector(1.2345678f, 2.f, 3.f + FrameIdx), FQuat(FVector::UpVector, FrameIdx * 0.3f));
+	OutFrame.Poses.Emplace(2, INDEX_NONE, FVector(0.f, 50.f + FrameIdx * 1.01f, 100.f), FQuat::Identity);
+	OutFrame.Poses.Emplace(2, 0, FVector(0.f, 50.f, 110.f), FQuat(FVector::ForwardVector, -FrameIdx * 0.7f));
+	OutFrame.Poses.Emplace(2, 1, FVector(-3.333f * FrameIdx, 55.f, 110.f), FQuat(FVector::RightVector, 3.f));
+}
+
+// Check the read poses against the written ones, quantized entities within the precision
+static bool TestQuantizationTestFrame(FAutomationTestBase& Test, const FString& What,
+	const TArray<FSLRawDataEntityDesc>& Entities, const FSLRawDataFrame& Expected, const FSLRawDataFrame& Read)
+{
+	if (!Test.TestTrue(What + TEXT(" number of poses"), Read.Poses.Num() == Expected.Poses.Num()))
+	{
+		return false;
+	}
+	bool bEqual = true;
+	for (int32 PoseIdx = 0; PoseIdx < Expected.Poses.Num(); ++PoseIdx)
+	{
+		const FSLRawDataPose& ExpectedPose = Expected.Poses[PoseIdx];
+		const FSLRawDataPose& ReadPose = Read.Poses[PoseIdx];
+		const float Precision = Entities[ExpectedPose.EntityIndex].PositionPrecision;
+		const bool bPoseEqual = Precision > 0.f
+			? ReadPose.Location.Equals(ExpectedPose.Location, Precision * 0.5f + KINDA_SMALL_NUMBER) &&
+				ReadPose.Rotation.Equals(ExpectedPose.Rotation, QuantizationTestQuatTolerance)
+			: ReadPose.Location == ExpectedPose.Location && ReadPose.Rotation == ExpectedPose.Rotation;
+		bEqual &= Test.TestTrue(What + FString::Printf(TEXT(" pose %d"), PoseIdx), bPoseEqual &&
+			ReadPose.EntityIndex == ExpectedPose.EntityIndex && ReadPose.BoneIndex == ExpectedPose.BoneIndex);
+	}
+	return bEqual;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataQuantizationTest, "SemLog.RawData.Quantization",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Round trip of the zigzag and packed integers and of the smallest three rotations
+bool FSLRawDataQuantizationTest::RunTest(const FString& Parameters)
+{
+	// Zigzag keeps small magnitudes small, both ways
+	const int32 Values[] = { 0, -1, 1, -2, 2, 63, -64, 1000000, -1000000, MAX_int32, MIN_int32 };
+	for (const int32 Value : Values)
+	{
+		TestTrue(FString::Printf(TEXT("Zigzag %d"), Value),
+			FSLRawDataQuantization::ZigZagDecode(FSLRawDataQuantization::ZigZagEncode(Value)) == Value);
+	}
+	TestTrue(TEXT("Zigzag -1"), FSLRawDataQuantization::ZigZagEncode(-1) == 1);
+	TestTrue(TEXT("Zigzag 1"), FSLRawDataQuantization::ZigZagEncode(1) == 2);
+
+	// Packed (varint) integers of the zigzag values
+	TArray<uint8> Bytes;
+	{
+		FMemoryWriter Writer(Bytes);
+		for (const int32 Value : Values)
+		{
+			uint32 Encoded = FSLRawDataQuantization::ZigZagEncode(Value);
+			Writer.SerializeIntPacked(Encoded);
+		}
+	}
+	{
+		FMemoryReader Reader(Bytes);
+		for (const int32 Value : Values)
+		{
+			uint32 Encoded = 0;
+			Reader.SerializeIntPacked(Encoded);
+			TestTrue(FString::Printf(TEXT("Packed %d"), Value), FSLRawDataQuantization::ZigZagDecode(Encoded) == Value);
+		}
+		TestTrue(TEXT("All packed bytes are read"), Reader.AtEnd() && !Reader.IsError());
+	}
+	Bytes.Reset();
+	{
+		FMemoryWriter Writer(Bytes);
+		uint32 Small = FSLRawDataQuantization::ZigZagEncode(-3);
+		Writer.SerializeIntPacked(Small);
+	}
+	TestTrue(TEXT("Small values take one byte"), Bytes.Num() == 1);
+
+	// Smallest three, every component once the largest and with both signs
+	const FQuat Rotations[] = {
+		FQuat::Identity,
+		FQuat(-0.1f, 0.2f, -0.3f, -0.9f).GetNormalized(),
+		FQuat(0.9f, -0.2f, 0.1f, 0.3f).GetNormalized(),
+		FQuat(0.1f, -0.95f, 0.2f, 0.1f).GetNormalized(),
+		FQuat(-0.3f, 0.1f, -0.9f, 0.2f).GetNormalized(),
+		FQuat(0.5f, 0.5f, -0.5f, 0.5f),
+		FQuat(FVector(1.f, 2.f, 3.f).GetSafeNormal(), 2.6f) };
+	for (int32 RotationIdx = 0; RotationIdx < ARRAY_COUNT(Rotations); ++RotationIdx)
+	{
+		uint64 Packed = FSLRawDataQuantization::PackQuat(Rotations[RotationIdx]);
+		TestTrue(FString::Printf(TEXT("Rotation %d fits the packed size"), RotationIdx),
+			(Packed >> (8 * FSLRawDataQuantization::PackedQuatSize)) == 0);
+
+		Bytes.Reset();
+		{
+			FMemoryWriter Writer(Bytes);
+			FSLRawDataQuantization::SerializePackedQuat(Writer, Packed);
+		}
+		uint64 ReadPacked = 0;
+		{
+			FMemoryReader Reader(Bytes);
+			FSLRawDataQuantization::SerializePackedQuat(Reader, ReadPacked);
+		}
+		TestTrue(FString::Printf(TEXT("Rotation %d serialized"), RotationIdx),
+			Bytes.Num() == FSLRawDataQuantization::PackedQuatSize && ReadPacked == Packed);
+		TestTrue(FString::Printf(TEXT("Rotation %d unpacked"), RotationIdx),
+			FSLRawDataQuantization::UnpackQuat(ReadPacked).Equals(Rotations[RotationIdx], QuantizationTestQuatTolerance));
+
+		// Delta components, without and with a previous rotation of the opposite sign
+		const int32 NoPrevious[4] = { 0, 0, 0, 0 };
+		int32 Components[4];
+		FSLRawDataQuantization::QuantizeQuatComponents(Rotations[RotationIdx], NoPrevious, Components);
+		TestTrue(FString::Printf(TEXT("Rotation %d components keep w positive"), RotationIdx), Components[3] >= 0);
+		TestTrue(FString::Printf(TEXT("Rotation %d components"), RotationIdx),
+			FSLRawDataQuantization::DequantizeQuatComponents(Components).Equals(Rotations[RotationIdx], QuantizationTestQuatTolerance));
+		const int32 Negated[4] = { -Components[0], -Components[1], -Components[2], -Components[3] };
+		int32 Flipped[4];
+		FSLRawDataQuantization::QuantizeQuatComponents(Rotations[RotationIdx], Negated, Flipped);
+		int64 Dot = 0;
+		for (int32 Idx = 0; Idx < 4; ++Idx)
+		{
+			Dot += (int64)Flipped[Idx] * Negated[Idx];
+		}
+		TestTrue(FString::Printf(TEXT("Rotation %d components follow the previous sign"), RotationIdx), Dot > 0);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataQuantizedFramesTest, "SemLog.RawData.QuantizedFrames",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Write quantized and delta frames and read them back within the precision
+bool FSLRawDataQuantizedFramesTest::RunTest(const FString& Parameters)
+{
+	TArray<FSLRawDataEntityDesc> Entities;
+	MakeQuantizationTestEntities(Entities);
+	TArray<FSLRawDataFrame> Written;
+	Written.SetNum(QuantizationTestNumFrames);
+	for (int32 FrameIdx = 0; FrameIdx < QuantizationTestNumFrames; ++FrameIdx)
+	{
+		MakeQuantizationTestFrame(FrameIdx, Entities, Written[FrameIdx]);
+	}
+
+	// Whole stream, quantized and delta frames
+	for (int32 Pass = 0; Pass < 2; ++Pass)
+	{
+		const bool bDelta = Pass == 1;
+		const FString Codec = bDelta ? TEXT("Delta") : TEXT("Quantized");
+		FSLRawDataBinaryWriter Writer;
+		Writer.SetQuantize(true);
+		Writer.SetDeltaEncoding(bDelta);
+		Writer.WriteHeader();
+		for (const FSLRawDataFrame& FrameItr : Written)
+		{
+			Writer.WriteFrame(FrameItr);
+		}
+
+		FSLRawDataBinaryReader Reader;
+		if (!TestTrue(Codec + TEXT(" frames are parsed"), Reader.LoadFromBuffer(Writer.GetBuffer())) ||
+			!TestTrue(Codec + TEXT(" number of frames"), Reader.Frames.Num() == QuantizationTestNumFrames))
+		{
+			return false;
+		}
+		TestTrue(Codec + TEXT(" precision is kept"), Reader.Entities.Num() == 3 &&
+			Reader.Entities[0].PositionPrecision == QuantizationTestPrecision && Reader.Entities[1].PositionPrecision == 0.f);
+		for (int32 FrameIdx = 0; FrameIdx < QuantizationTestNumFrames; ++FrameIdx)
+		{
+			TestQuantizationTestFrame(*this, Codec + FString::Printf(TEXT(" frame %d"), FrameIdx),
+				Entities, Written[FrameIdx], Reader.Frames[FrameIdx]);
+		}
+	}
+
+	// Two blocks as written by the file sink, the second one starts with the entities and resets the deltas
+	FSLRawDataBinaryWriter Writer;
+	Writer.SetQuantize(true);
+	Writer.SetDeltaEncoding(true);
+	Writer.WriteHeader();
+	const TArray<uint8> Header = Writer.GetBuffer();
+	Writer.Reset();
+	for (int32 FrameIdx = 0; FrameIdx < QuantizationTestBlockStart; ++FrameIdx)
+	{
+		Writer.WriteFrame(Written[FrameIdx]);
+	}
+	Writer.Reset();
+	Writer.WriteEntities(Entities, Entities.Num());
+	Writer.ResetDeltas();
+	const int32 FirstFrameOffset = Header.Num() + Writer.GetBuffer().Num();
+	for (int32 FrameIdx = QuantizationTestBlockStart; FrameIdx < QuantizationTestNumFrames; ++FrameIdx)
+	{
+		Writer.WriteFrame(Written[FrameIdx]);
+	}
+	TArray<uint8> Block = Header;
+	Block.Append(Writer.GetBuffer());
+
+	// Chunk type, timestamp, flags
+	const int32 FlagsOffset = FirstFrameOffset + 1 + sizeof(double);
+	TestTrue(TEXT("The block starts with a delta frame"), Block[FirstFrameOffset] == FSLRawDataBinary::DeltaFrameChunk);
+	TestTrue(TEXT("The first frame of the block resets the deltas"),
+		Block[FlagsOffset] == FSLRawDataBinary::DeltaResetFlag);
+
+	// The block is decoded without the frames before it
+	FSLRawDataBinaryReader Reader;
+	if (!TestTrue(TEXT("The block is parsed on its own"), Reader.LoadFromBuffer(Block)) ||
+		!TestTrue(TEXT("Number of frames of the block"), Reader.Frames.Num() == QuantizationTestNumFrames - QuantizationTestBlockStart))
+	{
+		return false;
+	}
+	TestFalse(TEXT("The reset frame is not a keyframe"), Reader.Frames[0].bIsKeyframe);
+	for (int32 FrameIdx = QuantizationTestBlockStart; FrameIdx < QuantizationTestNumFrames; ++FrameIdx)
+	{
+		TestQuantizationTestFrame(*this, FString::Printf(TEXT("Block frame %d"), FrameIdx),
+			Entities, Written[FrameIdx], Reader.Frames[FrameIdx - QuantizationTestBlockStart]);
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,293 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataStreamSink.h"
+#include "SLRawDataFraming.h"
+#include "SLRawDataBinary.h"
+#include "HAL/PlatformProcess.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Frames sent through the sink
+static const int32 StreamTestNumFrames = 1000;
+
+// Bones of the heavy entity, enough to overflow the socket buffers of a client which never reads
+static const int32 StreamTestNumBones = 400;
+
+// Longest wait (s) for the connections and the frames
+static const double StreamTestTimeout = 10.0;
+
+// Location of the static entity, only in the first frame
+static const FVector StreamTestStaticLocation(7.f, 8.f, 9.f);
+
+// Frame with the subscribed entity (X_1), a heavy skeletal entity (Y_2) and another one (Z_3),
+// the first frame also holds the static entity (S_4)
+static FSLRawDataFrameRef MakeStreamTestFrame(int32 FrameIdx)
+{
+	FSLRawDataFrame* Frame = new FSLRawDataFrame();
+	Frame->Timestamp = FrameIdx * 0.01f;
+	Frame->bIsKeyframe = FrameIdx == 0;
+	if (FrameIdx == 0)
+	{
+		Frame->NewEntities.Emplace(0, TEXT("X_1"));
+		FSLRawDataEntityDesc& Heavy = Frame->NewEntities[Frame->NewEntities.Emplace(1, TEXT("Y_2"))];
+		for (int32 BoneIdx = 0; BoneIdx < StreamTestNumBones; ++BoneIdx)
+		{
+			Heavy.BoneNames.Add(FString::Printf(TEXT("bone_%d"), BoneIdx));
+		}
+		Frame->NewEntities.Emplace(2, TEXT("Z_3"));
+		Frame->NewEntities.Emplace(3, TEXT("S_4"));
+	}
+	Frame->Poses.Emplace(0, INDEX_NONE, FVector(FrameIdx, 0.f, 0.f), FQuat::Identity);
+	Frame->Poses.Emplace(1, INDEX_NONE, FVector(0.f, FrameIdx, 0.f), FQuat::Identity);
+	for (int32 BoneIdx = 0; BoneIdx < StreamTestNumBones; ++BoneIdx)
+	{
+		Frame->Poses.Emplace(1, BoneIdx, FVector(BoneIdx, FrameIdx, 0.f), FQuat::Identity);
+	}
+	Frame->Poses.Emplace(2, INDEX_NONE, FVector(0.f, 0.f, FrameIdx), FQuat::Identity);
+	if (FrameIdx == 0)
+	{
+		Frame->Poses.Emplace(3, INDEX_NONE, StreamTestStaticLocation, FQuat::Identity);
+	}
+	return MakeShareable(Frame);
+}
+
+// Connect a client to the local port, with a small receive buffer for the one which never reads
+static FSocket* ConnectStreamTestClient(int32 Port, bool bSmallReceiveBuffer)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("SLRawDataStreamTest"), false);
+	if (!Socket)
+	{
+		return nullptr;
+	}
+	if (bSmallReceiveBuffer)
+	{
+		int32 NewSize = 0;
+		Socket->SetReceiveBufferSize(4096, NewSize);
+	}
+	TSharedRef<FInternetAddr> Addr = SocketSubsystem->CreateInternetAddr(0x7F000001, Port);
+	if (!Socket->Connect(*Addr))
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		return nullptr;
+	}
+	return Socket;
+}
+
+// Close the client connection
+static void CloseStreamTestClient(FSocket* Socket)
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+}
+
+// Read until the framed header and the records arrived (or the timeout), the payloads are appended in order
+static int32 ReceiveStreamTestRecords(FSocket* Socket, int32 NumRecords, bool& bOutHasHeader, bool& bOutContiguous,
+	TArray<uint8>& OutPayloads)
+{
+	TArray<uint8> Received;
+	int64 RecordOffset = FSLRawDataFramed::HeaderSize;
+	int32 NumReceived = 0;
+	bOutHasHeader = false;
+	uint8 Bytes[16 * 1024];
+	const double ReadEndTime = FPlatformTime::Seconds() + StreamTestTimeout;
+	while (NumReceived < NumRecords && FPlatformTime::Seconds() < ReadEndTime)
+	{
+		int32 BytesRead = 0;
+		if (Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)) &&
+			Socket->Recv(Bytes, sizeof(Bytes), BytesRead) && BytesRead > 0)
+		{
+			Received.Append(Bytes, BytesRead);
+		}
+
+		bOutHasHeader = bOutHasHeader || FSLRawDataFramed::HasHeader(Received.GetData(), Received.Num());
+		int64 PayloadOffset = 0;
+		int32 PayloadSize = 0;
+		while (bOutHasHeader && FSLRawDataFramed::ReadRecord(Received.GetData(), Received.Num(), RecordOffset, PayloadOffset, PayloadSize))
+		{
+			OutPayloads.Append(Received.GetData() + PayloadOffset, PayloadSize);
+			RecordOffset = PayloadOffset + PayloadSize;
+			NumReceived++;
+		}
+	}
+	bOutContiguous = RecordOffset == Received.Num();
+	return NumReceived;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataStreamSinkTest, "SemLog.RawData.StreamSink",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Stream frames to a subscribed client and to one which never reads
+bool FSLRawDataStreamSinkTest::RunTest(const FString& Parameters)
+{
+	// Ephemeral port, the backlog holds the whole stream of the subscribed client
+	FSLRawDataStreamSink Sink;
+	if (!TestTrue(TEXT("Listen on a free port"), Sink.Listen(0, 64 * 1024) && Sink.GetPort() > 0))
+	{
+		return false;
+	}
+	Sink.Start();
+
+	FSocket* Subscriber = ConnectStreamTestClient(Sink.GetPort(), false);
+	FSocket* NonReader = ConnectStreamTestClient(Sink.GetPort(), true);
+	if (!TestTrue(TEXT("Clients connect"), Subscriber && NonReader))
+	{
+		CloseStreamTestClient(Subscriber);
+		CloseStreamTestClient(NonReader);
+		return false;
+	}
+	const char* Subscription = "classes X\n";
+	int32 BytesSent = 0;
+	Subscriber->Send((const uint8*)Subscription, FCStringAnsi::Strlen(Subscription), BytesSent);
+
+	// The sink reads the subscription while idle, before the first frame
+	const double ConnectEndTime = FPlatformTime::Seconds() + StreamTestTimeout;
+	while (Sink.GetNumClients() < 2 && FPlatformTime::Seconds() < ConnectEndTime)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+	TestEqual(TEXT("The sink took over both clients"), Sink.GetNumClients(), 2);
+	FPlatformProcess::Sleep(0.2f);
+
+	for (int32 FrameIdx = 0; FrameIdx < StreamTestNumFrames; ++FrameIdx)
+	{
+		Sink.Enqueue(MakeStreamTestFrame(FrameIdx));
+	}
+
+	// The binary header record and one record per frame
+	TArray<uint8> Payloads;
+	bool bHasHeader = false;
+	bool bContiguous = false;
+	const int32 NumRecords = ReceiveStreamTestRecords(Subscriber, StreamTestNumFrames + 1, bHasHeader, bContiguous, Payloads);
+	TestTrue(TEXT("The stream starts with the framed header"), bHasHeader);
+	TestEqual(TEXT("The binary header and every frame arrive as records"), NumRecords, StreamTestNumFrames + 1);
+	TestTrue(TEXT("The records are contiguous"), bContiguous);
+
+	// The slow client only costs its own frames
+	TestTrue(TEXT("Frames of the client which never reads are dropped"), Sink.GetNumDropped() > 0);
+	Sink.Finish();
+	CloseStreamTestClient(Subscriber);
+	CloseStreamTestClient(NonReader);
+
+	// The payloads form a binary raw data stream
+	FSLRawDataBinaryReader Reader;
+	if (!TestTrue(TEXT("The records hold a binary stream"), Reader.LoadFromBuffer(Payloads)))
+	{
+		return false;
+	}
+
+	// Only the subscribed class, in every frame
+	TestTrue(TEXT("Only X_1 is sent"), Reader.Entities.Num() == 1 && Reader.Entities[0].UniqueName == TEXT("X_1"));
+	TestEqual(TEXT("Every frame is received"), Reader.Frames.Num(), StreamTestNumFrames);
+	for (int32 FrameIdx = 0; FrameIdx < Reader.Frames.Num(); ++FrameIdx)
+	{
+		const FSLRawDataFrame& Frame = Reader.Frames[FrameIdx];
+		if (Frame.Poses.Num() != 1 || Frame.Poses[0].EntityIndex != 0 || Frame.Poses[0].Location.X != FrameIdx)
+		{
+			AddError(FString::Printf(TEXT("Frame %d does not hold only the X_1 pose in order"), FrameIdx));
+			break;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataStreamSinkLateJoinTest, "SemLog.RawData.StreamSink.LateJoin",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// A client joining after the static poses were streamed gets them with the snapshot
+bool FSLRawDataStreamSinkLateJoinTest::RunTest(const FString& Parameters)
+{
+	FSLRawDataStreamSink Sink;
+	if (!TestTrue(TEXT("Listen on a free port"), Sink.Listen(0, 4 * 1024 * 1024) && Sink.GetPort() > 0))
+	{
+		return false;
+	}
+	Sink.Start();
+
+	// Consumed without clients, the static entity is only in the first frame
+	const int32 NumEarlyFrames = 100;
+	const int32 NumLateFrames = 50;
+	for (int32 FrameIdx = 0; FrameIdx < NumEarlyFrames; ++FrameIdx)
+	{
+		Sink.Enqueue(MakeStreamTestFrame(FrameIdx));
+	}
+	const double ConsumeEndTime = FPlatformTime::Seconds() + StreamTestTimeout;
+	while (Sink.GetQueueDepth() > 0 && FPlatformTime::Seconds() < ConsumeEndTime)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+	FPlatformProcess::Sleep(0.2f);
+
+	FSocket* LateClient = ConnectStreamTestClient(Sink.GetPort(), false);
+	if (!TestTrue(TEXT("Client connects"), LateClient != nullptr))
+	{
+		return false;
+	}
+	const char* Subscription = "classes S,X\n";
+	int32 BytesSent = 0;
+	LateClient->Send((const uint8*)Subscription, FCStringAnsi::Strlen(Subscription), BytesSent);
+	const double ConnectEndTime = FPlatformTime::Seconds() + StreamTestTimeout;
+	while (Sink.GetNumClients() < 1 && FPlatformTime::Seconds() < ConnectEndTime)
+	{
+		FPlatformProcess::Sleep(0.01f);
+	}
+	FPlatformProcess::Sleep(0.2f);
+
+	for (int32 FrameIdx = NumEarlyFrames; FrameIdx < NumEarlyFrames + NumLateFrames; ++FrameIdx)
+	{
+		Sink.Enqueue(MakeStreamTestFrame(FrameIdx));
+	}
+
+	// The binary header record, the snapshot and the late frames
+	TArray<uint8> Payloads;
+	bool bHasHeader = false;
+	bool bContiguous = false;
+	const int32 NumRecords = ReceiveStreamTestRecords(LateClient, NumLateFrames + 2, bHasHeader, bContiguous, Payloads);
+	Sink.Finish();
+	CloseStreamTestClient(LateClient);
+	TestEqual(TEXT("The header, the snapshot and the late frames arrive as records"), NumRecords, NumLateFrames + 2);
+
+	FSLRawDataBinaryReader Reader;
+	if (!TestTrue(TEXT("The records hold a binary stream"), Reader.LoadFromBuffer(Payloads)) ||
+		!TestEqual(TEXT("The snapshot comes before the late frames"), Reader.Frames.Num(), NumLateFrames + 1))
+	{
+		return false;
+	}
+	TestTrue(TEXT("The subscribed entities are sent"), Reader.Entities.Num() == 4 &&
+		Reader.Entities[0].UniqueName == TEXT("X_1") && Reader.Entities[3].UniqueName == TEXT("S_4"));
+
+	// The snapshot holds the static pose of the first frame and the last pose of the moving entity
+	const FSLRawDataFrame& Snapshot = Reader.Frames[0];
+	TestTrue(TEXT("The snapshot is a keyframe"), Snapshot.bIsKeyframe);
+	TestEqual(TEXT("The snapshot holds both entities"), Snapshot.Poses.Num(), 2);
+	bool bHasStaticPose = false;
+	bool bHasLastPose = false;
+	for (const FSLRawDataPose& Pose : Snapshot.Poses)
+	{
+		bHasStaticPose |= Pose.EntityIndex == 3 && Pose.Location.Equals(StreamTestStaticLocation);
+		bHasLastPose |= Pose.EntityIndex == 0 && Pose.Location.X == NumEarlyFrames - 1;
+	}
+	TestTrue(TEXT("The snapshot holds the static pose"), bHasStaticPose);
+	TestTrue(TEXT("The snapshot holds the last pose of X_1"), bHasLastPose);
+
+	for (int32 FrameIdx = 1; FrameIdx < Reader.Frames.Num(); ++FrameIdx)
+	{
+		const FSLRawDataFrame& Frame = Reader.Frames[FrameIdx];
+		if (Frame.Poses.Num() != 1 || Frame.Poses[0].EntityIndex != 0 || Frame.Poses[0].Location.X != NumEarlyFrames + FrameIdx - 1)
+		{
+			AddError(FString::Printf(TEXT("Late frame %d does not hold only the X_1 pose in order"), FrameIdx));
+			break;
+		}
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
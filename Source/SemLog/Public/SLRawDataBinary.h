@@ -0,0 +1,180 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataFrame.h"
+
+/**
+* Binary raw data layout (little endian):
+*	Header:		uint32 Magic, uint32 Version
+*	Chunks:		uint8 ChunkType followed by the chunk data
+*		Entity:	int32 EntityIndex, FString UniqueName, int32 NumBones, FString BoneName[NumBones], float PositionPrecision
+*		Frame:	double Timestamp, uint8 Flags, int32 NumPoses, FSLRawDataPose[NumPoses]
+*		QuantizedFrame:	double Timestamp, uint8 Flags, int32 NumPoses, QuantizedPose[NumPoses]
+*		DeltaFrame:	double Timestamp, uint8 Flags, int32 NumPoses, DeltaPose[NumPoses]
+*	Pose:		int32 EntityIndex, int32 BoneIndex, float Location[3], float Rotation[4] (fixed size)
+*	QuantizedPose:	packed EntityIndex, packed BoneIndex + 1, then for entities with a precision
+*				zigzag packed Location[3] / precision and the smallest three rotation (6 bytes),
+*				otherwise float Location[3], float Rotation[4]
+*	DeltaPose:	packed EntityIndex, packed BoneIndex + 1, then for entities with a precision
+*				zigzag packed differences of Location[3] / precision and of Rotation[4] * 16383
+*				to the previous pose written for the same entity and bone (0 if none),
+*				otherwise float Location[3], float Rotation[4]
+* Entity chunks are always written before the first frame referencing them;
+* packed integers use FArchive::SerializeIntPacked. Version 3 adds the precision and the quantized frames,
+* version 4 the delta frames; the previous poses are cleared at keyframes and at frames with the reset flag.
+*/
+struct SEMLOG_API FSLRawDataBinary
+{
+	// File identifier ("SLRD")
+	static const uint32 Magic = 0x44524C53;
+
+	// Layout version
+	static const uint32 Version = 4;
+
+	// Size of the header in bytes
+	static const int32 HeaderSize = 8;
+
+	// Size of a pose record in bytes
+	static const int32 PoseSize = 36;
+
+	// Chunk types
+	static const uint8 EntityChunk = 0;
+	static const uint8 FrameChunk = 1;
+	static const uint8 QuantizedFrameChunk = 2;
+	static const uint8 DeltaFrameChunk = 3;
+
+	// Frame flags
+	static const uint8 KeyframeFlag = 1 << 0;
+	static const uint8 DeltaResetFlag = 1 << 1;
+};
+
+/**
+* Quantized pose, previous value of the delta encoding
+*/
+struct FSLRawDataQuantizedPose
+{
+	// Location in multiples of the precision
+	FIntVector Location = FIntVector(0, 0, 0);
+
+	// Rotation components (x, y, z, w) times 16383
+	int32 Rotation[4] = { 0, 0, 0, 0 };
+
+	// Get the previous pose of the bone (BoneIndex + 1), added if missing
+	static FSLRawDataQuantizedPose& Find(TArray<TArray<FSLRawDataQuantizedPose>>& Poses, int32 EntityIndex, int32 BoneIndex)
+	{
+		if (Poses.Num() <= EntityIndex)
+		{
+			Poses.SetNum(EntityIndex + 1);
+		}
+		TArray<FSLRawDataQuantizedPose>& EntityPoses = Poses[EntityIndex];
+		if (EntityPoses.Num() <= BoneIndex + 1)
+		{
+			EntityPoses.SetNum(BoneIndex + 2);
+		}
+		return EntityPoses[BoneIndex + 1];
+	}
+};
+
+/**
+* Writes raw data frames in the binary layout into a reusable buffer
+*/
+class SEMLOG_API FSLRawDataBinaryWriter
+{
+public:
+	// Constructor
+	FSLRawDataBinaryWriter();
+
+	// Append the file header
+	void WriteHeader();
+
+	// Append the new entities and the poses of the frame
+	void WriteFrame(const FSLRawDataFrame& Frame);
+
+	// Append entity chunks for the first Num entities
+	void WriteEntities(const TArray<FSLRawDataEntityDesc>& Entities, int32 Num);
+
+	// Get the written bytes
+	const TArray<uint8>& GetBuffer() const { return Buffer; };
+
+	// Clear the written bytes, keep the allocation
+	void Reset() { Buffer.Reset(); };
+
+	// Write quantized frames, poses of entities with a position precision are quantized
+	void SetQuantize(bool bInQuantize) { bQuantize = bInQuantize; };
+
+	// Write the quantized poses as differences to the previously written ones
+	void SetDeltaEncoding(bool bInDelta) { bDelta = bInDelta; };
+
+	// Make the next frame independent of the previous ones (e.g. at the start of a compressed block)
+	void ResetDeltas() { bDeltaResetPending = true; };
+
+private:
+	// Append an entity chunk
+	void WriteEntity(const FSLRawDataEntityDesc& Entity);
+
+	// Append the poses of the frame as a quantized frame chunk
+	void WriteQuantizedFrame(const FSLRawDataFrame& Frame);
+
+	// Append the poses of the frame as a delta frame chunk
+	void WriteDeltaFrame(const FSLRawDataFrame& Frame);
+
+	// Output buffer
+	TArray<uint8> Buffer;
+
+	// Write quantized frames
+	bool bQuantize;
+
+	// Position precision of the written entities, indexed by EntityIndex
+	TArray<float> PositionPrecisions;
+
+	// Write delta frames
+	bool bDelta;
+
+	// The next delta frame is written without previous poses
+	bool bDeltaResetPending;
+
+	// Previously written quantized poses, indexed by EntityIndex and BoneIndex + 1
+	TArray<TArray<FSLRawDataQuantizedPose>> PrevPoses;
+};
+
+/**
+* Reads binary raw data files
+*/
+class SEMLOG_API FSLRawDataBinaryReader
+{
+public:
+	// Load and parse the file, false if the file is missing or not a binary raw data file
+	bool LoadFromFile(const FString& Path);
+
+	// Parse the bytes of a binary raw data file
+	bool LoadFromBuffer(const TArray<uint8>& Bytes);
+
+	// Convert the loaded frames to the json layout of the raw data logger
+	bool WriteAsJson(const FString& Path) const;
+
+	// Convert a binary raw data file to the json layout of the raw data logger
+	static bool ConvertToJson(const FString& BinaryPath, const FString& JsonPath);
+
+	// Read and check the file header
+	static bool ReadHeader(FArchive& Reader, uint32& OutVersion);
+
+	// Read an entity chunk (after the chunk type)
+	static bool ReadEntityChunk(FArchive& Reader, uint32 Version, FSLRawDataEntityDesc& OutEntity);
+
+	// Store the entity in the table indexed by EntityIndex
+	static void AddEntity(TArray<FSLRawDataEntityDesc>& InOutEntities, const FSLRawDataEntityDesc& Entity);
+
+	// Read a frame chunk of any type (after the chunk type), delta frames use and update the previous poses
+	static bool ReadFrameChunk(FArchive& Reader, uint8 ChunkType, uint32 Version,
+		const TArray<FSLRawDataEntityDesc>& InEntities, TArray<TArray<FSLRawDataQuantizedPose>>& PrevPoses,
+		FSLRawDataFrame& OutFrame);
+
+	// Entities indexed by EntityIndex
+	TArray<FSLRawDataEntityDesc> Entities;
+
+	// Frames in the order they were written
+	TArray<FSLRawDataFrame> Frames;
+};
@@ -0,0 +1,37 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataJson.h"
+
+/**
+* Hands the UTF-8 json bytes of every batch to a callback, serializes the frames
+* which were not already encoded by the json encode sink
+*/
+class SEMLOG_API FSLRawDataBroadcastSink : public FSLRawDataSink
+{
+public:
+	// Constructor with the callback, called on the sink thread for every batch
+	FSLRawDataBroadcastSink(FSLRawDataJsonBytesCallback InOnJsonBytes);
+
+	// Destructor, serializes the queued frames
+	~FSLRawDataBroadcastSink();
+
+protected:
+	/** FSLRawDataSink interface */
+	virtual const TCHAR* GetThreadName() const override { return TEXT("SLRawDataBroadcastSink"); };
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) override;
+
+private:
+	// Called with the json bytes of the frames of a batch
+	FSLRawDataJsonBytesCallback OnJsonBytes;
+
+	// Json serialization buffer
+	FSLRawDataJsonWriter JsonWriter;
+
+	// Json bytes of the current batch
+	TArray<FSLRawDataJsonBytesRef> JsonBatch;
+};
@@ -0,0 +1,79 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataFrame.h"
+#ifdef WITH_MONGO
+#include "bson.h"
+#endif //WITH_MONGO
+
+#ifdef WITH_MONGO
+/**
+* Writes raw data frames as BSON documents directly from the captured poses into a reusable document,
+* same layout as the json frames (see FSLRawDataJsonWriter):
+*	{timestamp:t,[keyframe:true,]actors:[{name:n,pos:{x,y,z},rot:{w,x,y,z},bones:[..]}]}
+* (positions in meters, right handed; outside keyframes "bones" only holds the changed bones)
+*/
+class SEMLOG_API FSLRawDataBsonWriter
+{
+public:
+	// Constructor
+	FSLRawDataBsonWriter();
+
+	// Destructor
+	~FSLRawDataBsonWriter();
+
+	// Write the frame as a document (replaces the previous one), the names are read from the table (indexed by EntityIndex)
+	bool WriteFrame(const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities);
+
+	// Get the written document
+	const bson_t* GetDocument() const { return &Document; };
+
+	// Get the written document bytes
+	const uint8* GetData() const { return bson_get_data(&Document); };
+
+	// Get the number of written bytes
+	int32 GetSize() const { return (int32)Document.len; };
+
+	// Clear the written document, keep the allocation
+	void Reset() { bson_reinit(&Document); };
+
+private:
+	// Entity and bone names, UTF-8 encoded
+	struct FEncodedNames
+	{
+		// Set if the names were encoded
+		bool bIsSet = false;
+
+		// Entity name
+		TArray<ANSICHAR> Name;
+
+		// Bone names
+		TArray<TArray<ANSICHAR>> BoneNames;
+	};
+
+	// Get the encoded names of the entity, encode them on first use
+	const FEncodedNames& GetEncodedNames(const FSLRawDataEntityDesc& Entity);
+
+	// Get the key of the array element
+	FORCEINLINE const char* GetArrayKey(uint32 Index, int32& OutLength);
+
+	// Append the name, location and rotation of an entity or bone
+	FORCEINLINE static void AppendNameLocRot(bson_t* Parent, const TArray<ANSICHAR>& EncodedName,
+		const FVector& Location, const FQuat& Rotation);
+
+	// Encode the string as UTF-8
+	static void EncodeString(const FString& InString, TArray<ANSICHAR>& OutChars);
+
+	// Output document
+	bson_t Document;
+
+	// Buffer for the array keys past the precomputed ones
+	char KeyBuffer[16];
+
+	// Cached encoded names, indexed by EntityIndex
+	TArray<FEncodedNames> EncodedNamesCache;
+};
+#endif //WITH_MONGO
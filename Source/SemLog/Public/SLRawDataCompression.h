@@ -0,0 +1,187 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/**
+* Compressed raw data layout (little endian):
+*	Header:		uint32 Magic, uint32 Version, int32 StreamHeaderSize, uint8 StreamHeader[StreamHeaderSize]
+*	Blocks:		uint32 BlockMagic, int32 UncompressedSize, int32 CompressedSize, double FirstTimestamp,
+*				double LastTimestamp, uint8 Data[CompressedSize] (zlib)
+*	Index:		int32 NumBlocks, FSLRawDataBlockInfo[NumBlocks]
+*	Footer:		int64 IndexOffset, uint32 Magic
+* Blocks hold whole frames of the uncompressed stream (json or binary). The stream header
+* followed by any range of blocks is a valid uncompressed file, binary blocks start with
+* the entity chunks of all the entities known so far. The index and the footer are written
+* when the logger finishes, without them (e.g. after a crash) the index is rebuilt from the block headers.
+* (version 1 blocks only had the sizes in their header, those files need the footer)
+*/
+struct SEMLOG_API FSLRawDataCompressed
+{
+	// File identifier ("SLRZ")
+	static const uint32 Magic = 0x5A524C53;
+
+	// Block identifier ("SLRB")
+	static const uint32 BlockMagic = 0x42524C53;
+
+	// Layout version
+	static const uint32 Version = 2;
+
+	// Size of the footer in bytes
+	static const int32 FooterSize = 12;
+
+	// Size of the block header in bytes
+	static const int32 BlockHeaderSize = 28;
+
+	// Size of the version 1 block header in bytes
+	static const int32 BlockHeaderSizeV1 = 8;
+
+	// Default uncompressed size of a block
+	static const int32 DefaultBlockSize = 1 << 20;
+};
+
+/**
+* Seek entry of a compressed block
+*/
+struct FSLRawDataBlockInfo
+{
+	// Timestamp of the first frame in the block
+	double FirstTimestamp;
+
+	// Timestamp of the last frame in the block
+	double LastTimestamp;
+
+	// Offset of the block header in the file
+	int64 Offset;
+
+	// Size of the compressed data
+	int32 CompressedSize;
+
+	// Size of the data once uncompressed
+	int32 UncompressedSize;
+
+	// Serialize
+	friend FArchive& operator<<(FArchive& Ar, FSLRawDataBlockInfo& Info)
+	{
+		Ar << Info.FirstTimestamp << Info.LastTimestamp << Info.Offset << Info.CompressedSize << Info.UncompressedSize;
+		return Ar;
+	}
+};
+
+/**
+* Groups serialized frames into blocks, compresses them and keeps the seek index
+*/
+class SEMLOG_API FSLRawDataCompressedWriter
+{
+public:
+	// Constructor
+	FSLRawDataCompressedWriter();
+
+	// Start a new file, the stream header (e.g. the binary header) is kept uncompressed in the file header
+	void Init(const TArray<uint8>& StreamHeader, int32 InBlockSize = FSLRawDataCompressed::DefaultBlockSize);
+
+	// Append the file header to the output
+	void WriteHeader(TArray<uint8>& OutBytes);
+
+	// Add a serialized frame, the block is compressed and appended to the output once full (returns true)
+	bool AddFrame(const TArray<uint8>& FrameBytes, double Timestamp, TArray<uint8>& OutBytes);
+
+	// Compress the remaining frames and append the index and the footer to the output
+	void Finish(TArray<uint8>& OutBytes);
+
+	// Check if the next frame starts a new block
+	bool IsBlockEmpty() const { return Block.Num() == 0; };
+
+private:
+	// Compress the current block and append it to the output
+	void CompressBlock(TArray<uint8>& OutBytes);
+
+	// Uncompressed size after which a block is compressed
+	int32 BlockSize;
+
+	// Uncompressed frames of the current block
+	TArray<uint8> Block;
+
+	// Timestamps of the first and last frame in the current block
+	double BlockFirstTimestamp;
+	double BlockLastTimestamp;
+
+	// File header
+	TArray<uint8> Header;
+
+	// Size of the file so far
+	int64 FileSize;
+
+	// Seek index
+	TArray<FSLRawDataBlockInfo> Index;
+};
+
+/**
+* Reads time ranges of compressed raw data files, only the needed blocks are decompressed
+*/
+class SEMLOG_API FSLRawDataCompressedReader
+{
+public:
+	// Constructor
+	FSLRawDataCompressedReader();
+
+	// Destructor, closes the file
+	~FSLRawDataCompressedReader();
+
+	// Open the file and read the seek index, rebuilt from the blocks if the file was not finished
+	// (false if it is not a compressed raw data file)
+	bool Open(const FString& Path);
+
+	// Close the file
+	void Close();
+
+	// Decompress the blocks overlapping the time range, prefixed by the stream header
+	bool ReadRange(double StartTime, double EndTime, TArray<uint8>& OutBytes);
+
+	// Decompress a block and append it to the output
+	bool ReadBlock(int32 BlockIndex, TArray<uint8>& OutBytes);
+
+	// Get the header of the uncompressed stream
+	const TArray<uint8>& GetStreamHeader() const { return StreamHeader; };
+
+	// Get the seek index
+	const TArray<FSLRawDataBlockInfo>& GetIndex() const { return Index; };
+
+	// Check if the index was rebuilt from the blocks (the file has no footer)
+	bool IsRecovered() const { return bRecovered; };
+
+	// Decompress the whole file
+	static bool Decompress(const FString& CompressedPath, const FString& OutPath);
+
+private:
+	// Read the index written at the end of the file
+	bool ReadIndex();
+
+	// Rebuild the index from the block headers, up to the first incomplete block
+	bool RecoverIndex(int64 FirstBlockOffset);
+
+	// Read bytes at the offset
+	bool ReadAt(int64 Offset, int32 Size, TArray<uint8>& OutBytes);
+
+	// Opened file
+	IFileHandle* FileHandle;
+
+	// Header of the uncompressed stream
+	TArray<uint8> StreamHeader;
+
+	// Seek index
+	TArray<FSLRawDataBlockInfo> Index;
+
+	// Size of the block headers of the file version
+	int32 BlockHeaderSize;
+
+	// Set if the index was rebuilt from the blocks
+	bool bRecovered;
+
+	// Compressed block buffer
+	TArray<uint8> CompressedBuffer;
+};
@@ -0,0 +1,159 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USceneComponent;
+class USkeletalMeshComponent;
+
+/**
+* Cached bone indexes and bone poses of a skeletal entity at its last logged update
+*/
+struct FSLRawDataBoneStates
+{
+	// Indexes of the logged bones in the pose transforms, resolved once at registration
+	TArray<int32> BoneIndices;
+
+	// Bone locations
+	TArray<FVector> PrevLocations;
+
+	// Bone rotations
+	TArray<FQuat> PrevRotations;
+};
+
+/**
+* Dynamic entities of the raw data logger stored as parallel arrays,
+* the per update change check only walks the pose and threshold arrays
+*/
+struct SEMLOG_API FSLRawDataEntityRegistry
+{
+	// Add entity, the key is the object used for removal (actor or component);
+	// the entity counts as never logged, so it is written at the next update
+	void Add(UObject* Key, USceneComponent* Component, USkeletalMeshComponent* SkelMesh,
+		int32 EntityIndex, float SquaredDistanceThreshold, float MinQuatDot, float SamplingPeriod = 0.f);
+
+	// Remove entity by swapping it with the last one
+	bool Remove(UObject* Key);
+
+	// Check if the entity is registered
+	bool Contains(UObject* Key) const { return KeyToSlot.Contains(Key); };
+
+	// Get the slot of the entity index (INDEX_NONE if not registered)
+	int32 GetSlot(int32 EntityIndex) const
+	{
+		const int32* Slot = EntityIndexToSlot.Find(EntityIndex);
+		return Slot ? *Slot : INDEX_NONE;
+	};
+
+	// Number of registered entities
+	int32 Num() const { return Components.Num(); };
+
+	// Read the current poses of all the entities into CurrLocations and CurrRotations
+	void UpdateCurrPoses();
+
+	// Read the current poses of the entities with their bit set in the mask
+	void UpdateCurrPoses(const TArray<uint32>& SlotMask);
+
+	// Keep the poses of the previous tick and read the ones of the current tick (fixed timestep sampling)
+	void ReadTickPoses();
+
+	// Set the current poses between the previous and the current tick poses (0 = previous, 1 = current),
+	// only for the entities with their bit set in the mask if given
+	void InterpolateCurrPoses(float Alpha, const TArray<uint32>* SlotMask = nullptr);
+
+	// Get the mask of the skeletal entities (one bit per slot)
+	const TArray<uint32>& GetSkeletalMask();
+
+	// Resolve the bone names of the skeletal mesh (GetBoneNames order) to indexes in its pose transforms
+	static void ResolveBoneIndices(USkeletalMeshComponent* SkelMesh, TArray<int32>& OutBoneIndices);
+
+	// Read the world poses of the bones in one pass over the component space transforms
+	static void ReadBonePoses(USkeletalMeshComponent* SkelMesh, const TArray<int32>& BoneIndices,
+		TArray<FVector>& OutLocations, TArray<FQuat>& OutRotations);
+
+	// Read the world poses of the bones relative to the given skeletal mesh component transform
+	static void ReadBonePoses(USkeletalMeshComponent* SkelMesh, const TArray<int32>& BoneIndices,
+		const FTransform& ComponentToWorld, TArray<FVector>& OutLocations, TArray<FQuat>& OutRotations);
+
+	// Mark the current pose of the entity as the last logged one
+	FORCEINLINE void CommitPose(int32 Slot)
+	{
+		PrevLocations[Slot] = CurrLocations[Slot];
+		PrevRotations[Slot] = CurrRotations[Slot];
+	}
+
+	// Scene component giving the pose (root component for actors)
+	TArray<USceneComponent*> Components;
+
+	// Skeletal mesh for entities with bones (nullptr otherwise)
+	TArray<USkeletalMeshComponent*> SkelMeshes;
+
+	// Index of the entity in the logger (gives the name)
+	TArray<int32> EntityIndices;
+
+	// Locations at the last logged update
+	TArray<FVector> PrevLocations;
+
+	// Locations at the current update
+	TArray<FVector> CurrLocations;
+
+	// Rotations at the last logged update
+	TArray<FQuat> PrevRotations;
+
+	// Rotations at the current update
+	TArray<FQuat> CurrRotations;
+
+	// Locations read at the previous tick (fixed timestep sampling)
+	TArray<FVector> LastTickLocations;
+
+	// Locations read at the current tick (fixed timestep sampling)
+	TArray<FVector> TickLocations;
+
+	// Rotations read at the previous tick (fixed timestep sampling)
+	TArray<FQuat> LastTickRotations;
+
+	// Rotations read at the current tick (fixed timestep sampling)
+	TArray<FQuat> TickRotations;
+
+	// Squared distance (cm) the entity has to move to be logged
+	TArray<float> SquaredDistanceThresholds;
+
+	// The entity is logged if the |dot| of its current and previous rotation drops below this
+	TArray<float> MinQuatDots;
+
+	// Bone poses at the last logged update (empty for entities without bones)
+	TArray<FSLRawDataBoneStates> BoneStates;
+
+	// Minimum time between two samples of the entity (0 for every update)
+	TArray<float> SamplingPeriods;
+
+	// Time until the next sample (differs from the minimum in adaptive mode)
+	TArray<float> CurrSamplingPeriods;
+
+	// Time of the last sample
+	TArray<float> LastSampleTimes;
+
+	// Location at the last sample (logged or not)
+	TArray<FVector> LastSampleLocations;
+
+	// Rotation at the last sample (logged or not)
+	TArray<FQuat> LastSampleRotations;
+
+private:
+	// Keys in slot order, used to fix the map after a swap
+	TArray<UObject*> Keys;
+
+	// Key to slot in the arrays
+	TMap<UObject*, int32> KeyToSlot;
+
+	// Entity index to slot in the arrays (used by the sampling schedule)
+	TMap<int32, int32> EntityIndexToSlot;
+
+	// Bits of the slots with skeletal meshes
+	TArray<uint32> SkeletalMask;
+
+	// Set when entities were added or removed since the skeletal mask was built
+	bool bSkeletalMaskDirty = true;
+};
@@ -0,0 +1,215 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataFrame.h"
+#include "SLRawDataBinary.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class FJsonObject;
+
+/**
+* Seek entry of a frame in an episode file
+*/
+struct FSLRawDataFrameIndexEntry
+{
+	// Timestamp of the frame
+	double Timestamp;
+
+	// Offset of the frame in the file
+	int64 Offset;
+
+	// Size of the frame in bytes
+	int32 Size;
+
+	// Index of the last keyframe at or before this frame (delta decoding starts there)
+	int32 KeyframeIndex;
+
+	// Serialize
+	friend FArchive& operator<<(FArchive& Ar, FSLRawDataFrameIndexEntry& Entry)
+	{
+		Ar << Entry.Timestamp << Entry.Offset << Entry.Size << Entry.KeyframeIndex;
+		return Ar;
+	}
+};
+
+/**
+* Frames holding the poses of an entity and of its bones, sparse: per checkpoint interval of the episode
+* only the last frame holding the pose is kept, and only for the intervals in which the pose was written
+*/
+struct FSLRawDataPoseCheckpoints
+{
+	// Per pose (entity at 0, bone B at B + 1) the last frame of the intervals holding it, in increasing order
+	TArray<TArray<int32>> LastFrames;
+
+	// Serialize
+	friend FArchive& operator<<(FArchive& Ar, FSLRawDataPoseCheckpoints& Checkpoints)
+	{
+		Ar << Checkpoints.LastFrames;
+		return Ar;
+	}
+};
+
+/**
+* Random access to raw data episodes (json or binary, optionally framed); the file is memory mapped and a
+* timestamp to offset index is built on the first open and kept next to the file (<file>.idx), together with
+* the entity names and the pose checkpoints. Frames are found by binary search, poses through the checkpoints.
+*/
+class SEMLOG_API FSLRawDataEpisodeReader
+{
+public:
+	// Constructor
+	FSLRawDataEpisodeReader();
+
+	// Destructor, unmaps the file
+	~FSLRawDataEpisodeReader();
+
+	// Map the file and build or load its index
+	bool Open(const FString& Path, bool bSaveIndex = true);
+
+	// Unmap the file
+	void Close();
+
+	// Check if a file is opened
+	bool IsOpen() const { return Data != nullptr; };
+
+	// Number of indexed frames
+	int32 NumFrames() const { return Index.Num(); };
+
+	// Get the frame index
+	const TArray<FSLRawDataFrameIndexEntry>& GetIndex() const { return Index; };
+
+	// Get the entities of the episode, indexed by EntityIndex
+	const TArray<FSLRawDataEntityDesc>& GetEntities() const { return Entities; };
+
+	// Get the index of the entity (INDEX_NONE if unknown)
+	int32 FindEntity(const FString& UniqueName) const;
+
+	// Index of the last frame at or before the time (INDEX_NONE if the time is before the first frame)
+	int32 FindFrame(double Time) const;
+
+	// Read the frame, poses reference the entities of the reader
+	bool ReadFrame(int32 FrameIndex, FSLRawDataFrame& OutFrame);
+
+	// Read all the frames with timestamps in [StartTime, EndTime]
+	bool ReadFrames(double StartTime, double EndTime, TArray<FSLRawDataFrame>& OutFrames);
+
+	// Get the last written pose of the entity (or of one of its bones) at or before the time; at most the
+	// CheckpointInterval frames before the time are searched, an older pose is read from the frame found in its
+	// checkpoints (static entities included); delta encoded binary frames are decoded forwards from their keyframe
+	bool GetPose(const FString& UniqueName, double Time, FSLRawDataPose& OutPose, const FString& BoneName = FString());
+
+	// Check if the file is json
+	bool IsJson() const { return Data != nullptr && !bIsBinary; };
+
+	// Frames per pose checkpoint interval
+	static const int32 CheckpointInterval = 256;
+
+	// Get the bytes of the frame in the mapped file (json object or binary chunk)
+	bool GetFrameBytes(int32 FrameIndex, const uint8*& OutBytes, int32& OutSize) const;
+
+	// Read the pose of a json actor or bone object (converted back to engine units)
+	static bool ReadJsonPose(const TSharedPtr<FJsonObject>& Object, FVector& OutLocation, FQuat& OutRotation);
+
+private:
+	// Build the index by scanning the file
+	bool BuildIndex();
+
+	// Build the index of a json file (concatenated objects)
+	bool BuildJsonIndex();
+
+	// Add the json frame to the index
+	bool IndexJsonFrame(int64 Start, int64 Size, int32& InOutLastKeyframe);
+
+	// Build the index of a binary file (chunks), reads the entity chunks
+	bool BuildBinaryIndex();
+
+	// Add the binary chunks of the range to the index, optionally leaving out the delta frames before the next keyframe
+	bool IndexBinaryChunks(int64 Begin, int64 End, TArray<TArray<FSLRawDataQuantizedPose>>& ScanPoses,
+		int32& InOutLastKeyframe, bool bSkipUntilKeyframe);
+
+	// Build the index of a framed file (records), corrupted or truncated records are skipped
+	bool BuildFramedIndex();
+
+	// Read the names of the indexed json frames on all cores, adds the entities and the pose checkpoints
+	bool BuildJsonCheckpoints();
+
+	// Add the poses of the frame to the checkpoints
+	void AddPoseCheckpoints(int32 FrameIndex, const FSLRawDataFrame& Frame);
+
+	// Add the pose to the checkpoints
+	void AddPoseCheckpoint(int32 FrameIndex, int32 EntityIndex, int32 BoneIndex);
+
+	// Load the index saved next to the file, false if missing or outdated
+	bool LoadIndex(const FString& IndexPath);
+
+	// Save the index next to the file
+	bool SaveIndex(const FString& IndexPath) const;
+
+	// Parse the frame as json, unknown names are added to the entities
+	bool ReadJsonFrame(int32 FrameIndex, FSLRawDataFrame& OutFrame);
+
+	// Decode the binary frame, delta frames are decoded from their keyframe if needed
+	bool ReadBinaryFrame(int32 FrameIndex, FSLRawDataFrame& OutFrame);
+
+	// Get the pose of the entity (or of its bone) in the frame, the last one if written more than once
+	bool FindPoseInFrame(const FSLRawDataFrame& Frame, const FString& UniqueName, const FString& BoneName,
+		FSLRawDataPose& OutPose) const;
+
+	// Get the index of the entity, added if unknown (json)
+	int32 FindOrAddEntity(const FString& UniqueName);
+
+	// Get the index of the bone of the entity, added if unknown (json)
+	int32 FindOrAddBone(int32 EntityIndex, const FString& BoneName);
+
+	// Mapped file
+	IMappedFileHandle* MappedHandle;
+
+	// Mapped region of the whole file
+	IMappedFileRegion* MappedRegion;
+
+	// File content when mapping is not supported
+	TArray<uint8> LoadedBytes;
+
+	// File content
+	const uint8* Data;
+
+	// Size of the file
+	int64 DataSize;
+
+	// Records with checksums
+	bool bIsFramed;
+
+	// Binary or json file
+	bool bIsBinary;
+
+	// Binary layout version
+	uint32 BinaryVersion;
+
+	// Frame index sorted by time
+	TArray<FSLRawDataFrameIndexEntry> Index;
+
+	// Offsets of the binary entity chunks
+	TArray<int64> EntityChunkOffsets;
+
+	// Entities, indexed by EntityIndex
+	TArray<FSLRawDataEntityDesc> Entities;
+
+	// Entity name to index
+	TMap<FString, int32> EntityNameToIndex;
+
+	// Bone name to index per entity (json)
+	TArray<TMap<FString, int32>> BoneNameToIndex;
+
+	// Pose checkpoints, indexed by EntityIndex
+	TArray<FSLRawDataPoseCheckpoints> PoseCheckpoints;
+
+	// Previous poses of the delta frames
+	TArray<TArray<FSLRawDataQuantizedPose>> PrevPoses;
+
+	// Last decoded binary frame, the next one can continue the delta decoding
+	int32 LastDecodedFrame;
+};
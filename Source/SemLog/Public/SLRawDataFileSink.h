@@ -0,0 +1,100 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataBinary.h"
+#include "SLRawDataJson.h"
+#include "SLRawDataCompression.h"
+#include "SLRawDataFraming.h"
+#include "SLRawDataFileSink.generated.h"
+
+class IFileHandle;
+
+/**
+* Raw data file format
+*/
+UENUM()
+enum class ESLRawDataFormat : uint8
+{
+	Json			UMETA(DisplayName = "Json"),
+	Binary			UMETA(DisplayName = "Binary")
+};
+
+/**
+* Serializes the frames and appends them to the episode file (json or binary),
+* optionally in compressed blocks (.slz) or in records with checksums (.slf)
+*/
+class SEMLOG_API FSLRawDataFileSink : public FSLRawDataSink
+{
+public:
+	// Constructor
+	FSLRawDataFileSink();
+
+	// Destructor, writes the queued frames and closes the file
+	~FSLRawDataFileSink();
+
+	// Create the file (call before Start)
+	bool Open(const FString& InFilePath, ESLRawDataFormat InFormat, bool bInCompress, bool bInFramed);
+
+	// Quantize the binary poses of the entities with a position precision, optionally as deltas (call before Start)
+	void SetQuantization(bool bQuantize, bool bDeltaEncoding);
+
+	// Path of the file
+	const FString& GetFilePath() const { return FilePath; };
+
+	// File format
+	ESLRawDataFormat GetFormat() const { return Format; };
+
+protected:
+	/** FSLRawDataSink interface */
+	virtual const TCHAR* GetThreadName() const override { return TEXT("SLRawDataFileSink"); };
+	virtual void OnStart() override;
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) override;
+	virtual void OnFinish() override;
+
+private:
+	// Add the serialized frame to the file, as a record or through the compression if enabled
+	bool WriteFrameContent(const TArray<uint8>& Bytes, double Timestamp);
+
+	// Append bytes to the file
+	bool WriteToFile(const TArray<uint8>& Bytes);
+
+	// Close the file
+	void Close();
+
+	// Output file
+	IFileHandle* FileHandle;
+
+	// Path of the file
+	FString FilePath;
+
+	// File format
+	ESLRawDataFormat Format;
+
+	// Compress the file in seekable blocks
+	bool bCompress;
+
+	// Write every frame as a record with its size and checksum
+	bool bFramed;
+
+	// Binary serialization buffer
+	FSLRawDataBinaryWriter BinaryWriter;
+
+	// Json serialization buffer
+	FSLRawDataJsonWriter JsonWriter;
+
+	// Block compression and seek index
+	FSLRawDataCompressedWriter CompressedWriter;
+
+	// Compressed output buffer
+	TArray<uint8> CompressedBytes;
+
+	// Framed output buffer
+	TArray<uint8> FramedBytes;
+
+	// Number of entities of the frames written so far
+	int32 NumWrittenEntities;
+};
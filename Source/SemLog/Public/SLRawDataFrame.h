@@ -0,0 +1,100 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Pose of a logged entity, or of one of its bones
+* (values are stored as read from the engine: cm, left handed)
+*/
+struct FSLRawDataPose
+{
+	// Default constructor
+	FSLRawDataPose()
+	{};
+
+	// Constructor with indexes and transform
+	FSLRawDataPose(int32 InEntityIndex, int32 InBoneIndex, const FVector& InLocation, const FQuat& InRotation)
+		: EntityIndex(InEntityIndex), BoneIndex(InBoneIndex), Location(InLocation), Rotation(InRotation)
+	{};
+
+	// Index of the entity in the logger
+	int32 EntityIndex;
+
+	// Index of the bone in the entity's bone names (INDEX_NONE for the entity itself)
+	int32 BoneIndex;
+
+	// Location
+	FVector Location;
+
+	// Rotation
+	FQuat Rotation;
+};
+
+/**
+* Description of a logged entity, written once when the entity is first seen
+*/
+struct FSLRawDataEntityDesc
+{
+	// Default constructor
+	FSLRawDataEntityDesc() : PositionPrecision(0.f)
+	{};
+
+	// Constructor with index and unique name
+	FSLRawDataEntityDesc(int32 InEntityIndex, const FString& InUniqueName)
+		: EntityIndex(InEntityIndex), UniqueName(InUniqueName), PositionPrecision(0.f)
+	{};
+
+	// Index of the entity in the logger
+	int32 EntityIndex;
+
+	// Unique name of the entity (Class_Id)
+	FString UniqueName;
+
+	// Names of the bones (skeletal entities only)
+	TArray<FString> BoneNames;
+
+	// Precision (cm) of the quantized positions, 0 for full precision poses
+	float PositionPrecision;
+};
+
+/**
+* Raw data of one logger update, the entity pose is followed by the poses of its (changed) bones
+*/
+struct FSLRawDataFrame
+{
+	// Default constructor
+	FSLRawDataFrame() : Timestamp(0.f), bIsKeyframe(false)
+	{};
+
+	// Clear the data, keep the allocations
+	void Reset()
+	{
+		Timestamp = 0.f;
+		bIsKeyframe = false;
+		NewEntities.Reset();
+		Poses.Reset();
+		JsonBytes.Reset();
+	}
+
+	// Timestamp of the frame
+	float Timestamp;
+
+	// All dynamic entities are in the frame with all their bones,
+	// otherwise only the entities and bones which changed since they were last written
+	bool bIsKeyframe;
+
+	// Entities seen for the first time in this frame
+	TArray<FSLRawDataEntityDesc> NewEntities;
+
+	// Entity and bone poses
+	TArray<FSLRawDataPose> Poses;
+
+	// Json serialization of the frame, set once by the json encode sink before the json outputs get the frame
+	mutable TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> JsonBytes;
+};
+
+/** Read-only reference to a captured frame, keeps the frame from being reused while held */
+typedef TSharedRef<const FSLRawDataFrame, ESPMode::ThreadSafe> FSLRawDataFrameRef;
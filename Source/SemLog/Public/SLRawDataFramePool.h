@@ -0,0 +1,48 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "SLRawDataFrame.h"
+
+/**
+* Pool of reusable frames, frames are handed out as thread safe shared references
+* and go back to the pool when the last reference is released (the pool lives as long as its frames),
+* it allocates up to a maximum number of frames
+*/
+class SEMLOG_API FSLRawDataFramePool : public TSharedFromThis<FSLRawDataFramePool, ESPMode::ThreadSafe>
+{
+public:
+	// Create a pool with preallocated frames
+	static TSharedRef<FSLRawDataFramePool, ESPMode::ThreadSafe> Create(int32 NumFrames, int32 InNumPoses);
+
+	// Destructor, deletes the pooled frames
+	~FSLRawDataFramePool();
+
+	// Set the most frames allocated by the pool (0 for no limit)
+	void SetMaxFrames(int32 InMaxFrames) { MaxFrames = InMaxFrames; };
+
+	// Get a cleared frame, invalid if all the allowed frames are in use (acquire from one thread only, release from any)
+	TSharedPtr<FSLRawDataFrame, ESPMode::ThreadSafe> Acquire();
+
+	// Number of frames allocated by the pool
+	int32 GetNumFrames() const { return NumFrames; };
+
+private:
+	// Constructor
+	FSLRawDataFramePool(int32 InNumPoses);
+
+	// Frames free for reuse
+	TQueue<FSLRawDataFrame*, EQueueMode::Mpsc> FreeFrames;
+
+	// Number of poses reserved in each new frame
+	int32 NumPoses;
+
+	// Frames allocated (changed on the acquiring thread only)
+	int32 NumFrames;
+
+	// Most frames allocated, 0 for no limit
+	int32 MaxFrames;
+};
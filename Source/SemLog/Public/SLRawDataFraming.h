@@ -0,0 +1,47 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Framed raw data layout (little endian):
+*	Header:		uint32 Magic, uint32 Version
+*	Records:	uint32 RecordMagic, int32 PayloadSize, uint32 PayloadCrc, uint8 Payload[PayloadSize]
+* Every record holds one frame of the stream (json or binary, the binary header is the first record).
+* Record boundaries are found from any offset by looking for the record magic and checking the size
+* and checksum, so files can be split for parallel loading and corrupted or truncated records are skipped.
+*/
+struct SEMLOG_API FSLRawDataFramed
+{
+	// File identifier ("SLRF")
+	static const uint32 Magic = 0x46524C53;
+
+	// Layout version
+	static const uint32 Version = 1;
+
+	// Size of the file header in bytes
+	static const int32 HeaderSize = 8;
+
+	// Record identifier ("SLRC")
+	static const uint32 RecordMagic = 0x43524C53;
+
+	// Size of the record header in bytes
+	static const int32 RecordHeaderSize = 12;
+
+	// Write the file header
+	static void WriteHeader(TArray<uint8>& OutBytes);
+
+	// Append the payload as a record
+	static void WriteRecord(const uint8* Payload, int32 PayloadSize, TArray<uint8>& OutBytes);
+
+	// Check if the data starts with the file header
+	static bool HasHeader(const uint8* Data, int64 DataSize);
+
+	// Check if a valid record starts at the offset, outputs the payload range
+	static bool ReadRecord(const uint8* Data, int64 DataSize, int64 Offset, int64& OutPayloadOffset, int32& OutPayloadSize);
+
+	// Offset of the first valid record at or after the offset (DataSize if none)
+	static int64 FindRecord(const uint8* Data, int64 DataSize, int64 Offset);
+};
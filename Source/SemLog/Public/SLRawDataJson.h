@@ -0,0 +1,91 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataFrame.h"
+
+/** Json bytes of a frame, shared between the file output and the broadcast */
+typedef TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> FSLRawDataJsonBytesRef;
+
+/** Called with the json bytes of consecutive frames, the callee can take the array */
+typedef TFunction<void(TArray<FSLRawDataJsonBytesRef>&)> FSLRawDataJsonBytesCallback;
+
+/**
+* Writes raw data frames as json (UTF-8) directly into a reusable buffer,
+* without building intermediate json objects; layout:
+*	{"timestamp":t,["keyframe":true,]"actors":[{"name":n,"pos":{"x","y","z"},"rot":{"w","x","y","z"},"bones":[..]}]}
+* (positions in meters, right handed; outside keyframes "bones" only holds the changed bones;
+* entities with a position precision are written with the digits of the precision and 5 rotation decimals)
+*/
+class SEMLOG_API FSLRawDataJsonWriter
+{
+public:
+	// Constructor
+	FSLRawDataJsonWriter();
+
+	// Append the frame as a json object, the names are read from the table (indexed by EntityIndex)
+	bool WriteFrame(const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities);
+
+	// Get the written bytes
+	const TArray<uint8>& GetBuffer() const { return Buffer; };
+
+	// Clear the written bytes, keep the allocation
+	void Reset() { Buffer.Reset(); };
+
+	// Hand over the written bytes as a shared buffer, the next frame is written into a new buffer of the same size
+	FSLRawDataJsonBytesRef ReleaseBuffer();
+
+private:
+	// Entity and bone names, already escaped, quoted and UTF-8 encoded
+	struct FEncodedNames
+	{
+		// Set if the names were encoded
+		bool bIsSet = false;
+
+		// Entity name
+		TArray<uint8> Name;
+
+		// Bone names
+		TArray<TArray<uint8>> BoneNames;
+
+		// Decimals of the positions in meters (INDEX_NONE for full precision)
+		int32 PositionDecimals = INDEX_NONE;
+	};
+
+	// Get the encoded names of the entity, encode them on first use
+	const FEncodedNames& GetEncodedNames(const FSLRawDataEntityDesc& Entity);
+
+	// Write the name, location and rotation of an entity or bone
+	FORCEINLINE void WriteNameLocRot(const TArray<uint8>& EncodedName, const FVector& Location, const FQuat& Rotation,
+		int32 PositionDecimals);
+
+	// Close the actor object (and its bones array)
+	FORCEINLINE void WriteActorEnd(bool bHasBones);
+
+	// Write number
+	FORCEINLINE void WriteNumber(float Value);
+
+	// Write number with a fixed number of decimals (full precision if negative)
+	FORCEINLINE void WriteFixed(float Value, int32 Decimals);
+
+	// Write raw characters
+	FORCEINLINE void WriteRaw(const ANSICHAR* Chars, int32 Num);
+
+	// Write string literal
+	template<int32 N>
+	FORCEINLINE void WriteLiteral(const ANSICHAR(&Literal)[N])
+	{
+		WriteRaw(Literal, N - 1);
+	}
+
+	// Encode the string as a quoted json string
+	static void EncodeString(const FString& InString, TArray<uint8>& OutBytes);
+
+	// Output buffer
+	TArray<uint8> Buffer;
+
+	// Cached encoded names, indexed by EntityIndex
+	TArray<FEncodedNames> EncodedNamesCache;
+};
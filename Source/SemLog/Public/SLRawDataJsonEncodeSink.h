@@ -0,0 +1,43 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataJson.h"
+
+/**
+* Serializes every frame once as json, attaches the bytes to the frame and passes it on to the target sinks,
+* which write the bytes out on their own threads (e.g. the json file and the broadcast);
+* the targets are started, fed and finished by the thread of this sink
+*/
+class SEMLOG_API FSLRawDataJsonEncodeSink : public FSLRawDataSink
+{
+public:
+	// Constructor
+	FSLRawDataJsonEncodeSink();
+
+	// Destructor, encodes the queued frames and finishes the targets
+	~FSLRawDataJsonEncodeSink();
+
+	// Pass the encoded frames on to the sink, not added to the logger itself (call before Start)
+	void AddTarget(const TSharedRef<FSLRawDataSink>& Target);
+
+	/** FSLRawDataSink interface */
+	virtual int32 GetMaxHeldFrames() const override;
+
+protected:
+	/** FSLRawDataSink interface */
+	virtual const TCHAR* GetThreadName() const override { return TEXT("SLRawDataJsonEncodeSink"); };
+	virtual void OnStart() override;
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) override;
+	virtual void OnFinish() override;
+
+private:
+	// Sinks consuming the encoded frames
+	TArray<TSharedRef<FSLRawDataSink>> Targets;
+
+	// Json serialization buffer
+	FSLRawDataJsonWriter JsonWriter;
+};
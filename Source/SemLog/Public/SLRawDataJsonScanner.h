@@ -0,0 +1,50 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataEpisodeReader.h"
+
+/**
+* Finds the frames (top level objects) of json raw data files on all cores, the file is split in chunks,
+* the parser state at each chunk start (string, escape, depth) is resolved from the chunk transitions,
+* then the chunks are scanned again in parallel for the frame boundaries; works on compact and pretty printed files
+*/
+struct SEMLOG_API FSLRawDataJsonScanner
+{
+	// Find the frames, truncated or unreadable frames are left out (NumChunks 0 picks the number from the size)
+	static bool FindFrames(const uint8* Data, int64 DataSize, TArray<FSLRawDataFrameIndexEntry>& OutIndex, int32 NumChunks = 0);
+
+	// Read the timestamp and keyframe flag at the start of the frame
+	static bool ReadFrameHeader(const uint8* Data, int64 Size, double& OutTimestamp, bool& bOutIsKeyframe);
+
+private:
+	// Parser state between two bytes
+	enum EState : uint8
+	{
+		Outside = 0,
+		InString = 1,
+		InStringEscaped = 2,
+		NumStates = 3
+	};
+
+	// Scan the range from the state, outputs the end state and the depth change
+	static void ScanTransition(const uint8* Data, int64 Begin, int64 End, EState StartState, EState& OutEndState, int64& OutDepthDelta);
+
+	// Frames of a chunk
+	struct FChunkFrames
+	{
+		// End of a frame started in a previous chunk (INDEX_NONE if none)
+		int64 OrphanEnd = INDEX_NONE;
+
+		// Start of a frame not ended in the chunk (INDEX_NONE if none)
+		int64 OpenStart = INDEX_NONE;
+
+		// Frames started and ended in the chunk (start, end)
+		TArray<TPair<int64, int64>> Frames;
+	};
+
+	// Scan the range with the known start state and depth for the frame boundaries
+	static void ScanFrames(const uint8* Data, int64 Begin, int64 End, EState StartState, int64 StartDepth, FChunkFrames& OutFrames);
+};
@@ -5,40 +5,32 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
-#include "JsonObject.h"
+#include "SLRawDataFrame.h"
+#include "SLRawDataFramePool.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataFileSink.h"
+#include "SLRawDataMongoSink.h"
+#include "SLRawDataStreamSink.h"
+#include "SLRawDataSharedMemorySink.h"
+#include "SLRawDataEntityRegistry.h"
+#include "SLRawDataScheduler.h"
 #include "SLRawDataLogger.generated.h"
 
+class USkeletalMeshComponent;
+
 /** Delegate type for new raw data */
 DECLARE_MULTICAST_DELEGATE_OneParam(FSLOnNewRawDataSignature, const FString&);
 
-/**
-* Unique name and location of the entities to be logged by the raw data logger
-* location is used for calculating the distance between then and now
-*/
-USTRUCT()
-struct FUniqueNameAndLocation
-{
-	GENERATED_USTRUCT_BODY()
-	
-	// Default constructor
-	FUniqueNameAndLocation()
-	{};
-
-	// Constructor with Id and Location
-	FUniqueNameAndLocation(FString InUniqueName, FVector InLocation = FVector(-INFINITY))
-		: UniqueName(InUniqueName), Location(InLocation)
-	{};
+/** Delegate type for new raw data as json UTF-8 bytes */
+DECLARE_MULTICAST_DELEGATE_OneParam(FSLOnNewRawDataBytesSignature, const TArray<uint8>&);
 
-	// Unique name of the entity
-	FString UniqueName;
-
-	// Previous location 
-	FVector Location;
-};
+/** Delegate type for new raw data frames (the frame and the entity table indexed by the pose entity indices) */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FSLOnNewRawDataFrameSignature, const FSLRawDataFrameRef&, const TArray<FSLRawDataEntityDesc>&);
 
 /**
  * Semantic logger of raw data 
- * (location, rotation of semantically annotated entities in the world)
+ * (location, rotation of semantically annotated entities in the world),
+ * the captured frames are written out by the sinks, each on its own thread
  */
 UCLASS()
 class SEMLOG_API USLRawDataLogger : public UObject
@@ -54,15 +46,55 @@ public:
 
 	// Init logger
 	UFUNCTION(BlueprintCallable, Category = SL)
-	bool Init(UWorld* InWorld, const float DistanceThreshold = 0.1f);
+	bool Init(UWorld* InWorld, const float DistanceThreshold = 0.1f, const float AngularThreshold = 2.f,
+		const int32 InKeyframeInterval = 100);
+
+	// Set file handle for appending log data to file every update, optionally
+	// compressed, or framed in records with checksums (not both)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void InitFileHandle(const FString EpisodeId, const FString LogDirectoryPath,
+		ESLRawDataFormat InFormat = ESLRawDataFormat::Json, const bool bInCompress = false, const bool bInFramed = false);
+
+	// Set the frame queue of the file writer thread (call after InitFileHandle)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void InitFileQueue(const int32 QueueSize = 256,
+		ESLRawDataQueuePolicy QueuePolicy = ESLRawDataQueuePolicy::Block);
 
-	// Set file handle for appending log data to file every update
+	// Also write the frames to the mongo database, in a collection named after the episode
 	UFUNCTION(BlueprintCallable, Category = SL)
-	void InitFileHandle(const FString EpisodeId, const FString LogDirectoryPath);
+	bool InitMongoWriter(const FString EpisodeId, const FString Uri, const FString Database,
+		const int32 BatchSize = 1000, const float FlushInterval = 1.f);
+
+	// Stream the frames to the clients connected on the local port (binary, filtered by class per client)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	bool InitStreamServer(const int32 Port = 7100, const int32 MaxClientBacklogKB = 4096);
+
+	// Publish the frames into a named shared memory ring for the local readers
+	UFUNCTION(BlueprintCallable, Category = SL)
+	bool InitSharedMemory(const FString Name = TEXT("SLRawData"), const int32 NumSlots = 64,
+		const int32 MaxPosesPerFrame = 4096);
+
+	// Set per class sampling periods and the adaptive sampling (call before LogFirstEntry)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void InitSampling(const TMap<FString, float>& InClassSamplingPeriods, bool bAdaptive = false,
+		float InMaxSamplingPeriod = 1.f);
+
+	// Sample at a fixed rate independent of the tick rate (call before LogFirstEntry)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void InitFixedTimestep(const float SamplePeriod, const int32 InMaxCatchUpSamples = 4);
+
+	// Quantize the poses, with the position precision (cm) per class, optionally as differences
+	// to the previously written poses in the binary format (call before LogFirstEntry)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void InitQuantization(const float InDefaultPositionPrecision, const TMap<FString, float>& InClassPositionPrecisions,
+		const bool bDeltaEncoding = false);
 
 	// Allow broadcasting the data as events
 	UFUNCTION(BlueprintCallable, Category = SL)
 	void InitBroadcaster();
+
+	// Add an output for the frames, started with the first entry (call before LogFirstEntry)
+	void AddSink(const TSharedRef<FSLRawDataSink>& Sink);
 	
 	// Log dynamic and static entities to file
 	UFUNCTION(BlueprintCallable, Category = SL)
@@ -72,6 +104,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = SL)
 	void LogDynamicEntities();
 
+	// Log dynamic entities at the fixed sample times passed since the previous call (call every tick)
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void LogDynamicEntitiesFixedStep();
+
 	// Add new dynamic entity for logging
 	UFUNCTION(BlueprintCallable, Category = SL)
 	void AddNewDynamicEntity(AActor* Actor);
@@ -80,6 +116,31 @@ public:
 	UFUNCTION(BlueprintCallable, Category = SL)
 	void RemoveDynamicEntity(AActor* Actor);
 
+	// Write the remaining data and close the outputs
+	UFUNCTION(BlueprintCallable, Category = SL)
+	void Finish();
+
+	// Number of frames waiting to be written to file
+	int32 GetWriterQueueDepth() const { return FileSink.IsValid() ? FileSink->GetQueueDepth() : 0; };
+
+	// Number of frames dropped by the file writer
+	int32 GetWriterDroppedFrames() const { return FileSink.IsValid() ? FileSink->GetNumDropped() : 0; };
+
+	// Number of frames merged into a following frame by the file writer (Merge queue policy)
+	int32 GetWriterMergedFrames() const { return FileSink.IsValid() ? FileSink->GetNumMerged() : 0; };
+
+	// Number of frames the mongo writer could not insert
+	int32 GetMongoDroppedFrames() const { return MongoSink.IsValid() ? MongoSink->GetNumDropped() : 0; };
+
+	// Number of frames merged into a following frame while the mongo server was busy
+	int32 GetMongoMergedFrames() const { return MongoSink.IsValid() ? MongoSink->GetNumMerged() : 0; };
+
+	// Number of frames dropped by the stream server (summed over the clients)
+	int32 GetStreamDroppedFrames() const { return StreamSink.IsValid() ? StreamSink->GetNumDropped() : 0; };
+
+	// Number of updates not captured because all the pooled frames were still in use
+	int32 GetSkippedFrames() const { return NumSkippedFrames; };
+
 	// See if logger initialized
 	UFUNCTION(BlueprintCallable, Category = SL)
 	bool IsInit() const { return bIsInit; }
@@ -87,62 +148,210 @@ public:
 	// Delegate to publish the data
 	FSLOnNewRawDataSignature OnNewData;
 
+	// Delegate to publish the data as the json UTF-8 bytes written to file (no string conversion)
+	FSLOnNewRawDataBytesSignature OnNewJsonBytes;
+
+	// Delegate to publish the captured frames without serialization (called on the game thread when the frame
+	// is dispatched, the entity table is only valid during the call, the frame as long as its reference is kept)
+	FSLOnNewRawDataFrameSignature OnNewFrame;
+
 private:
-	// Get the dynamic and static entities as json string
-	bool GetAllEntitiesAsJson(FString& FirstJsonEntry);
+	// Add the static entities to the frame and register the dynamic ones
+	void CaptureAllEntities();
+
+	// Add the dynamic entities which changed to the frame (all of them with all bones on keyframes)
+	void CaptureDynamicEntities(bool bForceKeyframe);
+
+	// Add the dynamic entity to the frame, skeletal entities only with the bones which changed
+	void AddDynamicEntityToFrame(int32 Slot, bool bRootChanged, bool bAllBones);
+
+	// Get the entities due for sampling, sets their bits in the due mask
+	void PopDueEntities(float Time);
+
+	// Schedule the next sample of the entities sampled at this update
+	void ScheduleNextSamples(float Time);
+
+	// Get the time until the next sample from the change since the last one
+	float GetAdaptiveSamplingPeriod(int32 Slot, float Time) const;
+
+	// Store the dynamic entity with its change thresholds and sampling period
+	void AddToDynamicEntities(UObject* Key, USceneComponent* Component, USkeletalMeshComponent* SkelMesh,
+		int32 EntityIndex, const FName& SemLogTag);
+
+	// Get the sampling period of the entity (SemLog tag, class period, or 0 for every update)
+	float GetSamplingPeriod(const FName& SemLogTag) const;
+
+	// Get the position precision of the entity (0 if not quantized or flagged as lossless)
+	float GetPositionPrecision(const FName& SemLogTag) const;
 
-	// Log dynamic entities and return them as json string
-	bool GetDynamicEntitiesAsJson(FString& DynamicJsonEntry);
+	// Get the change thresholds of the entity (defaults or values from the SemLog tag)
+	void GetChangeThresholds(const FName& SemLogTag, float& OutSquaredDistanceThreshold, float& OutMinQuatDot) const;
 
-	// Add json content to file
-	bool InsertJsonContentToFile(const FString& JsonString);
+	// Get a free frame from the pool as the current frame, false if none is free
+	bool AcquireFrame();
 
-	// Broadcast json content
-	void BroadcastJsonContent(const FString& JsonString);
+	// Hand the captured frame over to the frame subscribers and the sinks
+	void DispatchFrame();
 
-	// Create Json object with a 3d location
-	FORCEINLINE TSharedPtr<FJsonObject> CreateLocationJsonObject(const FVector& Location);
+	// Start the sink threads
+	void StartSinks();
 
-	// Create Json object with a 3d rotation as quaternion 
-	FORCEINLINE TSharedPtr<FJsonObject> CreateRotationJsonObject(const FQuat& Rotation);
+	// Pass the json bytes to the game thread subscribers, shared with the json file if there is one
+	void StartBroadcast();
 
-	// Create Json object with name location and rotation
-	FORCEINLINE TSharedPtr<FJsonObject> CreateNameLocRotJsonObject(
-		const FString& Name, const FVector& Location, const FQuat& Rotation);
+	// Broadcast json content (UTF-8, game thread), converted to a string only for the string subscribers
+	void BroadcastJsonContent(const TArray<uint8>& JsonBytes);
 
-	// Add actors data to the json array
-	void AddActorToJsonArray(
-		TArray<TSharedPtr<FJsonValue>>& OutJsonArray,
-		AActor* Actor,
-		FUniqueNameAndLocation &UniqueNameAndLocation);
+	// Give the entity an index and store its description
+	int32 RegisterEntity(const FString& UniqueName, const FName& SemLogTag, USkeletalMeshComponent* SkelMesh = nullptr);
 
-	// Add component's data to the json array
-	void AddComponentToJsonArray(
-		TArray<TSharedPtr<FJsonValue>>& OutJsonArray,
-		USceneComponent* Component,
-		FUniqueNameAndLocation &UniqueNameAndLocation);
+	// Add the pose of the entity (and of its bones) to the frame
+	void AddPoseToFrame(int32 EntityIndex, USceneComponent* Component, USkeletalMeshComponent* SkelMesh);
 
-	// Distance threshold (squared for faster comparisons)
+	// Add all the bones of the skeletal mesh to the frame
+	void AddBonesToFrame(int32 EntityIndex, USkeletalMeshComponent* SkelMesh);
+
+	// Default distance threshold (squared for faster comparisons)
 	float SquaredDistanceThreshold;
 
+	// Default angular threshold as minimum quaternion |dot| product
+	float MinQuatDot;
+
+	// Number of updates between keyframes (0 for only the first entry)
+	int32 KeyframeInterval;
+
+	// Updates since the last keyframe
+	int32 UpdatesSinceKeyframe;
+
 	// Pointer to the world
 	UWorld* World;
 
-	// File handle to append the raw data
-	IFileHandle* FileHandle;
+	/** Outputs **/
+	// Sinks consuming the dispatched frames
+	TArray<TSharedRef<FSLRawDataSink>> Sinks;
 
-	// Dynamic actors with their unique name and previous location
-	TMap<AActor*, FUniqueNameAndLocation> DynamicActorsWithData;
+	// Episode file output
+	TSharedPtr<FSLRawDataFileSink> FileSink;
 
-	// Dynamic components with their unique name and previous location
-	TMap<USceneComponent*, FUniqueNameAndLocation> DynamicComponentsWithData;
+	// Database output
+	TSharedPtr<FSLRawDataMongoSink> MongoSink;
 
-	// Logger initialized
-	bool bIsInit;
+	// Local stream server output
+	TSharedPtr<FSLRawDataStreamSink> StreamSink;
+
+	// Shared memory output
+	TSharedPtr<FSLRawDataSharedMemorySink> SharedMemorySink;
+
+	// Set once the sink threads are started
+	bool bSinksStarted;
+
+	// Broadcast the json bytes of the frames
+	bool bBroadcast;
+
+	/** Capture (game thread) **/
+	// Number of frames allocated at init
+	static const int32 NumPreallocatedFrames = 4;
+
+	// Number of poses reserved in each frame
+	static const int32 NumPreallocatedPoses = 1024;
+
+	// Frames the frame subscribers can keep on top of the ones held by the sinks
+	static const int32 NumSubscriberFrames = 64;
+
+	// Updates skipped because the pool was exhausted
+	int32 NumSkippedFrames;
+
+	// Frame being captured
+	TSharedPtr<FSLRawDataFrame, ESPMode::ThreadSafe> CurrFrame;
+
+	// Frames reused once the sinks and the frame subscribers release them
+	TSharedPtr<FSLRawDataFramePool, ESPMode::ThreadSafe> FramePool;
+
+	// Entities registered since the last dispatched frame
+	TArray<FSLRawDataEntityDesc> PendingEntities;
+
+	// Entities of the dispatched frames, for the frame subscribers
+	TArray<FSLRawDataEntityDesc> DispatchedEntities;
+
+	// Number of registered entities
+	int32 NumEntities;
+
+	/** Quantization **/
+	// Quantize the poses of the entities with a position precision
+	bool bQuantize;
+
+	// Position precision (cm) of the entities without a class or tag precision
+	float DefaultPositionPrecision;
+
+	// Position precision (cm) per class
+	TMap<FString, float> ClassPositionPrecisions;
+
+	// Write the quantized binary poses as differences to the previous ones
+	bool bDeltaEncode;
 
-	// Logging to file
-	bool bLogToFile;
+	// Dynamic actors and components with their entity index and previous location
+	FSLRawDataEntityRegistry DynamicEntities;
 
-	// Broadcast data
-	bool bBroadcastData;
+	// One bit per dynamic entity, set if it moved or rotated since it was last logged
+	TArray<uint32> MovedMask;
+
+	/** Fixed timestep **/
+	// Samples are taken at fixed times, poses interpolated between ticks
+	bool bFixedTimestep;
+
+	// Time between two samples
+	float FixedSamplePeriod;
+
+	// Most samples written in one tick, older ones are skipped
+	int32 MaxCatchUpSamples;
+
+	// Time of the first entry
+	double FirstSampleTime;
+
+	// Number of samples since the first entry
+	int64 NumSamples;
+
+	// Time of the previous tick
+	double LastTickTime;
+
+	// The current sample is interpolated between the previous and the current tick
+	bool bInterpolateSample;
+
+	// Position of the current sample between the previous (0) and the current (1) tick
+	float SampleAlpha;
+
+	/** Sampling **/
+	// Sampling periods per class (from the SemLog tag)
+	TMap<FString, float> ClassSamplingPeriods;
+
+	// Sample at a higher rate while entities change fast, and at a lower one while idle
+	bool bAdaptiveSampling;
+
+	// Longest time between two samples in the adaptive mode
+	float MaxSamplingPeriod;
+
+	// Set if any entity has its own sampling period, otherwise all are sampled every update
+	bool bUseScheduler;
+
+	// Due times of the dynamic entities
+	FSLRawDataScheduler Scheduler;
+
+	// Slots of the entities due at the current update
+	TArray<int32> DueSlots;
+
+	// One bit per dynamic entity, set if it is due at the current update
+	TArray<uint32> DueMask;
+
+	// Bone indexes of the static skeletal entities
+	TArray<int32> BoneIndices;
+
+	// Bone poses read at the current update
+	TArray<FVector> BoneLocations;
+	TArray<FQuat> BoneRotations;
+
+	// Indexes of the bones which changed
+	TArray<int32> ChangedBones;
+
+	// Logger initialized
+	bool bIsInit;
 };
@@ -0,0 +1,87 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataBson.h"
+#ifdef WITH_MONGO
+#include "mongoc.h"
+#endif //WITH_MONGO
+
+/**
+* Writes the raw data frames to a MongoDB collection (one document per frame, same layout as the json output),
+* the documents are encoded straight from the poses and sent with unordered bulk inserts;
+* the collection is indexed by timestamp and actor name when started
+*/
+class SEMLOG_API FSLRawDataMongoSink : public FSLRawDataSink
+{
+public:
+	// Constructor
+	FSLRawDataMongoSink();
+
+	// Destructor, sends the queued frames
+	~FSLRawDataMongoSink();
+
+	// Connect to the server, waits at most the server selection timeout
+	// (call before Start, false if not built with mongo or if the connection fails)
+	bool Connect(const FString& Uri, const FString& Database, const FString& InCollection,
+		int32 InBatchSize = 1000, float InFlushInterval = 1.f);
+
+	// Most documents in one bulk insert
+	int32 GetBatchSize() const { return BatchSize; };
+
+protected:
+	/** FSLRawDataSink interface */
+	virtual const TCHAR* GetThreadName() const override { return TEXT("SLRawDataMongoSink"); };
+	virtual void OnStart() override;
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) override;
+	virtual void OnIdle() override;
+	virtual void OnFinish() override;
+
+private:
+#ifdef WITH_MONGO
+	// Create the timestamp and actor name indexes
+	void CreateIndexes();
+
+	// Send the documents added since the last bulk insert
+	void SendBulk();
+
+	// Close the connection
+	void Disconnect();
+
+	// Connection
+	mongoc_client_t* Client;
+
+	// Raw data collection
+	mongoc_collection_t* Collection;
+
+	// Bulk insert being filled (copies the documents)
+	mongoc_bulk_operation_t* Bulk;
+
+	// Encodes the frames, the document buffer is reused
+	FSLRawDataBsonWriter BsonWriter;
+
+	// Server selection timeout (ms) if the uri does not set one
+	static const int32 ServerSelectionTimeoutMs = 2000;
+#endif //WITH_MONGO
+
+	// Database name
+	FString DatabaseName;
+
+	// Collection name
+	FString CollectionName;
+
+	// Most documents in one bulk insert
+	int32 BatchSize;
+
+	// Longest time (s) a document waits before being sent
+	float FlushInterval;
+
+	// Documents in the current bulk insert
+	int32 NumInBulk;
+
+	// Time the first document was added to the current bulk insert
+	double BulkStartTime;
+};
@@ -0,0 +1,34 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Batched change checks for the raw data logger, entities are compared four at a time
+* using the engine vector intrinsics (SSE, NEON or FPU fallback); masks have one bit per entity, 32 per word
+*/
+struct SEMLOG_API FSLRawDataMotion
+{
+	// Set the bit of every entity which moved more than its (squared) distance threshold
+	static void ComputeMovedMask(const FVector* CurrLocations, const FVector* PrevLocations,
+		const float* SquaredDistanceThresholds, int32 Num, TArray<uint32>& OutMovedMask);
+
+	// Additionally set the bit of every entity whose rotation |dot| with the previous one is below its minimum
+	static void AddRotatedToMask(const FQuat* CurrRotations, const FQuat* PrevRotations,
+		const float* MinQuatDots, int32 Num, TArray<uint32>& InOutMovedMask);
+
+	// Minimum quaternion |dot| for an angular threshold in degrees (non positive disables the check)
+	static FORCEINLINE float AngularThresholdToMinQuatDot(float AngularThresholdDeg)
+	{
+		// |dot(q1, q2)| = cos(angle / 2)
+		return AngularThresholdDeg > 0.f ? FMath::Cos(FMath::DegreesToRadians(AngularThresholdDeg) * 0.5f) : -1.f;
+	}
+
+	// Check if the entity bit is set in the mask
+	static FORCEINLINE bool IsSet(const TArray<uint32>& Mask, int32 Index)
+	{
+		return (Mask[Index >> 5] & (1u << (Index & 31))) != 0;
+	}
+};
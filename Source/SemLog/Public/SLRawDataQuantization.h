@@ -0,0 +1,64 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Quantization of raw data poses: positions as integer multiples of a precision,
+* rotations as the smallest three quaternion components (15 bits each, 6 bytes in total)
+*/
+struct SEMLOG_API FSLRawDataQuantization
+{
+	// Size of a packed rotation in bytes
+	static const int32 PackedQuatSize = 6;
+
+	// Scale of the quaternion components quantized for delta encoding
+	static const int32 QuatComponentScale = 16383;
+
+	// Map signed to unsigned integers, small magnitudes stay small (for varints)
+	static FORCEINLINE uint32 ZigZagEncode(int32 Value)
+	{
+		return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+	}
+
+	// Inverse of ZigZagEncode
+	static FORCEINLINE int32 ZigZagDecode(uint32 Value)
+	{
+		return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	}
+
+	// Quantize the location to multiples of the precision (cm)
+	static FORCEINLINE FIntVector QuantizeLocation(const FVector& Location, float Precision)
+	{
+		const float InvPrecision = 1.f / Precision;
+		return FIntVector(FMath::RoundToInt(Location.X * InvPrecision),
+			FMath::RoundToInt(Location.Y * InvPrecision),
+			FMath::RoundToInt(Location.Z * InvPrecision));
+	}
+
+	// Restore the location from its multiples of the precision (cm)
+	static FORCEINLINE FVector DequantizeLocation(const FIntVector& Quantized, float Precision)
+	{
+		return FVector(Quantized.X * Precision, Quantized.Y * Precision, Quantized.Z * Precision);
+	}
+
+	// Pack the rotation into its smallest three components (the result uses the lower 47 bits)
+	static uint64 PackQuat(const FQuat& Rotation);
+
+	// Unpack a rotation packed with PackQuat
+	static FQuat UnpackQuat(uint64 Packed);
+
+	// Write the packed rotation as PackedQuatSize little endian bytes
+	static void SerializePackedQuat(FArchive& Ar, uint64& Packed);
+
+	// Quantize the four rotation components (x, y, z, w), the sign is chosen to be closest to the previous ones
+	static void QuantizeQuatComponents(const FQuat& Rotation, const int32 Previous[4], int32 OutComponents[4]);
+
+	// Restore the rotation from its quantized components
+	static FQuat DequantizeQuatComponents(const int32 Components[4]);
+
+	// Number of decimals needed to print positions in meters with the precision (cm)
+	static int32 GetMeterDecimals(float Precision);
+};
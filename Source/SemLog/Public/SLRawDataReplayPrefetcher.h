@@ -0,0 +1,136 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "SLRawDataEpisodeReader.h"
+#include <atomic>
+
+class FRunnableThread;
+
+/**
+* Decoded frame handed from the prefetch thread to the replay
+*/
+struct FSLRawDataReplayFrame
+{
+	// Seek generation the frame was read for, frames of older generations are skipped
+	int32 Generation;
+
+	// Frame data, NewEntities holds the entities (or bone names) not sent before
+	FSLRawDataFrame Frame;
+};
+
+/**
+* Reads the episode frames ahead of the replay time on a separate thread,
+* after a seek the frames are decoded again from the last keyframe before the seek time
+*/
+class SEMLOG_API FSLRawDataReplayPrefetcher : public FRunnable
+{
+public:
+	// Constructor
+	FSLRawDataReplayPrefetcher();
+
+	// Destructor, stops the thread
+	~FSLRawDataReplayPrefetcher();
+
+	// Open the episode and start the thread
+	bool Start(const FString& Path, double InWindow, int32 InMaxQueuedFrames);
+
+	// Stop the thread and close the episode
+	void Finish();
+
+	// Restart reading at the time, returns the generation of the frames read from now on
+	int32 Seek(double Time);
+
+	// Set the replay time, frames are read up to the time plus the window
+	void SetConsumerTime(double Time);
+
+	// Get the oldest read frame without removing it
+	bool Peek(FSLRawDataReplayFrame*& OutFrame);
+
+	// Remove the oldest read frame and give it back for reuse
+	void Pop();
+
+	// True if every frame of the generation was read
+	bool IsEndReached(int32 InGeneration) const { return bEndReached.load() && Generation.load() == InGeneration; };
+
+	// Timestamp of the first frame
+	double GetStartTime() const { return StartTime; };
+
+	// Timestamp of the last frame
+	double GetEndTime() const { return EndTime; };
+
+	/** FRunnable interface */
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	// Copy the entities, or bones, the replay does not know yet into the frame
+	void AddUnsentEntities(FSLRawDataFrame& Frame);
+
+	// Episode reader, only used by the thread after start
+	FSLRawDataEpisodeReader Reader;
+
+	// Read frames
+	TQueue<FSLRawDataReplayFrame*, EQueueMode::Spsc> ReadFrames;
+
+	// Frames given back by the replay (only the replay produces into it)
+	TQueue<FSLRawDataReplayFrame*, EQueueMode::Spsc> FreeFrames;
+
+	// Frame kept by the prefetch thread after a failed read, reused for the next read
+	FSLRawDataReplayFrame* SpareFrame;
+
+	// Every allocated frame
+	TArray<FSLRawDataReplayFrame*> AllFrames;
+
+	// Number of read frames in the queue
+	std::atomic<int32> NumQueued;
+
+	// Most frames in the queue
+	int32 MaxQueuedFrames;
+
+	// Time (s) to read ahead of the replay time
+	double Window;
+
+	// Replay time
+	std::atomic<double> ConsumerTime;
+
+	// Current seek generation
+	std::atomic<int32> Generation;
+
+	// Set when the thread has to restart reading
+	std::atomic<bool> bSeekPending;
+
+	// Time to restart reading at
+	double SeekTime;
+
+	// Guards the seek time
+	FCriticalSection SeekLock;
+
+	// Set when the last frame was read
+	std::atomic<bool> bEndReached;
+
+	// Next frame to read
+	int32 NextFrameIndex;
+
+	// Number of bones sent for each entity (INDEX_NONE if the entity was not sent)
+	TArray<int32> SentBoneCounts;
+
+	// Timestamp of the first frame
+	double StartTime;
+
+	// Timestamp of the last frame
+	double EndTime;
+
+	// Signaled on seek, pop or stop
+	FEvent* WakeEvent;
+
+	// Prefetch thread
+	FRunnableThread* Thread;
+
+	// Set when the thread should exit
+	std::atomic<bool> bStopping;
+};
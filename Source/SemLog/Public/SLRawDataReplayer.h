@@ -0,0 +1,183 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SLRawDataReplayPrefetcher.h"
+#include "SLRawDataReplayer.generated.h"
+
+class UPoseableMeshComponent;
+
+/**
+* Replays a raw data episode (json or binary) on the tagged actors and components of the level,
+* entities are matched by their unique name (Class_Id), bones are applied to a poseable mesh of the owner
+*/
+UCLASS()
+class SEMLOG_API ASLRawDataReplayer : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASLRawDataReplayer();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when actor removed from game or game ended
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Open the episode and bind the entities
+	bool Init(const FString& InEpisodePath);
+
+	// Start or resume the replay
+	UFUNCTION(BlueprintCallable, Category = "SL|Raw Data Replayer")
+	void Play();
+
+	// Pause the replay
+	UFUNCTION(BlueprintCallable, Category = "SL|Raw Data Replayer")
+	void Pause();
+
+	// Jump to the episode time
+	UFUNCTION(BlueprintCallable, Category = "SL|Raw Data Replayer")
+	void Seek(float Time);
+
+	// Set the playback speed (1 for real time)
+	UFUNCTION(BlueprintCallable, Category = "SL|Raw Data Replayer")
+	void SetPlaybackSpeed(float InPlaybackSpeed) { PlaybackSpeed = FMath::Max(InPlaybackSpeed, 0.f); };
+
+	// Get the episode time being replayed
+	UFUNCTION(BlueprintCallable, Category = "SL|Raw Data Replayer")
+	float GetTime() const { return (float)CurrTime; };
+
+	// Check if playing
+	bool IsPlaying() const { return bIsPlaying; };
+
+	// Get the episode start time
+	double GetStartTime() const { return Prefetcher.GetStartTime(); };
+
+	// Get the episode end time
+	double GetEndTime() const { return Prefetcher.GetEndTime(); };
+
+private:
+	// Last replayed pose of an entity or bone
+	struct FReplaySample
+	{
+		FReplaySample() : Time(-1.0) {};
+
+		// Timestamp of the frame of the pose (< 0 if none yet)
+		double Time;
+
+		// Location
+		FVector Location;
+
+		// Rotation
+		FQuat Rotation;
+	};
+
+	// Replayed entity
+	struct FReplayEntity
+	{
+		FReplayEntity() : bIsDirty(false) {};
+
+		// Component moved with the entity pose
+		TWeakObjectPtr<USceneComponent> Component;
+
+		// Mesh the bone poses are applied to
+		TWeakObjectPtr<UPoseableMeshComponent> PoseableMesh;
+
+		// Bone names, indexed as in the episode
+		TArray<FName> BoneNames;
+
+		// Last pose of the entity
+		FReplaySample Root;
+
+		// Last pose of the bones
+		TArray<FReplaySample> Bones;
+
+		// Got new poses since last applied
+		bool bIsDirty;
+	};
+
+	// Map the unique names of the tagged actors and components of the level
+	void GatherTaggedComponents();
+
+	// Bind the entities sent with the frame
+	void AddEntities(const TArray<FSLRawDataEntityDesc>& NewEntities);
+
+	// Store the poses of the frame as the last ones
+	void StoreFramePoses(const FSLRawDataFrame& Frame);
+
+	// Apply the last poses, and interpolate towards the next frame
+	void ApplyPoses(const FSLRawDataFrame* NextFrame);
+
+	// Move the entity or bone
+	void ApplyPose(FReplayEntity& Entity, int32 BoneIndex, const FVector& Location, const FQuat& Rotation);
+
+	// Episode file (json or binary)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer")
+	FString EpisodePath;
+
+	// Start the replay at begin play
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer")
+	uint32 bAutoPlay : 1;
+
+	// Restart at the end of the episode
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer")
+	uint32 bLoop : 1;
+
+	// Playback speed (1 for real time)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer", meta = (ClampMin = 0))
+	float PlaybackSpeed;
+
+	// Interpolate the poses between the frames
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer")
+	uint32 bInterpolate : 1;
+
+	// Longest time (s) between two poses to interpolate, entities were still during longer gaps
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer", meta = (editcondition = "bInterpolate"), meta = (ClampMin = 0))
+	float MaxInterpolationGap;
+
+	// Time (s) to read ahead of the replay
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer", meta = (ClampMin = 0))
+	float PrefetchWindow;
+
+	// Most frames read ahead of the replay
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer", meta = (ClampMin = 2))
+	int32 MaxPrefetchedFrames;
+
+	// Turn off the physics of the replayed components
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Replayer")
+	uint32 bDisablePhysics : 1;
+
+	// Reads the frames on a separate thread
+	FSLRawDataReplayPrefetcher Prefetcher;
+
+	// Replayed entities, indexed by EntityIndex
+	TArray<FReplayEntity> Entities;
+
+	// Tagged components of the level by unique name
+	TMap<FString, TWeakObjectPtr<USceneComponent>> TaggedComponents;
+
+	// Entities with new poses
+	TArray<int32> DirtyEntities;
+
+	// Episode time being replayed
+	double CurrTime;
+
+	// Seek generation of the frames to replay
+	int32 Generation;
+
+	// Playing
+	bool bIsPlaying;
+
+	// Init
+	bool bIsInit;
+};
@@ -0,0 +1,64 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Timing wheel of the raw data sampling, entities are bucketed by their due time
+* so an update only visits the buckets which passed since the previous one
+*/
+class SEMLOG_API FSLRawDataScheduler
+{
+public:
+	// Default constructor
+	FSLRawDataScheduler();
+
+	// Set the bucket width (s) and the number of buckets (horizon = width * num), clears the entries
+	void Init(float InBucketDuration = 1.f / 120.f, int32 InNumBuckets = 256);
+
+	// Schedule the entity for the given time, times past the horizon are re-checked when their bucket comes up
+	void Schedule(int32 EntityIndex, float DueTime);
+
+	// Move the entities due at the given time to the output (entities scheduled for later stay)
+	void PopDue(float Time, TArray<int32>& OutEntityIndices);
+
+	// Remove all entries
+	void Reset();
+
+	// Number of scheduled entries
+	int32 Num() const { return NumEntries; };
+
+private:
+	// Scheduled entity
+	struct FEntry
+	{
+		// Index of the entity in the logger
+		int32 EntityIndex;
+
+		// Time when the entity should be sampled
+		float DueTime;
+	};
+
+	// Absolute bucket tick of the time
+	FORCEINLINE int64 GetTick(float Time) const
+	{
+		return (int64)FMath::FloorToDouble((double)Time / BucketDuration);
+	}
+
+	// Width of a bucket in seconds
+	float BucketDuration;
+
+	// Entries per bucket, indexed by tick modulo the number of buckets
+	TArray<TArray<FEntry>> Buckets;
+
+	// Visited entries which are not due yet (kept to avoid reallocations)
+	TArray<FEntry> NotDue;
+
+	// Next tick to be visited
+	int64 NextTick;
+
+	// Number of scheduled entries
+	int32 NumEntries;
+};
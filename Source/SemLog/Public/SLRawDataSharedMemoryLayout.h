@@ -0,0 +1,196 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+// Standalone (no engine types), shared by the shared memory sink and the external readers
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Layout of the raw data shared memory region (native endianness and alignment, writer and readers on the same machine):
+*	header | entity table (append-only entries) | latest pose table | frame slots (ring)
+* the latest pose table holds the newest pose of every entity and bone (static ones included), each entry
+* under its own sequence lock (odd while written); the ring is the feed of the changes on top of it:
+* frame N is written into slot N % NumSlots under a sequence lock: the slot sequence is 2N+1 while
+* the frame is written and 2N+2 once complete, readers check it before and after reading the frame;
+* the table entries of a frame are updated before the frame is published in the ring
+*/
+struct FSLRawDataSharedMemory
+{
+	// "SLRM"
+	static const uint32_t Magic = 0x4D524C53;
+
+	// Layout version
+	static const uint32_t Version = 2;
+
+	// Frame flags
+	static const uint32_t KeyframeFlag = 1 << 0;
+	static const uint32_t TruncatedFlag = 1 << 1;
+
+	// Slots, the entity table and the pose table entries start at cache line boundaries
+	static const uint64_t Alignment = 64;
+
+	// First pose entry of the entities which did not fit into the pose table
+	static const uint32_t NoPoseEntry = 0xFFFFFFFF;
+
+	// Sequence of the slot once frame N is complete
+	static uint64_t CompleteSequence(uint64_t FrameNumber) { return 2 * FrameNumber + 2; }
+
+	// Round up to the alignment
+	static uint64_t Align(uint64_t Size) { return (Size + Alignment - 1) & ~(Alignment - 1); }
+};
+
+/**
+* Region header, the magic is set last by the writer once the rest is initialized
+*/
+struct FSLRawDataSharedMemoryHeader
+{
+	// Magic, zero while the writer initializes the region
+	std::atomic<uint32_t> Magic;
+
+	// Layout version
+	uint32_t Version;
+
+	// Changes with every writer session, readers start over when it changes
+	uint64_t Epoch;
+
+	// Number of frame slots
+	uint32_t NumSlots;
+
+	// Bytes per slot (slot header and poses)
+	uint32_t SlotSize;
+
+	// Most poses in a slot, frames with more poses are truncated
+	uint32_t MaxPosesPerFrame;
+
+	// Set while the writer is running
+	std::atomic<uint32_t> bWriterActive;
+
+	// Offset and size of the entity table
+	uint64_t EntityTableOffset;
+	uint64_t EntityTableCapacity;
+
+	// Offset of the first slot
+	uint64_t SlotsOffset;
+
+	// Frames published so far, the latest one is NumFrames - 1
+	std::atomic<uint64_t> NumFrames;
+
+	// Bytes of the entity table published so far
+	std::atomic<uint64_t> EntityTableSize;
+
+	// Entities published so far
+	std::atomic<uint32_t> NumEntities;
+
+	// Offset of the latest pose table
+	uint64_t PoseTableOffset;
+
+	// Number of entries of the latest pose table
+	uint32_t PoseTableCapacity;
+
+	// Entries assigned to the published entities (one for the entity, one per bone)
+	std::atomic<uint32_t> NumPoseEntries;
+};
+
+/**
+* Slot header, followed by the poses; bones follow the pose of their entity
+*/
+struct FSLRawDataSharedMemorySlot
+{
+	// Sequence lock (2N+1 while frame N is written, 2N+2 once complete)
+	std::atomic<uint64_t> Sequence;
+
+	// Timestamp of the frame
+	double Timestamp;
+
+	// Keyframe and truncation flags
+	uint32_t Flags;
+
+	// Number of poses following the header
+	uint32_t NumPoses;
+};
+
+/**
+* Pose of an entity (BoneIndex -1) or of one of its bones, in engine units (cm, left handed)
+*/
+struct FSLRawDataSharedMemoryPose
+{
+	int32_t EntityIndex;
+	int32_t BoneIndex;
+	float Location[3];
+	float Rotation[4]; // x, y, z, w
+};
+
+/**
+* Entry of the latest pose table, the entity entry is followed by the entries of its bones
+*/
+struct FSLRawDataSharedMemoryPoseEntry
+{
+	// Sequence lock (odd while written, 0 if never written)
+	std::atomic<uint64_t> Sequence;
+
+	// Frame which last changed the pose
+	uint64_t FrameNumber;
+
+	// Timestamp of the frame
+	double Timestamp;
+
+	// Latest pose
+	FSLRawDataSharedMemoryPose Pose;
+
+	// Pads the entry to a cache line
+	uint32_t Padding;
+};
+
+// The entity table holds one entry per entity, in EntityIndex order, all values unaligned:
+//	int32 EntityIndex | uint32 FirstPoseEntry | uint32 NameSize | UTF-8 name | uint32 NumBones | (uint32 NameSize | UTF-8 bone name) * NumBones
+// the latest pose of the entity is the pose table entry FirstPoseEntry, of its bone B the entry FirstPoseEntry + 1 + B
+// (FirstPoseEntry is NoPoseEntry if the pose table was full)
+
+// The writer and the readers can be built by different compilers with different flags, the layout and
+// the lock free atomics (the sequence lock is shared between processes) are checked at compile time
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "SLRawData shared memory needs lock free atomics");
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+	"SLRawData shared memory needs lock free atomics");
+#endif
+static_assert(sizeof(std::atomic<uint32_t>) == 4 && sizeof(std::atomic<uint64_t>) == 8 && alignof(std::atomic<uint64_t>) == 8,
+	"SLRawData shared memory atomics must have the size of their value");
+
+static_assert(sizeof(FSLRawDataSharedMemoryHeader) == 96, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, Magic) == 0, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, Version) == 4, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, Epoch) == 8, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, NumSlots) == 16, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, SlotSize) == 20, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, MaxPosesPerFrame) == 24, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, bWriterActive) == 28, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, EntityTableOffset) == 32, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, EntityTableCapacity) == 40, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, SlotsOffset) == 48, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, NumFrames) == 56, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, EntityTableSize) == 64, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, NumEntities) == 72, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, PoseTableOffset) == 80, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, PoseTableCapacity) == 88, "SLRawData shared memory header layout");
+static_assert(offsetof(FSLRawDataSharedMemoryHeader, NumPoseEntries) == 92, "SLRawData shared memory header layout");
+
+static_assert(sizeof(FSLRawDataSharedMemorySlot) == 24, "SLRawData shared memory slot layout");
+static_assert(offsetof(FSLRawDataSharedMemorySlot, Sequence) == 0, "SLRawData shared memory slot layout");
+static_assert(offsetof(FSLRawDataSharedMemorySlot, Timestamp) == 8, "SLRawData shared memory slot layout");
+static_assert(offsetof(FSLRawDataSharedMemorySlot, Flags) == 16, "SLRawData shared memory slot layout");
+static_assert(offsetof(FSLRawDataSharedMemorySlot, NumPoses) == 20, "SLRawData shared memory slot layout");
+
+static_assert(sizeof(FSLRawDataSharedMemoryPose) == 36, "SLRawData shared memory pose layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPose, EntityIndex) == 0, "SLRawData shared memory pose layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPose, BoneIndex) == 4, "SLRawData shared memory pose layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPose, Location) == 8, "SLRawData shared memory pose layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPose, Rotation) == 20, "SLRawData shared memory pose layout");
+
+static_assert(sizeof(FSLRawDataSharedMemoryPoseEntry) == 64, "SLRawData shared memory pose entry layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPoseEntry, Sequence) == 0, "SLRawData shared memory pose entry layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPoseEntry, FrameNumber) == 8, "SLRawData shared memory pose entry layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPoseEntry, Timestamp) == 16, "SLRawData shared memory pose entry layout");
+static_assert(offsetof(FSLRawDataSharedMemoryPoseEntry, Pose) == 24, "SLRawData shared memory pose entry layout");
@@ -0,0 +1,74 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataSharedMemoryLayout.h"
+
+/**
+* Publishes the latest pose of every entity and bone, and the frames as a feed of the changes, into a named
+* shared memory region (see SLRawDataSharedMemoryLayout.h); any number of local readers can read the poses in place;
+* the writer never waits for the readers, readers which join late or fall behind by more than the ring size
+* start over from the latest poses
+*/
+class SEMLOG_API FSLRawDataSharedMemorySink : public FSLRawDataSink
+{
+public:
+	// Constructor
+	FSLRawDataSharedMemorySink();
+
+	// Destructor, unmaps the region
+	~FSLRawDataSharedMemorySink();
+
+	// Create the named region (call before Start), on POSIX systems the region is /dev/shm/<Name>
+	bool Create(const FString& Name, int32 NumSlots = 64, int32 MaxPosesPerFrame = 4096,
+		int32 EntityTableCapacity = 1024 * 1024, int32 PoseTableCapacity = 64 * 1024);
+
+protected:
+	/** FSLRawDataSink interface */
+	virtual const TCHAR* GetThreadName() const override { return TEXT("SLRawDataSharedMemorySink"); };
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) override;
+	virtual void OnFinish() override;
+
+private:
+	// Append the entity to the table, false if the table is full
+	bool PublishEntity(const FSLRawDataEntityDesc& Entity);
+
+	// Update the latest poses, write the frame into its slot and publish it
+	void PublishFrame(const FSLRawDataFrame& Frame);
+
+	// Write the pose into the latest pose table under the entry sequence lock
+	FORCEINLINE void PublishLatestPose(const FSLRawDataPose& Pose, double Timestamp);
+
+	// Copy the pose into the shared layout
+	static FORCEINLINE void ToSharedPose(const FSLRawDataPose& Pose, FSLRawDataSharedMemoryPose& OutPose);
+
+	// Append the bytes to the entity table (not yet published)
+	FORCEINLINE void AppendToEntityTable(const void* Data, uint64 Size, uint64& InOutOffset);
+
+	// Unmap the region (removes the name, the mapped readers keep their view)
+	void Close();
+
+	// Mapped region
+	FPlatformMemory::FSharedMemoryRegion* Region;
+
+	// Region header
+	FSLRawDataSharedMemoryHeader* Header;
+
+	// Frames written so far
+	uint64 NumFrames;
+
+	// Set once the entity table is full
+	bool bEntityTableFull;
+
+	// Set once the latest pose table is full
+	bool bPoseTableFull;
+
+	// First latest pose entry of the published entities, indexed by EntityIndex (NoPoseEntry if the table was full)
+	TArray<uint32> FirstPoseEntries;
+
+	// Number of latest pose entries of the published entities (entity and bones), indexed by EntityIndex
+	TArray<int32> NumEntityPoseEntries;
+};
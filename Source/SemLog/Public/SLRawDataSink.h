@@ -0,0 +1,195 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/ArrayView.h"
+#include "Containers/Queue.h"
+#include "SLRawDataFrame.h"
+#include <atomic>
+#include "SLRawDataSink.generated.h"
+
+class FRunnableThread;
+
+/**
+* What to do when the queue of a sink is full
+*/
+UENUM()
+enum class ESLRawDataQueuePolicy : uint8
+{
+	Block			UMETA(DisplayName = "Block"),
+	Merge			UMETA(DisplayName = "Merge"),
+	Grow			UMETA(DisplayName = "Grow")
+};
+
+/**
+* Poses of one entity merged from consecutive frames, the newest pose of the entity and of each bone
+*/
+struct FSLRawDataMergedEntity
+{
+	// Entity pose
+	FSLRawDataPose EntityPose;
+
+	// Bone poses, in the order they were first seen
+	TArray<FSLRawDataPose> BonePoses;
+
+	// Position of the bone poses in BonePoses, indexed by BoneIndex (INDEX_NONE if not seen)
+	TArray<int32> BonePositions;
+};
+
+/**
+* Output of the raw data logger (file, database, broadcast etc.), every sink consumes the captured frames
+* in order on its own thread from its own bounded lock-free ring, so a slow sink never stalls the game thread or the other sinks;
+* with Merge the frames arriving at a full queue are merged into one, keeping the newest poses and the new entities
+* (derived sinks call Finish in their destructor, the thread uses their overrides)
+*/
+class SEMLOG_API FSLRawDataSink : public FRunnable
+{
+public:
+	// Constructor
+	FSLRawDataSink();
+
+	// Destructor, consumes the queued frames
+	virtual ~FSLRawDataSink();
+
+	// Set the queue size and what to do when it is full (call before Start)
+	void SetQueue(int32 InCapacity, ESLRawDataQueuePolicy InPolicy);
+
+	// Start the sink thread
+	bool Start();
+
+	// Queue the frame, with Merge a full queue merges it with the frames waiting for room (single producer)
+	void Enqueue(const FSLRawDataFrameRef& Frame);
+
+	// Consume the queued frames, stop the thread and close the output
+	void Finish();
+
+	// Check if started
+	bool IsStarted() const { return Thread != nullptr; };
+
+	// Number of frames waiting to be consumed in the ring
+	int32 GetQueueDepth() const { return (int32)(QueueTail.load() - QueueHead.load()); };
+
+	// Number of frames dropped by the sink
+	int32 GetNumDropped() const { return NumDropped.load(); };
+
+	// Number of frames merged into a following frame because the queue was full
+	int32 GetNumMerged() const { return NumMerged.load(); };
+
+	// Most frames referenced by the sink at once (queued and being consumed), INDEX_NONE if the queue grows
+	virtual int32 GetMaxHeldFrames() const { return Policy == ESLRawDataQueuePolicy::Grow ? INDEX_NONE : Capacity + MaxBatchSize; };
+
+	// Most frames waiting to be consumed
+	int32 GetCapacity() const { return Capacity; };
+
+	// Queue full policy
+	ESLRawDataQueuePolicy GetPolicy() const { return Policy; };
+
+	/** FRunnable interface */
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+protected:
+	// Name of the sink thread
+	virtual const TCHAR* GetThreadName() const = 0;
+
+	// Called on the sink thread before the first frame (e.g. write the headers)
+	virtual void OnStart() {};
+
+	// Process the frames in order (sink thread), the entity table holds the entities of all the frames of the batch
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) = 0;
+
+	// Called on the sink thread while the queue is empty, at least every IdleWaitMs (e.g. flush on a timer)
+	virtual void OnIdle() {};
+
+	// Called on the sink thread after the last frame (e.g. flush and close the output)
+	virtual void OnFinish() {};
+
+	// Count frames dropped by the sink itself
+	void AddDropped(int32 Num) { NumDropped += Num; };
+
+	// Longest wait (ms) of the sink thread for new frames
+	static const uint32 IdleWaitMs = 10;
+
+private:
+	// Add the frame to the ring, false if it is full (producer only)
+	bool TryEnqueue(const FSLRawDataFrameRef& Frame);
+
+	// Queue the frames waiting for room (merged or grown), false if some are still waiting
+	bool TryEnqueuePending();
+
+	// Merge the frame into the pending merged frame, the newer pose wins per entity and bone
+	void MergeFrame(const FSLRawDataFrame& Frame);
+
+	// Queue the pending merged frame, false if the queue is still full
+	bool TryEnqueueMerged();
+
+	// Take the next frames out of the queue
+	bool DequeueBatch(TArray<FSLRawDataFrameRef>& OutBatch);
+
+	// Most frames handed to one Consume call
+	static const int32 MaxBatchSize = 64;
+
+	// Ring of the frames waiting to be consumed, a slot is written by the producer until published
+	// by QueueTail, then read and cleared by the sink thread until released by QueueHead
+	TArray<TSharedPtr<const FSLRawDataFrame, ESPMode::ThreadSafe>> Queue;
+
+	// Number of frames taken out of the ring (written by the sink thread only)
+	std::atomic<uint64> QueueHead;
+
+	// Number of frames added to the ring (written by the producer only)
+	std::atomic<uint64> QueueTail;
+
+	// Frames behind the full ring with Grow, in order (producer only)
+	TQueue<TSharedPtr<const FSLRawDataFrame, ESPMode::ThreadSafe>, EQueueMode::Spsc> Overflow;
+
+	// Set while Overflow holds frames (producer only)
+	bool bHasOverflow;
+
+	// Entities of the consumed frames, indexed by EntityIndex
+	TArray<FSLRawDataEntityDesc> Entities;
+
+	// Most frames waiting to be consumed
+	int32 Capacity;
+
+	// Queue full policy
+	ESLRawDataQueuePolicy Policy;
+
+	// Frames dropped by the sink
+	std::atomic<int32> NumDropped;
+
+	// Frames merged into a following frame
+	std::atomic<int32> NumMerged;
+
+	// Set while frames wait to be queued as one merged frame (producer only)
+	bool bHasMergedFrame;
+
+	// Timestamp of the newest merged frame
+	float MergedTimestamp;
+
+	// Set if any of the merged frames is a keyframe
+	bool bMergedKeyframe;
+
+	// Entities added by the merged frames, in order
+	TArray<FSLRawDataEntityDesc> MergedNewEntities;
+
+	// Entity poses of the merged frames, in the order they were first seen
+	TArray<FSLRawDataMergedEntity> MergedEntities;
+
+	// Position of the entities in MergedEntities, by EntityIndex
+	TMap<int32, int32> MergedEntityPositions;
+
+	// Signaled when a frame is queued
+	FEvent* DataEvent;
+
+	// Signaled when frames were taken out of the queue
+	FEvent* SpaceEvent;
+
+	// Sink thread
+	FRunnableThread* Thread;
+
+	// Set when the thread should consume the remaining frames and exit
+	std::atomic<bool> bStopping;
+};
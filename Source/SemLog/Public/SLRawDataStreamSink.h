@@ -0,0 +1,158 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataSink.h"
+#include "SLRawDataBinary.h"
+#include "Containers/BitArray.h"
+
+class FSocket;
+class FTcpListener;
+struct FIPv4Endpoint;
+
+/**
+* Streams the frames to the clients connected on a local TCP port; every client receives a framed binary
+* stream (same bytes as a .slf binary file: header, then one record with the new entities and poses per frame),
+* optionally only with the entities of the classes it subscribed to by sending a line: "classes Class1,Class2\n"
+* (an empty list subscribes to all); frames are dropped per client while its unsent data is over the backlog,
+* so a slow client never stalls the logging or the other clients; after joining, resubscribing or dropping frames
+* a client first gets a snapshot keyframe with the last poses of all its entities (static ones included)
+*/
+class SEMLOG_API FSLRawDataStreamSink : public FSLRawDataSink
+{
+public:
+	// Constructor
+	FSLRawDataStreamSink();
+
+	// Destructor, disconnects the clients
+	~FSLRawDataStreamSink();
+
+	// Listen on the local port, 0 for any free port (call before Start)
+	bool Listen(int32 Port, int32 InMaxClientBacklog = 4 * 1024 * 1024);
+
+	// Port the sink listens on, 0 if not listening
+	int32 GetPort() const;
+
+	// Number of connected clients
+	int32 GetNumClients() const { return NumClients.load(); };
+
+protected:
+	/** FSLRawDataSink interface */
+	virtual const TCHAR* GetThreadName() const override { return TEXT("SLRawDataStreamSink"); };
+	virtual void Consume(TArrayView<const FSLRawDataFrameRef> Frames, const TArray<FSLRawDataEntityDesc>& Entities) override;
+	virtual void OnIdle() override;
+	virtual void OnFinish() override;
+
+private:
+	// Connected client
+	struct FClient
+	{
+		// Connection (non-blocking)
+		FSocket* Socket = nullptr;
+
+		// Remote address
+		FString Address;
+
+		// Subscribed entity classes, empty for all
+		TArray<FString> Classes;
+
+		// Entities of the subscribed classes, indexed by EntityIndex
+		TBitArray<> Matches;
+
+		// Entity chunks already sent, indexed by EntityIndex
+		TBitArray<> SentEntities;
+
+		// Bytes not yet sent
+		TArray<uint8> SendBuffer;
+
+		// Bytes of the send buffer already sent
+		int32 SendOffset = 0;
+
+		// Received bytes of an unfinished line
+		TArray<uint8> LineBuffer;
+
+		// Frames dropped because the client was too slow
+		int32 NumDropped = 0;
+
+		// Set if the client misses poses, the last poses are sent before the next frame
+		bool bNeedsSnapshot = true;
+	};
+
+	// Accept the connection (listener thread)
+	bool OnConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint);
+
+	// Take over the accepted connections
+	void AddNewClients();
+
+	// Read the subscription messages and send the pending bytes, removes the disconnected clients
+	void UpdateClients();
+
+	// Add the frame to the client, with the entity chunks it did not receive yet (false if dropped)
+	bool AddFrameToClient(FClient& Client, const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities);
+
+	// Add a keyframe with the last poses of the subscribed entities to the client
+	void AddSnapshotToClient(FClient& Client, const TArray<FSLRawDataEntityDesc>& Entities);
+
+	// Add the subscribed entities the client did not receive yet to the client frame
+	static void AddMissingEntities(FClient& Client, const TArray<FSLRawDataEntityDesc>& Entities, FSLRawDataFrame& OutFrame);
+
+	// Write the client frame as a record to the client, unless it is empty
+	void WriteClientFrame(FClient& Client);
+
+	// Keep the poses of the frame as the last poses
+	void UpdateLastPoses(const FSLRawDataFrame& Frame);
+
+	// Check the entities added since the last call against the subscribed classes
+	static void UpdateMatches(FClient& Client, const TArray<FSLRawDataEntityDesc>& Entities);
+
+	// Read the received bytes, false if disconnected
+	static bool ReceiveFromClient(FClient& Client);
+
+	// Send as much of the pending bytes as the socket takes, false if disconnected
+	bool SendToClient(FClient& Client);
+
+	// Set the subscribed classes from a received line
+	static void ParseLine(FClient& Client, const FString& Line);
+
+	// Close the connection
+	static void CloseClient(FClient& Client);
+
+	// Longest subscription line
+	static const int32 MaxLineLength = 4096;
+
+	// Listening socket
+	FSocket* ListenSocket;
+
+	// Accepts the connections on its own thread
+	FTcpListener* Listener;
+
+	// Accepted connections not yet taken over by the sink thread
+	TQueue<FSocket*, EQueueMode::Mpsc> NewSockets;
+
+	// Connected clients (sink thread)
+	TArray<FClient> Clients;
+
+	// Number of connected clients
+	std::atomic<int32> NumClients;
+
+	// Most unsent bytes of a client before its frames are dropped
+	int32 MaxClientBacklog;
+
+	// Binary serialization buffer
+	FSLRawDataBinaryWriter BinaryWriter;
+
+	// Stream header (framed header and the binary header record)
+	TArray<uint8> StreamHeader;
+
+	// Frame with the subscribed poses of a client
+	FSLRawDataFrame ClientFrame;
+
+	// Last pose of every entity (first) and of its bones (by BoneIndex + 1), indexed by EntityIndex,
+	// poses never seen have an EntityIndex of INDEX_NONE
+	TArray<TArray<FSLRawDataPose>> LastPoses;
+
+	// Timestamp of the last consumed frame
+	float LastTimestamp;
+};
@@ -107,14 +107,126 @@ private:
 	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"), meta = (ClampMin = 0))
 	float RawDataDistanceThreshold;
 
+	// Angular (degrees) threshold for logging raw data (0 to only log on movement)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"), meta = (ClampMin = 0, ClampMax = 180))
+	float RawDataAngularThreshold;
+
+	// Number of updates between raw data keyframes, all dynamic entities are written with all their bones (0 to disable)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"), meta = (ClampMin = 0))
+	int32 RawDataKeyframeInterval;
+
 	// Update rate in seconds (if 0, or smaller than the Tick's DeltaTime, it will update every tick)
 	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"), meta = (ClampMin = 0))
 	float RawDataUpdateRate;
 
+	// Sample at exact multiples of the update rate, poses are interpolated between ticks (update rate has to be > 0)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	uint32 bRawDataFixedTimestep : 1;
+
+	// Most samples written in one tick after a slow frame, older samples are skipped
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bRawDataFixedTimestep"), meta = (ClampMin = 1))
+	int32 RawDataMaxCatchUpSamples;
+
+	// Sampling periods (s) per entity class, overridden by the SamplingPeriod key of the SemLog tag
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	TMap<FString, float> RawDataClassSamplingPeriods;
+
+	// Sample entities at a higher rate while they move fast, and at a lower one while idle
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	uint32 bRawDataAdaptiveSampling : 1;
+
+	// Longest time (s) between two samples of an idle entity in the adaptive mode
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bRawDataAdaptiveSampling"), meta = (ClampMin = 0))
+	float RawDataMaxSamplingPeriod;
+
 	// Write data to file
 	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
 	uint32 bWriteRawDataToFile : 1;
 
+	// Raw data file format
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToFile"))
+	ESLRawDataFormat RawDataFormat;
+
+	// Quantize the raw data poses (positions to the precision, rotations to the smallest three 15 bit components)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	uint32 bQuantizeRawData : 1;
+
+	// Precision (cm) of the quantized positions
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bQuantizeRawData"), meta = (ClampMin = 0.001))
+	float RawDataPositionPrecision;
+
+	// Precision (cm) of the quantized positions per entity class, overridden by the Precision key of the SemLog tag
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bQuantizeRawData"))
+	TMap<FString, float> RawDataClassPositionPrecisions;
+
+	// Write the quantized binary poses as differences to the previous ones, keyframes hold absolute values
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bQuantizeRawData"))
+	uint32 bDeltaEncodeRawData : 1;
+
+	// Compress the raw data file in seekable zlib blocks (.slz)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToFile"))
+	uint32 bCompressRawData : 1;
+
+	// Write every raw data frame as a record with its size and CRC32 (.slf), ignored if compressed
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToFile"))
+	uint32 bFrameRawData : 1;
+
+	// Number of frames the file writer thread can have queued
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToFile"), meta = (ClampMin = 2))
+	int32 RawDataWriterQueueSize;
+
+	// What to do when the file writer thread queue is full
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToFile"))
+	ESLRawDataQueuePolicy RawDataWriterQueuePolicy;
+
+	// Write data to the mongo database (built with WITH_MONGO), one collection per episode
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	uint32 bWriteRawDataToMongo : 1;
+
+	// Mongo server uri
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToMongo"))
+	FString RawDataMongoUri;
+
+	// Mongo database name
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToMongo"))
+	FString RawDataMongoDatabase;
+
+	// Most frames sent in one bulk insert
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToMongo"), meta = (ClampMin = 1))
+	int32 RawDataMongoBatchSize;
+
+	// Longest time (s) a frame waits before being sent
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bWriteRawDataToMongo"), meta = (ClampMin = 0))
+	float RawDataMongoFlushInterval;
+
+	// Stream data to local clients over TCP
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	uint32 bStreamRawData : 1;
+
+	// Local port of the stream server
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bStreamRawData"), meta = (ClampMin = 1, ClampMax = 65535))
+	int32 RawDataStreamPort;
+
+	// Most unsent data (KB) of a client before its frames are dropped
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bStreamRawData"), meta = (ClampMin = 1))
+	int32 RawDataStreamMaxClientBacklog;
+
+	// Publish data into a shared memory ring for local readers
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
+	uint32 bPublishRawDataToSharedMemory : 1;
+
+	// Name of the shared memory region (/dev/shm/<Name> on Linux)
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bPublishRawDataToSharedMemory"))
+	FString RawDataSharedMemoryName;
+
+	// Number of frames kept in the shared memory ring
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bPublishRawDataToSharedMemory"), meta = (ClampMin = 2))
+	int32 RawDataSharedMemorySlots;
+
+	// Most poses of a shared memory frame, larger frames are truncated
+	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bPublishRawDataToSharedMemory"), meta = (ClampMin = 1))
+	int32 RawDataSharedMemoryMaxPoses;
+
 	// Broadcast data
 	UPROPERTY(EditAnywhere, Category = "SL|Raw Data Logger", meta = (editcondition = "bLogRawData"))
 	uint32 bBroadcastRawData : 1;
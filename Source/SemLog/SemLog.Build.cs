@@ -43,6 +43,8 @@ public class SemLog : ModuleRules
 				"SlateCore",
 				"Json",
 				"JsonUtilities",
+				"Sockets",
+				"Networking",
 				"UTags",
 				"libmongo"
 				// ... add private dependencies that you statically link with here ...	
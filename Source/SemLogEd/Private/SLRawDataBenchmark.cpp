@@ -0,0 +1,419 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataBenchmark.h"
+#include "SLEdModule.h"
+#include "SLRawDataJson.h"
+#include "SLRawDataMotion.h"
+#include "SLRawDataBinary.h"
+#include "SLRawDataCompression.h"
+#include "SLRawDataBson.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+// Frames between two keyframes of the synthetic episode
+static const int32 KeyframeInterval = 60;
+
+// Bones of the skeletal entities
+static const int32 NumBones = 30;
+
+// Entities times frames of the default episodes
+static const int32 DefaultNumEntityFrames = 1000000;
+
+// Create Json object with name location and rotation (previous logger path)
+static TSharedPtr<FJsonObject> CreateNameLocRotJsonObject(const FString& Name, const FVector& Location, const FQuat& Rotation)
+{
+	TSharedPtr<FJsonObject> LocObj = MakeShareable(new FJsonObject);
+	LocObj->SetNumberField("x", Location.X);
+	LocObj->SetNumberField("y", -Location.Y); // left to right handed
+	LocObj->SetNumberField("z", Location.Z);
+
+	TSharedPtr<FJsonObject> RotObj = MakeShareable(new FJsonObject);
+	RotObj->SetNumberField("w", Rotation.W);
+	RotObj->SetNumberField("x", -Rotation.X); // left to right handed
+	RotObj->SetNumberField("y", Rotation.Y);
+	RotObj->SetNumberField("z", -Rotation.Z); // left to right handed
+
+	TSharedPtr<FJsonObject> JsonObj = MakeShareable(new FJsonObject);
+	JsonObj->SetStringField("name", Name);
+	JsonObj->SetObjectField("pos", LocObj);
+	JsonObj->SetObjectField("rot", RotObj);
+	return JsonObj;
+}
+
+// Serialize the frame the way the logger did before the json writer
+static void SerializeWithJsonObjects(const FSLRawDataFrame& Frame, const TArray<FSLRawDataEntityDesc>& Entities,
+	FString& OutString)
+{
+	TSharedPtr<FJsonObject> JsonRootObj = MakeShareable(new FJsonObject);
+	JsonRootObj->SetNumberField("timestamp", Frame.Timestamp);
+
+	TArray<TSharedPtr<FJsonValue>> JsonActorArr;
+	TSharedPtr<FJsonObject> JsonActorObj;
+	TArray<TSharedPtr<FJsonValue>> JsonBoneArr;
+	for (const auto& PoseItr : Frame.Poses)
+	{
+		const FSLRawDataEntityDesc& Entity = Entities[PoseItr.EntityIndex];
+		if (PoseItr.BoneIndex == INDEX_NONE)
+		{
+			if (JsonBoneArr.Num() > 0)
+			{
+				JsonActorObj->SetArrayField("bones", JsonBoneArr);
+				JsonBoneArr.Empty();
+			}
+			JsonActorObj = CreateNameLocRotJsonObject(Entity.UniqueName, PoseItr.Location * 0.01f, PoseItr.Rotation);
+			JsonActorArr.Add(MakeShareable(new FJsonValueObject(JsonActorObj)));
+		}
+		else
+		{
+			JsonBoneArr.Add(MakeShareable(new FJsonValueObject(CreateNameLocRotJsonObject(
+				Entity.BoneNames[PoseItr.BoneIndex], PoseItr.Location * 0.01f, PoseItr.Rotation))));
+		}
+	}
+	if (JsonBoneArr.Num() > 0)
+	{
+		JsonActorObj->SetArrayField("bones", JsonBoneArr);
+	}
+	JsonRootObj->SetArrayField("actors", JsonActorArr);
+
+	OutString.Reset();
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutString);
+	FJsonSerializer::Serialize(JsonRootObj.ToSharedRef(), Writer);
+}
+
+// Run the named benchmark (or all of them), false if the name is unknown
+bool FSLRawDataBenchmark::Run(const FString& Name, const FString& Params)
+{
+	const bool bAll = Name.Equals(TEXT("All"), ESearchCase::IgnoreCase);
+	const bool bJson = bAll || Name.Equals(TEXT("Json"), ESearchCase::IgnoreCase);
+	const bool bThreshold = bAll || Name.Equals(TEXT("Threshold"), ESearchCase::IgnoreCase);
+	const bool bCompression = bAll || Name.Equals(TEXT("Compression"), ESearchCase::IgnoreCase);
+	const bool bBson = bAll || Name.Equals(TEXT("Bson"), ESearchCase::IgnoreCase);
+	if (!bJson && !bThreshold && !bCompression && !bBson)
+	{
+		UE_LOG(LogSLEd, Error, TEXT("Unknown benchmark %s (Json, Threshold, Compression, Bson, All)"), *Name);
+		return false;
+	}
+
+	// Without a given size the benchmarks run at 100, 1k and 10k entities
+	TArray<int32> EntityCounts = { 100, 1000, 10000 };
+	int32 NumEntities = 0;
+	if (FParse::Value(*Params, TEXT("Entities="), NumEntities))
+	{
+		EntityCounts = { FMath::Max(NumEntities, 1) };
+	}
+
+	for (const int32 EntityCount : EntityCounts)
+	{
+		// By default about a million entity updates per episode
+		int32 NumFrames = FMath::Clamp(DefaultNumEntityFrames / EntityCount, KeyframeInterval, 1000);
+		FParse::Value(*Params, TEXT("Frames="), NumFrames);
+		NumFrames = FMath::Max(NumFrames, 1);
+
+		FSLRawDataBenchmarkEpisode Episode;
+		FSLRawDataBenchmark::MakeEpisode(NumFrames, EntityCount, Episode);
+		int32 NumPoses = 0;
+		for (const auto& FrameItr : Episode.Frames)
+		{
+			NumPoses += FrameItr.Poses.Num();
+		}
+		UE_LOG(LogSLEd, Display, TEXT("Benchmark episode: %d frames, %d entities, %.1f poses per frame"),
+			NumFrames, EntityCount, (float)NumPoses / NumFrames);
+
+		if (bJson)
+		{
+			FSLRawDataBenchmark::RunJson(Episode);
+		}
+		if (bThreshold)
+		{
+			FSLRawDataBenchmark::RunThreshold(EntityCount);
+		}
+		if (bCompression)
+		{
+			FSLRawDataBenchmark::RunCompression(Episode);
+		}
+		if (bBson)
+		{
+			FSLRawDataBenchmark::RunBson(Episode);
+		}
+	}
+	return true;
+}
+
+// Create the synthetic episode
+void FSLRawDataBenchmark::MakeEpisode(int32 NumFrames, int32 NumEntities, FSLRawDataBenchmarkEpisode& OutEpisode)
+{
+	FRandomStream Random(42);
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+	for (int32 EntityIdx = 0; EntityIdx < NumEntities; ++EntityIdx)
+	{
+		const bool bIsSkeletal = EntityIdx % 10 == 0;
+		FSLRawDataEntityDesc& Entity = OutEpisode.Entities[OutEpisode.Entities.Emplace(EntityIdx,
+			FString::Printf(TEXT("%s_%d"), bIsSkeletal ? TEXT("Hand") : TEXT("Cup"), EntityIdx))];
+		for (int32 BoneIdx = 0; bIsSkeletal && BoneIdx < NumBones; ++BoneIdx)
+		{
+			Entity.BoneNames.Add(FString::Printf(TEXT("finger_%d_%d"), BoneIdx / 3, BoneIdx % 3));
+		}
+		Locations.Add(Random.VRand() * Random.FRandRange(50.f, 500.f));
+		Rotations.Add(FQuat(Random.VRand(), Random.FRandRange(0.f, PI)));
+	}
+
+	OutEpisode.Frames.SetNum(NumFrames);
+	for (int32 FrameIdx = 0; FrameIdx < NumFrames; ++FrameIdx)
+	{
+		FSLRawDataFrame& Frame = OutEpisode.Frames[FrameIdx];
+		Frame.Timestamp = FrameIdx / 60.f;
+		Frame.bIsKeyframe = FrameIdx % KeyframeInterval == 0;
+		if (FrameIdx == 0)
+		{
+			Frame.NewEntities = OutEpisode.Entities;
+		}
+		for (int32 EntityIdx = 0; EntityIdx < NumEntities; ++EntityIdx)
+		{
+			if (!Frame.bIsKeyframe && (EntityIdx + FrameIdx) % 4 != 0)
+			{
+				continue;
+			}
+			Locations[EntityIdx] += Random.VRand() * 0.5f;
+			Rotations[EntityIdx] = FQuat(Random.VRand(), 0.01f) * Rotations[EntityIdx];
+			Frame.Poses.Emplace(EntityIdx, INDEX_NONE, Locations[EntityIdx], Rotations[EntityIdx]);
+			for (int32 BoneIdx = 0; BoneIdx < OutEpisode.Entities[EntityIdx].BoneNames.Num(); ++BoneIdx)
+			{
+				Frame.Poses.Emplace(EntityIdx, BoneIdx, Locations[EntityIdx] + FVector(BoneIdx, 0.f, 2.f),
+					Rotations[EntityIdx]);
+			}
+		}
+	}
+}
+
+// Json writer vs. json objects serialized into a string (the previous logger path)
+void FSLRawDataBenchmark::RunJson(const FSLRawDataBenchmarkEpisode& Episode)
+{
+	// Previous path, the string is converted to ANSI as it was for the file
+	FString JsonString;
+	TArray<uint8> OutBytes;
+	int64 NumObjectBytes = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (const auto& FrameItr : Episode.Frames)
+	{
+		SerializeWithJsonObjects(FrameItr, Episode.Entities, JsonString);
+		OutBytes.Append((const uint8*)TCHAR_TO_ANSI(*JsonString), JsonString.Len());
+		NumObjectBytes += OutBytes.Num();
+		OutBytes.Reset();
+	}
+	const double ObjectTime = FPlatformTime::Seconds() - StartTime;
+	FSLRawDataBenchmark::LogResult(TEXT("Json objects"), ObjectTime, Episode.Frames.Num(), NumObjectBytes);
+
+	FSLRawDataJsonWriter JsonWriter;
+	int64 NumWriterBytes = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (const auto& FrameItr : Episode.Frames)
+	{
+		JsonWriter.WriteFrame(FrameItr, Episode.Entities);
+		NumWriterBytes += JsonWriter.GetBuffer().Num();
+		JsonWriter.Reset();
+	}
+	const double WriterTime = FPlatformTime::Seconds() - StartTime;
+	FSLRawDataBenchmark::LogResult(TEXT("Json writer"), WriterTime, Episode.Frames.Num(), NumWriterBytes);
+
+	UE_LOG(LogSLEd, Display, TEXT("Json writer speedup: %.1fx"), WriterTime > 0.0 ? ObjectTime / WriterTime : 0.0);
+}
+
+// Vectorized change checks vs. the per entity distance and rotation checks
+void FSLRawDataBenchmark::RunThreshold(int32 NumEntities)
+{
+	// A quarter of the entities move past the threshold, every seventh rotates past it
+	FRandomStream Random(42);
+	TArray<FVector> PrevLocations, CurrLocations;
+	TArray<FQuat> PrevRotations, CurrRotations;
+	TArray<float> SquaredDistanceThresholds, MinQuatDots;
+	for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+	{
+		PrevLocations.Add(Random.VRand() * 100.f);
+		CurrLocations.Add(PrevLocations[Idx] + Random.VRand() * (Idx % 4 == 0 ? 2.f : 0.1f));
+		PrevRotations.Add(FQuat(Random.VRand(), Random.FRandRange(0.f, PI)));
+		CurrRotations.Add(Idx % 7 == 0 ? FQuat(FVector::UpVector, 0.1f) * PrevRotations[Idx] : PrevRotations[Idx]);
+		SquaredDistanceThresholds.Add(1.f);
+		MinQuatDots.Add(FSLRawDataMotion::AngularThresholdToMinQuatDot(1.f));
+	}
+
+	// Enough iterations for about twenty million checks
+	const int32 NumIterations = FMath::Max(20000000 / NumEntities, 1);
+	TArray<bool> ScalarMoved;
+	ScalarMoved.SetNumZeroed(NumEntities);
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+		{
+			ScalarMoved[Idx] = FVector::DistSquared(CurrLocations[Idx], PrevLocations[Idx]) > SquaredDistanceThresholds[Idx] ||
+				FMath::Abs(CurrRotations[Idx] | PrevRotations[Idx]) < MinQuatDots[Idx];
+		}
+	}
+	const double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+	TArray<uint32> MovedMask;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		FSLRawDataMotion::ComputeMovedMask(CurrLocations.GetData(), PrevLocations.GetData(),
+			SquaredDistanceThresholds.GetData(), NumEntities, MovedMask);
+		FSLRawDataMotion::AddRotatedToMask(CurrRotations.GetData(), PrevRotations.GetData(),
+			MinQuatDots.GetData(), NumEntities, MovedMask);
+	}
+	const double VectorTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumMismatches = 0;
+	for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+	{
+		NumMismatches += ScalarMoved[Idx] != FSLRawDataMotion::IsSet(MovedMask, Idx) ? 1 : 0;
+	}
+
+	const double NumChecks = (double)NumIterations * NumEntities;
+	UE_LOG(LogSLEd, Display, TEXT("Threshold: per entity %.2f ns/entity, vectorized %.2f ns/entity, speedup %.2fx, %d mismatches"),
+		ScalarTime * 1e9 / NumChecks, VectorTime * 1e9 / NumChecks,
+		VectorTime > 0.0 ? ScalarTime / VectorTime : 0.0, NumMismatches);
+}
+
+// Size and speed of the block compression of the json and the binary stream
+void FSLRawDataBenchmark::RunCompression(const FSLRawDataBenchmarkEpisode& Episode)
+{
+	const FString TempPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SLRawDataBenchmark.slz"));
+	for (const bool bBinary : { false, true })
+	{
+		// Same steps as the file sink, binary blocks start with the known entities
+		FSLRawDataJsonWriter JsonWriter;
+		FSLRawDataBinaryWriter BinaryWriter;
+		FSLRawDataCompressedWriter CompressedWriter;
+		TArray<uint8> CompressedBytes;
+		if (bBinary)
+		{
+			BinaryWriter.WriteHeader();
+		}
+		CompressedWriter.Init(BinaryWriter.GetBuffer());
+		CompressedWriter.WriteHeader(CompressedBytes);
+		BinaryWriter.Reset();
+
+		int64 NumUncompressedBytes = 0;
+		int32 NumWrittenEntities = 0;
+		double CompressTime = 0.0;
+		for (const auto& FrameItr : Episode.Frames)
+		{
+			if (bBinary)
+			{
+				if (CompressedWriter.IsBlockEmpty())
+				{
+					BinaryWriter.WriteEntities(Episode.Entities, NumWrittenEntities);
+					BinaryWriter.ResetDeltas();
+				}
+				BinaryWriter.WriteFrame(FrameItr);
+			}
+			else
+			{
+				JsonWriter.WriteFrame(FrameItr, Episode.Entities);
+			}
+			NumWrittenEntities += FrameItr.NewEntities.Num();
+			const TArray<uint8>& FrameBytes = bBinary ? BinaryWriter.GetBuffer() : JsonWriter.GetBuffer();
+			NumUncompressedBytes += FrameBytes.Num();
+
+			// Only the compression is timed
+			const double StartTime = FPlatformTime::Seconds();
+			CompressedWriter.AddFrame(FrameBytes, FrameItr.Timestamp, CompressedBytes);
+			CompressTime += FPlatformTime::Seconds() - StartTime;
+			BinaryWriter.Reset();
+			JsonWriter.Reset();
+		}
+		double StartTime = FPlatformTime::Seconds();
+		CompressedWriter.Finish(CompressedBytes);
+		CompressTime += FPlatformTime::Seconds() - StartTime;
+
+		// Decompress every block through the seek index
+		double DecompressTime = 0.0;
+		int32 NumBlocks = 0;
+		FSLRawDataCompressedReader CompressedReader;
+		if (FFileHelper::SaveArrayToFile(CompressedBytes, *TempPath) && CompressedReader.Open(TempPath))
+		{
+			NumBlocks = CompressedReader.GetIndex().Num();
+			TArray<uint8> BlockBytes;
+			StartTime = FPlatformTime::Seconds();
+			for (int32 BlockIdx = 0; BlockIdx < NumBlocks; ++BlockIdx)
+			{
+				CompressedReader.ReadBlock(BlockIdx, BlockBytes);
+				BlockBytes.Reset();
+			}
+			DecompressTime = FPlatformTime::Seconds() - StartTime;
+			CompressedReader.Close();
+		}
+		IFileManager::Get().Delete(*TempPath);
+
+		const double UncompressedMB = NumUncompressedBytes / (1024.0 * 1024.0);
+		UE_LOG(LogSLEd, Display, TEXT("Compression %s: %.1f MB -> %.1f MB (ratio %.2f), %d blocks, compress %.1f MB/s, decompress %.1f MB/s"),
+			bBinary ? TEXT("binary") : TEXT("json"), UncompressedMB, CompressedBytes.Num() / (1024.0 * 1024.0),
+			CompressedBytes.Num() > 0 ? (double)NumUncompressedBytes / CompressedBytes.Num() : 0.0, NumBlocks,
+			CompressTime > 0.0 ? UncompressedMB / CompressTime : 0.0,
+			DecompressTime > 0.0 ? UncompressedMB / DecompressTime : 0.0);
+	}
+}
+
+// Bson writer vs. the json bytes parsed with bson_new_from_json (needs WITH_MONGO)
+void FSLRawDataBenchmark::RunBson(const FSLRawDataBenchmarkEpisode& Episode)
+{
+#ifdef WITH_MONGO
+	// Previous path, the json frame is written and parsed into a new document
+	FSLRawDataJsonWriter JsonWriter;
+	bson_error_t Error;
+	int64 NumParsedBytes = 0;
+	int32 NumFailed = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (const auto& FrameItr : Episode.Frames)
+	{
+		JsonWriter.WriteFrame(FrameItr, Episode.Entities);
+		bson_t* Document = bson_new_from_json(JsonWriter.GetBuffer().GetData(), JsonWriter.GetBuffer().Num(), &Error);
+		if (Document)
+		{
+			NumParsedBytes += Document->len;
+			bson_destroy(Document);
+		}
+		else
+		{
+			NumFailed++;
+		}
+		JsonWriter.Reset();
+	}
+	const double ParseTime = FPlatformTime::Seconds() - StartTime;
+	FSLRawDataBenchmark::LogResult(TEXT("Json to bson"), ParseTime, Episode.Frames.Num(), NumParsedBytes);
+	if (NumFailed > 0)
+	{
+		UE_LOG(LogSLEd, Warning, TEXT("Json to bson: %d frames could not be parsed"), NumFailed);
+	}
+
+	FSLRawDataBsonWriter BsonWriter;
+	int64 NumWriterBytes = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (const auto& FrameItr : Episode.Frames)
+	{
+		BsonWriter.WriteFrame(FrameItr, Episode.Entities);
+		NumWriterBytes += BsonWriter.GetSize();
+	}
+	const double WriterTime = FPlatformTime::Seconds() - StartTime;
+	FSLRawDataBenchmark::LogResult(TEXT("Bson writer"), WriterTime, Episode.Frames.Num(), NumWriterBytes);
+
+	UE_LOG(LogSLEd, Display, TEXT("Bson writer speedup: %.1fx"), WriterTime > 0.0 ? ParseTime / WriterTime : 0.0);
+#else
+	UE_LOG(LogSLEd, Warning, TEXT("Bson benchmark skipped, built without WITH_MONGO"));
+#endif //WITH_MONGO
+}
+
+// Log the time and throughput of a run
+void FSLRawDataBenchmark::LogResult(const TCHAR* Name, double Seconds, int32 NumFrames, int64 NumBytes)
+{
+	UE_LOG(LogSLEd, Display, TEXT("%s: %.3fs, %.1f us/frame, %.1f bytes/frame, %.1f MB/s"), Name, Seconds,
+		Seconds * 1e6 / NumFrames, (double)NumBytes / NumFrames,
+		Seconds > 0.0 ? NumBytes / (1024.0 * 1024.0) / Seconds : 0.0);
+}
@@ -0,0 +1,50 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SLRawDataFrame.h"
+
+/**
+* Synthetic episode, the first frame holds the new entities
+*/
+struct FSLRawDataBenchmarkEpisode
+{
+	// Entities indexed by EntityIndex
+	TArray<FSLRawDataEntityDesc> Entities;
+
+	// Captured frames
+	TArray<FSLRawDataFrame> Frames;
+};
+
+/**
+* Micro benchmarks of the raw data writers on a synthetic episode, e.g.:
+*	UE4Editor-Cmd.exe <Project> -run=SLRawData -Benchmark=<Json|Threshold|Compression|Bson|All> [-Frames=<Num>] [-Entities=<Num>]
+* at 100, 1k and 10k entities unless given; every tenth entity is skeletal,
+* a quarter of the entities move between keyframes; results are logged
+*/
+struct FSLRawDataBenchmark
+{
+	// Run the named benchmark (or all of them), false if the name is unknown
+	static bool Run(const FString& Name, const FString& Params);
+
+private:
+	// Create the synthetic episode
+	static void MakeEpisode(int32 NumFrames, int32 NumEntities, FSLRawDataBenchmarkEpisode& OutEpisode);
+
+	// Json writer vs. json objects serialized into a string (the previous logger path)
+	static void RunJson(const FSLRawDataBenchmarkEpisode& Episode);
+
+	// Vectorized change checks vs. the per entity distance and rotation checks
+	static void RunThreshold(int32 NumEntities);
+
+	// Size and speed of the block compression of the json and the binary stream
+	static void RunCompression(const FSLRawDataBenchmarkEpisode& Episode);
+
+	// Bson writer vs. the json bytes parsed with bson_new_from_json (needs WITH_MONGO)
+	static void RunBson(const FSLRawDataBenchmarkEpisode& Episode);
+
+	// Log the time and throughput of a run
+	static void LogResult(const TCHAR* Name, double Seconds, int32 NumFrames, int64 NumBytes);
+};
@@ -0,0 +1,284 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "SLRawDataCommandlet.h"
+#include "SLEdModule.h"
+#include "SLRawDataEpisodeReader.h"
+#include "SLRawDataBinary.h"
+#include "SLRawDataFraming.h"
+#include "SLRawDataBenchmark.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Number of frames parsed in parallel before they are written
+static const int32 FramesPerBatch = 4096;
+
+// Json actor with its bones, before the names are mapped to indices
+struct FSLParsedActor
+{
+	FString Name;
+	FVector Location;
+	FQuat Rotation;
+	TArray<FString> BoneNames;
+	TArray<FVector> BoneLocations;
+	TArray<FQuat> BoneRotations;
+};
+
+// Json frame
+struct FSLParsedFrame
+{
+	bool bIsValid;
+	bool bIsKeyframe;
+	TArray<FSLParsedActor> Actors;
+};
+
+// Parse the json frame (thread safe, no shared state)
+static bool ParseJsonFrame(const uint8* Bytes, int32 Size, FSLParsedFrame& OutFrame)
+{
+	OutFrame.bIsKeyframe = false;
+	OutFrame.Actors.Reset();
+
+	FUTF8ToTCHAR Converter((const ANSICHAR*)Bytes, Size);
+	const FString JsonString(Converter.Length(), Converter.Get());
+	TSharedPtr<FJsonObject> FrameObject;
+	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
+	const TArray<TSharedPtr<FJsonValue>>* Actors = nullptr;
+	if (!FJsonSerializer::Deserialize(JsonReader, FrameObject) || !FrameObject.IsValid() ||
+		!FrameObject->TryGetArrayField("actors", Actors))
+	{
+		return false;
+	}
+	FrameObject->TryGetBoolField("keyframe", OutFrame.bIsKeyframe);
+
+	for (const auto& ActorItr : *Actors)
+	{
+		const TSharedPtr<FJsonObject> ActorObject = ActorItr->AsObject();
+		FSLParsedActor& Actor = OutFrame.Actors[OutFrame.Actors.AddDefaulted()];
+		if (!ActorObject.IsValid() || !ActorObject->TryGetStringField("name", Actor.Name) ||
+			!FSLRawDataEpisodeReader::ReadJsonPose(ActorObject, Actor.Location, Actor.Rotation))
+		{
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* Bones = nullptr;
+		if (ActorObject->TryGetArrayField("bones", Bones))
+		{
+			for (const auto& BoneItr : *Bones)
+			{
+				const TSharedPtr<FJsonObject> BoneObject = BoneItr->AsObject();
+				FString BoneName;
+				FVector Location;
+				FQuat Rotation;
+				if (!BoneObject.IsValid() || !BoneObject->TryGetStringField("name", BoneName) ||
+					!FSLRawDataEpisodeReader::ReadJsonPose(BoneObject, Location, Rotation))
+				{
+					return false;
+				}
+				Actor.BoneNames.Add(BoneName);
+				Actor.BoneLocations.Add(Location);
+				Actor.BoneRotations.Add(Rotation);
+			}
+		}
+	}
+	return true;
+}
+
+// Constructor
+USLRawDataCommandlet::USLRawDataCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+// Index and convert the episode
+int32 USLRawDataCommandlet::Main(const FString& Params)
+{
+	FString Benchmark;
+	if (FParse::Value(*Params, TEXT("Benchmark="), Benchmark))
+	{
+		return FSLRawDataBenchmark::Run(Benchmark, Params) ? 0 : 1;
+	}
+
+	FString InputPath;
+	if (!FParse::Value(*Params, TEXT("Input="), InputPath))
+	{
+		UE_LOG(LogSLEd, Error, TEXT("Usage: -run=SLRawData -Input=<RawData_Id.json> [-Convert=Binary] [-Output=<Path>] [-Framed]"));
+		UE_LOG(LogSLEd, Error, TEXT("   or: -run=SLRawData -Benchmark=<Name|All> [-Frames=<Num>] [-Entities=<Num>]"));
+		return 1;
+	}
+
+	// Open builds the index on all cores and saves it next to the file
+	const double StartTime = FPlatformTime::Seconds();
+	FSLRawDataEpisodeReader Reader;
+	if (!Reader.Open(InputPath, true))
+	{
+		UE_LOG(LogSLEd, Error, TEXT("Could not index %s"), *InputPath);
+		return 1;
+	}
+	const double IndexTime = FPlatformTime::Seconds() - StartTime;
+	const int64 FileSize = IFileManager::Get().FileSize(*InputPath);
+	UE_LOG(LogSLEd, Display, TEXT("Indexed %d frames of %s in %.2fs (%.1f MB/s)"), Reader.NumFrames(), *InputPath,
+		IndexTime, IndexTime > 0.0 ? FileSize / (1024.0 * 1024.0) / IndexTime : 0.0);
+
+	FString Convert;
+	if (!FParse::Value(*Params, TEXT("Convert="), Convert))
+	{
+		return 0;
+	}
+	if (!Convert.Equals(TEXT("Binary"), ESearchCase::IgnoreCase))
+	{
+		UE_LOG(LogSLEd, Error, TEXT("Unknown conversion format %s, only Binary is supported"), *Convert);
+		return 1;
+	}
+	if (!Reader.IsJson())
+	{
+		UE_LOG(LogSLEd, Error, TEXT("%s is not a json episode"), *InputPath);
+		return 1;
+	}
+
+	const bool bFramed = FParse::Param(*Params, TEXT("Framed"));
+	FString OutputPath;
+	if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		OutputPath = FPaths::ChangeExtension(InputPath, TEXT("bin")) + (bFramed ? TEXT(".slf") : TEXT(""));
+	}
+
+	const double ConvertStartTime = FPlatformTime::Seconds();
+	if (!USLRawDataCommandlet::ConvertToBinary(Reader, OutputPath, bFramed))
+	{
+		UE_LOG(LogSLEd, Error, TEXT("Could not convert %s to %s"), *InputPath, *OutputPath);
+		return 1;
+	}
+	const double ConvertTime = FPlatformTime::Seconds() - ConvertStartTime;
+	UE_LOG(LogSLEd, Display, TEXT("Converted to %s in %.2fs (%.1f MB/s)"), *OutputPath,
+		ConvertTime, ConvertTime > 0.0 ? FileSize / (1024.0 * 1024.0) / ConvertTime : 0.0);
+	return 0;
+}
+
+// Parse the json frames on all cores and write them in the binary format
+bool USLRawDataCommandlet::ConvertToBinary(const FSLRawDataEpisodeReader& Reader, const FString& OutPath, bool bFramed)
+{
+	IFileHandle* FileHandle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*OutPath);
+	if (!FileHandle)
+	{
+		return false;
+	}
+
+	FSLRawDataBinaryWriter BinaryWriter;
+	TArray<uint8> OutBytes;
+	BinaryWriter.WriteHeader();
+	if (bFramed)
+	{
+		FSLRawDataFramed::WriteHeader(OutBytes);
+		FSLRawDataFramed::WriteRecord(BinaryWriter.GetBuffer().GetData(), BinaryWriter.GetBuffer().Num(), OutBytes);
+	}
+	else
+	{
+		OutBytes.Append(BinaryWriter.GetBuffer());
+	}
+	BinaryWriter.Reset();
+
+	// Names are given indices in file order
+	TArray<FSLRawDataEntityDesc> Entities;
+	TMap<FString, int32> EntityNameToIndex;
+	TArray<TMap<FString, int32>> BoneNameToIndex;
+
+	TArray<FSLParsedFrame> ParsedFrames;
+	ParsedFrames.SetNum(FramesPerBatch);
+	FSLRawDataFrame Frame;
+	int32 NumSkipped = 0;
+	bool bWritten = true;
+	const TArray<FSLRawDataFrameIndexEntry>& Index = Reader.GetIndex();
+	for (int32 BatchStart = 0; BatchStart < Index.Num() && bWritten; BatchStart += FramesPerBatch)
+	{
+		const int32 NumFrames = FMath::Min(FramesPerBatch, Index.Num() - BatchStart);
+		ParallelFor(NumFrames, [&](int32 Idx)
+		{
+			const uint8* Bytes = nullptr;
+			int32 Size = 0;
+			ParsedFrames[Idx].bIsValid = Reader.GetFrameBytes(BatchStart + Idx, Bytes, Size) &&
+				ParseJsonFrame(Bytes, Size, ParsedFrames[Idx]);
+		});
+
+		for (int32 Idx = 0; Idx < NumFrames; ++Idx)
+		{
+			const FSLParsedFrame& Parsed = ParsedFrames[Idx];
+			if (!Parsed.bIsValid)
+			{
+				NumSkipped++;
+				continue;
+			}
+
+			Frame.Reset();
+			Frame.Timestamp = (float)Index[BatchStart + Idx].Timestamp;
+			Frame.bIsKeyframe = Parsed.bIsKeyframe;
+			for (const auto& ActorItr : Parsed.Actors)
+			{
+				bool bDescChanged = false;
+				int32 EntityIndex;
+				if (const int32* FoundIndex = EntityNameToIndex.Find(ActorItr.Name))
+				{
+					EntityIndex = *FoundIndex;
+				}
+				else
+				{
+					EntityIndex = Entities.Emplace(Entities.Num(), ActorItr.Name);
+					EntityNameToIndex.Add(ActorItr.Name, EntityIndex);
+					BoneNameToIndex.AddDefaulted();
+					bDescChanged = true;
+				}
+				Frame.Poses.Emplace(EntityIndex, INDEX_NONE, ActorItr.Location, ActorItr.Rotation);
+
+				for (int32 BoneIdx = 0; BoneIdx < ActorItr.BoneNames.Num(); ++BoneIdx)
+				{
+					int32 BoneIndex;
+					if (const int32* FoundBone = BoneNameToIndex[EntityIndex].Find(ActorItr.BoneNames[BoneIdx]))
+					{
+						BoneIndex = *FoundBone;
+					}
+					else
+					{
+						BoneIndex = Entities[EntityIndex].BoneNames.Add(ActorItr.BoneNames[BoneIdx]);
+						BoneNameToIndex[EntityIndex].Add(ActorItr.BoneNames[BoneIdx], BoneIndex);
+						bDescChanged = true;
+					}
+					Frame.Poses.Emplace(EntityIndex, BoneIndex, ActorItr.BoneLocations[BoneIdx], ActorItr.BoneRotations[BoneIdx]);
+				}
+
+				// New entities, or entities with new bones, are (re)written before the frame
+				if (bDescChanged)
+				{
+					Frame.NewEntities.Add(Entities[EntityIndex]);
+				}
+			}
+
+			BinaryWriter.WriteFrame(Frame);
+			if (bFramed)
+			{
+				FSLRawDataFramed::WriteRecord(BinaryWriter.GetBuffer().GetData(), BinaryWriter.GetBuffer().Num(), OutBytes);
+			}
+			else
+			{
+				OutBytes.Append(BinaryWriter.GetBuffer());
+			}
+			BinaryWriter.Reset();
+		}
+
+		bWritten = FileHandle->Write(OutBytes.GetData(), OutBytes.Num());
+		OutBytes.Reset();
+	}
+	delete FileHandle;
+
+	if (NumSkipped > 0)
+	{
+		UE_LOG(LogSLEd, Warning, TEXT("Skipped %d frames which could not be parsed"), NumSkipped);
+	}
+	return bWritten;
+}
@@ -0,0 +1,150 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "SLRawDataCommandlet.h"
+#include "SLRawDataEpisodeReader.h"
+#include "SLRawDataJson.h"
+#include "SLRawDataBinary.h"
+#include "SLRawDataFraming.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "FileHelper.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Frames of the json episode
+static const int32 ConvertTestNumFrames = 20;
+
+// Frame from which the hand also moves its thumb, the entity is written again with the new bone
+static const int32 ConvertTestThumbFrame = 3;
+
+// Largest difference (cm) after the round trip through the json meters
+static const float ConvertTestTolerance = 1e-3f;
+
+// Entities of the json episode: a cup (0) and a two bone hand (1)
+static void MakeConvertTestEntities(TArray<FSLRawDataEntityDesc>& OutEntities)
+{
+	OutEntities.Reset();
+	OutEntities.Emplace(0, TEXT("Cup_1"));
+	OutEntities.Emplace(1, TEXT("Hand_2"));
+	OutEntities[1].BoneNames.Add(TEXT("palm"));
+	OutEntities[1].BoneNames.Add(TEXT("thumb"));
+}
+
+// Frame of the json episode, the thumb only moves from its frame on
+static void MakeConvertTestFrame(int32 FrameIdx, FSLRawDataFrame& OutFrame)
+{
+	OutFrame.Reset();
+	OutFrame.Timestamp = FrameIdx * 0.125f;
+	OutFrame.bIsKeyframe = FrameIdx % 10 == 0;
+	OutFrame.Poses.Emplace(0, INDEX_NONE, FVector(10.f + FrameIdx, -20.5f, 30.25f), FQuat(FVector::UpVector, FrameIdx * 0.1f));
+	OutFrame.Poses.Emplace(1, INDEX_NONE, FVector(-1.f, 2.f * FrameIdx, 3.f), FQuat::Identity);
+	OutFrame.Poses.Emplace(1, 0, FVector(-1.f, 2.f, 13.f), FQuat(FVector::ForwardVector, FrameIdx * -0.2f));
+	if (FrameIdx >= ConvertTestThumbFrame)
+	{
+		OutFrame.Poses.Emplace(1, 1, FVector(FrameIdx, 5.f, 13.f), FQuat(FVector::RightVector, 0.5f));
+	}
+}
+
+// Check the converted frames against the json ones
+static bool TestConvertTestFrames(FAutomationTestBase& Test, const FString& What,
+	const FSLRawDataBinaryReader& Reader, const TArray<FSLRawDataFrame>& Written)
+{
+	if (!Test.TestTrue(What + TEXT(" number of frames"), Reader.Frames.Num() == Written.Num()) ||
+		!Test.TestTrue(What + TEXT(" entities"), Reader.Entities.Num() == 2 &&
+			Reader.Entities[0].UniqueName == TEXT("Cup_1") && Reader.Entities[1].UniqueName == TEXT("Hand_2")) ||
+		!Test.TestTrue(What + TEXT(" bones of the rewritten entity"), Reader.Entities[1].BoneNames.Num() == 2 &&
+			Reader.Entities[1].BoneNames[0] == TEXT("palm") && Reader.Entities[1].BoneNames[1] == TEXT("thumb")))
+	{
+		return false;
+	}
+	bool bEqual = true;
+	for (int32 FrameIdx = 0; FrameIdx < Written.Num(); ++FrameIdx)
+	{
+		const FSLRawDataFrame& Expected = Written[FrameIdx];
+		const FSLRawDataFrame& Read = Reader.Frames[FrameIdx];
+		bool bFrameEqual = FMath::IsNearlyEqual(Read.Timestamp, Expected.Timestamp, KINDA_SMALL_NUMBER) &&
+			Read.bIsKeyframe == Expected.bIsKeyframe && Read.Poses.Num() == Expected.Poses.Num();
+		for (int32 PoseIdx = 0; bFrameEqual && PoseIdx < Expected.Poses.Num(); ++PoseIdx)
+		{
+			const FSLRawDataPose& ExpectedPose = Expected.Poses[PoseIdx];
+			const FSLRawDataPose& ReadPose = Read.Poses[PoseIdx];
+			bFrameEqual = ReadPose.EntityIndex == ExpectedPose.EntityIndex && ReadPose.BoneIndex == ExpectedPose.BoneIndex &&
+				ReadPose.Location.Equals(ExpectedPose.Location, ConvertTestTolerance) &&
+				ReadPose.Rotation.Equals(ExpectedPose.Rotation, KINDA_SMALL_NUMBER);
+		}
+		bEqual &= Test.TestTrue(What + FString::Printf(TEXT(" frame %d"), FrameIdx), bFrameEqual);
+	}
+	return bEqual;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLRawDataConvertToBinaryTest, "SemLog.RawData.ConvertToBinary",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Convert a json episode to plain and framed binary files and read them back
+bool FSLRawDataConvertToBinaryTest::RunTest(const FString& Parameters)
+{
+	TArray<FSLRawDataEntityDesc> Entities;
+	MakeConvertTestEntities(Entities);
+	TArray<FSLRawDataFrame> Written;
+	Written.SetNum(ConvertTestNumFrames);
+	FSLRawDataJsonWriter JsonWriter;
+	for (int32 FrameIdx = 0; FrameIdx < ConvertTestNumFrames; ++FrameIdx)
+	{
+		MakeConvertTestFrame(FrameIdx, Written[FrameIdx]);
+		JsonWriter.WriteFrame(Written[FrameIdx], Entities);
+	}
+
+	const FString JsonPath = FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("SLRawDataConvertTest"), TEXT(".json"));
+	const FString BinaryPath = FPaths::ChangeExtension(JsonPath, TEXT("bin"));
+	const FString FramedPath = BinaryPath + TEXT(".slf");
+	FSLRawDataEpisodeReader EpisodeReader;
+	if (!TestTrue(TEXT("The json episode is saved"), FFileHelper::SaveArrayToFile(JsonWriter.GetBuffer(), *JsonPath)) ||
+		!TestTrue(TEXT("The json episode is indexed"), EpisodeReader.Open(JsonPath, false)) ||
+		!TestTrue(TEXT("Every json frame is indexed"), EpisodeReader.NumFrames() == ConvertTestNumFrames))
+	{
+		IFileManager::Get().Delete(*JsonPath);
+		return false;
+	}
+
+	// Plain binary file
+	FSLRawDataBinaryReader BinaryReader;
+	if (TestTrue(TEXT("Converted to binary"), USLRawDataCommandlet::ConvertToBinary(EpisodeReader, BinaryPath, false)) &&
+		TestTrue(TEXT("The binary file is read"), BinaryReader.LoadFromFile(BinaryPath)))
+	{
+		TestConvertTestFrames(*this, TEXT("Binary"), BinaryReader, Written);
+	}
+
+	// Framed binary file, the binary header is the first record, every frame its own record
+	TArray<uint8> Framed;
+	if (TestTrue(TEXT("Converted to framed binary"), USLRawDataCommandlet::ConvertToBinary(EpisodeReader, FramedPath, true)) &&
+		TestTrue(TEXT("The framed file is loaded"), FFileHelper::LoadFileToArray(Framed, *FramedPath)) &&
+		TestTrue(TEXT("The framed file has a header"), FSLRawDataFramed::HasHeader(Framed.GetData(), Framed.Num())))
+	{
+		TArray<uint8> Unframed;
+		int32 NumRecords = 0;
+		int64 Offset = FSLRawDataFramed::HeaderSize;
+		int64 PayloadOffset = 0;
+		int32 PayloadSize = 0;
+		while (FSLRawDataFramed::ReadRecord(Framed.GetData(), Framed.Num(), Offset, PayloadOffset, PayloadSize))
+		{
+			Unframed.Append(Framed.GetData() + PayloadOffset, PayloadSize);
+			Offset = PayloadOffset + PayloadSize;
+			NumRecords++;
+		}
+		TestTrue(TEXT("All records are read"), Offset == Framed.Num() && NumRecords == ConvertTestNumFrames + 1);
+		if (TestTrue(TEXT("The framed records are read"), BinaryReader.LoadFromBuffer(Unframed)))
+		{
+			TestConvertTestFrames(*this, TEXT("Framed"), BinaryReader, Written);
+		}
+	}
+
+	EpisodeReader.Close();
+	IFileManager::Get().Delete(*JsonPath);
+	IFileManager::Get().Delete(*BinaryPath);
+	IFileManager::Get().Delete(*FramedPath);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
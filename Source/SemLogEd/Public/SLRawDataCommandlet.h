@@ -0,0 +1,32 @@
+// Copyright 2018, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SLRawDataCommandlet.generated.h"
+
+class FSLRawDataEpisodeReader;
+
+/**
+* Indexes (and optionally converts) raw data episodes using all cores, e.g.:
+*	UE4Editor-Cmd.exe <Project> -run=SLRawData -Input=<RawData_Id.json> [-Convert=Binary] [-Output=<Path>] [-Framed]
+* the frame index is written next to the input (<file>.idx) and used by FSLRawDataEpisodeReader;
+* with -Benchmark=<Name|All> the raw data writers are benchmarked instead (see FSLRawDataBenchmark)
+*/
+UCLASS()
+class USLRawDataCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	USLRawDataCommandlet();
+
+	/** UCommandlet interface */
+	virtual int32 Main(const FString& Params) override;
+
+	// Parse the json frames on all cores and write them in the binary format
+	static bool ConvertToBinary(const FSLRawDataEpisodeReader& Reader, const FString& OutPath, bool bFramed);
+};
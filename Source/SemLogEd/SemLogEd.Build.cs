@@ -47,6 +47,8 @@ public class SemLogEd : ModuleRules
 				"UnrealEd",
 				"LevelEditor",
 				"Projects",
+				"Json",
+				"libmongo"
 				// ... add private dependencies that you statically link with here ...
 			}
 			);